@@ -3,6 +3,8 @@
 #include "Config.h"
 #include "TextRenderer.h"
 #include <glm/glm.hpp>
+#include <cstdint>
+#include <random>
 #include <string>
 #include <vector>
 #include <GL/glew.h>
@@ -21,24 +23,41 @@ class AnimationManager {
 public:
     AnimationManager(Config& config, TextRenderer& textRenderer);
 
+    // The bounce directions come from the manager's own generator, seeded
+    // randomly unless this is called before reset(); a fixed seed makes the
+    // animation a pure function of time, as offline segment renders need.
+    void seed(uint64_t seed) { _rng.seed(static_cast<std::mt19937::result_type>(seed ^ (seed >> 32))); }
     void reset(const std::vector<std::string>& title_lines);
-    void update(double music_len, double current_time, const std::vector<std::string>& title_lines);
+    // The generator's state in text form, to check a replayed animation against a checkpoint.
+    std::string getRandomState() const;
+    void update(double music_len, double current_time);
 
-    std::vector<glm::vec2> getTitlePositions(const std::vector<std::string>& title_lines) const;
+    // One position per title line passed to reset(); updated in place every frame.
+    const std::vector<glm::vec2>& getTitlePositions() const;
+    // The title as one block: its position plus each line's fixed offset from it.
+    glm::vec2 getTitleBlockPosition() const { return _titleBlockPosition; }
+    const std::vector<glm::vec2>& getTitleLineOffsets() const { return _titleLineOffsets; }
     glm::vec2 getArtistPosition() const;
     float getAlpha() const;
     float getBreathingScale() const;
 
 private:
     void initializePositions(const std::vector<std::string>& title_lines);
-    void updateBouncing(float deltaTime, const std::vector<std::string>& title_lines);
+    void updateBouncing(float deltaTime);
     void updateReturning(float deltaTime);
+    void updateTitlePositions();
+    glm::vec2 randomVec2(float extent); // Uniform in [-extent, extent] on both axes.
 
     Config& _config;
     TextRenderer& _textRenderer;
 
     glm::vec2 _initialTitleBlockPosition;
     std::vector<glm::vec2> _titleLineOffsets;
+    std::vector<glm::vec2> _titlePositions;
+    // Text widths only change when the text or window does, which always goes through reset().
+    float _titleBlockWidth;
+    float _titleBlockHeight;
+    float _artistWidth;
     glm::vec2 _initialArtistPosition;
 
     glm::vec2 _titleBlockPosition;
@@ -50,4 +69,5 @@ private:
     float _alpha;
     float _breathingScale;
     AnimationState _currentState;
+    std::mt19937 _rng;
 };
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "SyntheticAudio.h"
+#include <projectM-4/projectM.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Pushes one video frame's worth of audio into projectM per call, from either a
+// synthetic signal or a decoded file that loops. Used by headless tools, which
+// have no playback device driving the audio callback.
+class AudioFeed {
+public:
+    // `source` is a SyntheticAudio signal name; when `pcm` is non-empty it is used instead.
+    AudioFeed(const std::string& source, const std::vector<int16_t>& pcm, int fps);
+
+    void feed(projectm_handle pM);
+
+private:
+    const std::vector<int16_t>& _pcm;
+    SyntheticAudio _synthetic;
+    size_t _position;
+    unsigned int _frames_per_video_frame;
+    std::vector<float> _buffer;
+};
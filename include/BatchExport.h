@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Config.h"
+#include "OfflineRenderer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class PresetManager;
+
+// Exports every track in config.audio_file_paths to its own video, each with
+// its own soundtrack, rendered offline by a pool of worker processes. Each
+// worker has its own headless GL context and projectM instance, so tracks
+// render side by side on all cores. With config.export_segments > 1, tracks
+// are exported one at a time instead, each split into time segments that the
+// workers render side by side and that are then joined without re-encoding.
+// Must run before SDL video or OpenGL is initialized in this process, since the
+// workers are forked from it.
+class BatchExport {
+public:
+    // Returns the process exit code: 0 when every track was exported.
+    static int run(const Config& config);
+
+    // The pieces below are shared with the render farm (see RenderFarm.h).
+
+    // Seed for a track's preset schedule: config.export_seed, or a hash of the file name.
+    static uint64_t track_seed(const Config& config, const std::string& track);
+    // config.checkpoint_seconds in video frames; 0 when checkpoints are off.
+    static int checkpoint_frames(const Config& config);
+    // Video-only jobs for `segments` consecutive time segments of a track of
+    // `track_samples` stereo samples (AudioInput::probe_length), writing
+    // "<output stem>.partNNN<ext>" next to `output_path`. Batch exports and the
+    // render farm both plan segments here, so a track splits the same either way.
+    static std::vector<OfflineJob> segment_jobs(const Config& config, const std::string& track, const std::string& output_path,
+                                                size_t track_samples, int segments);
+    // Renders one job in a worker process, writing PROGRESS and DONE lines to
+    // `output_fd`; returns the process exit code.
+    static int run_job(const Config& config, PresetManager& presets, const OfflineJob& job, int output_fd);
+    // Frames, audio seconds and render seconds from a job's DONE line.
+    static void parse_done(const std::string& output, int& frames, double& audio_seconds, double& render_seconds);
+    // "N frames in Xs: F fps, Yx real time"
+    static std::string throughput(int frames, double audio_seconds, double render_seconds);
+};
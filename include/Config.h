@@ -23,7 +23,24 @@ struct Config {
     // Display
     int width = 1024;
     int height = 640;
+    // Resolution projectM, the overlays and recordings render at; the window shows
+    // a scaled copy. 0 uses the window size at startup.
+    int render_width = 0;
+    int render_height = 0;
+    // Set at startup: with no render size given and no recording, the render size tracks window resizes.
+    bool render_follows_window = false;
     int fps = 30;
+    // Lower render scale and mesh size while frames miss their budget. Never while recording.
+    bool adaptive_quality = false;
+    // Chrome trace-event JSON of CPU spans, written on exit; empty disables tracing.
+    std::string trace_out_path;
+    // Frames before the zero-allocation check starts; 0 disables it. Needs AURORA_ALLOC_TRACKING.
+    int alloc_check_warmup_frames = 0;
+    // Serve Prometheus metrics on "[host:]port" (localhost by default) or "unix:/path"; empty disables it.
+    std::string metrics_listen;
+    // Performance HUD, toggled with hud_key; never part of recordings.
+    bool show_hud = false;
+    SDL_Keycode hud_key = SDLK_F3;
 
     // Font & Text
     std::string font_path = "/usr/share/fonts/TTF/DejaVuSans-Bold.ttf";
@@ -58,6 +75,7 @@ struct Config {
 
     // Presets
     std::string presetsDirectory = "presets/";
+    std::string preset_pack_file; // aurora-pack file; replaces presetsDirectory when set
     std::string favoritesFile = "favorites.txt";
     bool shuffleEnabled = true;
     double presetDuration = 15.0;
@@ -69,11 +87,32 @@ struct Config {
     SDL_Keycode mark_broken_preset_key = SDLK_b;
     SDL_Keycode favorite_preset_key = SDLK_f;
     bool use_default_projectm_visualizer = false;
+    float max_preset_complexity = 0.0f; // 0 disables metadata scanning and filtering
+    std::string preset_quarantine_file; // Written by aurora_triage
+    std::string preset_cost_report;     // Written by aurora_triage
+    float max_preset_frame_ms = 0.0f;   // 0 disables filtering by measured cost
 
     // Recording
     bool enable_recording = false;
     std::string video_directory = "videos";
     int video_framerate = 24;
+    // Export each audio file to its own video with offline render workers instead of playing them.
+    bool batch_export = false;
+    unsigned int export_jobs = 0; // Worker processes for batch exports; 0 uses one per core.
+    // Split each exported track into this many segments rendered side by side, then concatenated.
+    unsigned int export_segments = 1;
+    double segment_preroll_seconds = 10.0; // Rendered, not encoded, before each segment so projectM settles.
+    unsigned long long export_seed = 0;    // Seeds the offline preset schedule and animation; 0 derives it from the file name.
+    // Batch exports of whole tracks are written in closed chunks of this many seconds, with a
+    // checkpoint after each, so an interrupted export can be resumed; 0 writes one file.
+    double checkpoint_seconds = 0.0;
+    bool resume_export = false; // Continue checkpointed exports instead of starting them over.
+    // Render farm (see RenderFarm.h): coordinate the exports in a manifest, or work for a coordinator.
+    std::string farm_manifest;
+    std::string farm_listen = "127.0.0.1:7878";
+    std::string farm_connect;
+    unsigned int farm_max_attempts = 3;     // Times a job is handed out before its track fails.
+    double farm_heartbeat_timeout = 30.0;   // Seconds of silence before a worker is presumed dead.
     char ffmpeg_command[1024] = "ffmpeg -y -f rawvideo -pix_fmt rgb24 -s {WIDTH}x{HEIGHT} -r {FPS} -i - -i \"{AUDIO_FILE_PATH}\" -c:v libx265 -crf 28 -preset medium -c:a aac -b:a 192k \"{OUTPUT_PATH}\"";
 
     // Audio
@@ -6,7 +6,7 @@
 class ConfigLoader {
 public:
     static bool load(Config& config, const std::string& executable_path);
-
-private:
     static void load_from_file(Config& config, const std::string& path);
+    // Sets one option by its config file key. False if the key is unknown or the value does not parse.
+    static bool apply(Config& config, const std::string& key, const std::string& value);
 };
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Progress of a checkpointed offline export, saved next to its output as
+// "<output>.checkpoint" each time a chunk is closed. Everything a restart needs
+// to carry on where the last completed chunk ended, and to check that it is
+// resuming the same export: the settings that shape the video, the frame and
+// audio sample to continue from, and where the preset schedule and the text
+// animation's generator stand at that frame. Paths are stored canonical, so a
+// track named differently on the command line still finds its checkpoint.
+struct ExportCheckpoint {
+    std::string audio_path;
+    std::string output_path;
+    uint64_t encoder = 0;     // fnv1a_64 of the ffmpeg command the chunks were encoded with.
+    int width = 0;
+    int height = 0;
+    int fps = 0;
+    int frames = 0;           // The whole track.
+    int chunk_frames = 0;
+    double preset_duration = 0.0;
+    int completed_chunks = 0;
+    int next_frame = 0;
+    uint64_t audio_sample = 0; // Stereo sample frame that next_frame starts at.
+    uint64_t seed = 0;         // Preset schedule and animation seed.
+    uint64_t preset_slot = 0;  // Schedule slot playing at next_frame.
+    std::string animation_rng; // The animation generator's state before next_frame.
+
+    static std::string path_for(const std::string& output_path);
+    // Absolute, with symlinks and "." and ".." resolved as far as the path exists.
+    static std::string canonical_path(const std::string& path);
+    // "<output stem>.chunkNNN<ext>"
+    static std::string chunk_path(const std::string& output_path, int chunk);
+
+    // Written to a temporary file and renamed, so a crash never leaves half a checkpoint.
+    bool save() const;
+    static bool load(const std::string& path, ExportCheckpoint& checkpoint);
+    // The checkpoint in `directory` left by an export of `audio_path`, if any.
+    static bool find(const std::string& directory, const std::string& audio_path, ExportCheckpoint& checkpoint);
+
+    // Same track, output, encoder, size, frame rate, chunking, schedule and seed, so its chunks can be continued.
+    bool compatible_with(const ExportCheckpoint& other) const;
+    // Removes the checkpoint and its chunks once the final file is written.
+    void remove_files() const;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+// A glyph rendered as an 8-bit signed distance field: 128 is the outline,
+// larger values are inside. The bitmap includes `spread` pixels of padding on
+// every side, and the bearing accounts for it.
+struct GlyphBitmap {
+    int width = 0;
+    int height = 0;
+    int bearing_x = 0;
+    int bearing_y = 0;
+    unsigned int advance = 0; // 26.6 fixed point, like FT_GlyphSlot::advance.x
+    std::vector<unsigned char> pixels;
+};
+
+// Renders SDF glyphs at one fixed size; text at any other size scales the
+// result in the shader. Uses FreeType's SDF renderer where available (2.11+)
+// and a CPU distance transform of the coverage bitmap otherwise. Each instance
+// owns its FT_Library, so different threads can use separate instances.
+class GlyphRasterizer {
+public:
+    GlyphRasterizer();
+    ~GlyphRasterizer();
+    GlyphRasterizer(const GlyphRasterizer&) = delete;
+    GlyphRasterizer& operator=(const GlyphRasterizer&) = delete;
+
+    bool init(const std::string& font_path, int pixel_size, int spread);
+    void cleanup();
+    bool rasterize(uint32_t codepoint, GlyphBitmap& out);
+    // Only the horizontal advance (26.6); far cheaper than rasterize().
+    bool load_advance(uint32_t codepoint, unsigned int& advance);
+    // Horizontal kerning between two codepoints (26.6, whole pixels), 0 if the
+    // font has no kerning table or no pair for them.
+    int kerning(uint32_t left, uint32_t right);
+    bool has_kerning() const { return _face && FT_HAS_KERNING(_face); }
+
+    int pixel_size() const { return _pixel_size; }
+    int spread() const { return _spread; }
+
+private:
+    bool rasterize_with_distance_transform(GlyphBitmap& out);
+
+    FT_Library _ft;
+    FT_Face _face;
+    int _pixel_size;
+    int _spread;
+};
+
+// Rasterizes glyphs on a background thread with its own GlyphRasterizer, so the
+// render thread never waits on FreeType for glyphs it has not seen before.
+class AsyncGlyphRasterizer {
+public:
+    AsyncGlyphRasterizer() = default;
+    ~AsyncGlyphRasterizer();
+    AsyncGlyphRasterizer(const AsyncGlyphRasterizer&) = delete;
+    AsyncGlyphRasterizer& operator=(const AsyncGlyphRasterizer&) = delete;
+
+    bool start(const std::string& font_path, int pixel_size, int spread);
+    void stop();
+
+    void request(uint32_t codepoint);
+    // Moves every finished glyph into `out` without waiting. A glyph that could
+    // not be rasterized comes back with an empty bitmap.
+    void collect(std::vector<std::pair<uint32_t, GlyphBitmap>>& out);
+
+private:
+    void run();
+
+    GlyphRasterizer _rasterizer;
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::deque<uint32_t> _requests;
+    std::vector<std::pair<uint32_t, GlyphBitmap>> _results;
+    bool _stop = false;
+};
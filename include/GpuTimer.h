@@ -0,0 +1,55 @@
+#pragma once
+
+#include "utils/Histogram.h"
+#include <GL/glew.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Measures GPU time per render stage with GL_TIME_ELAPSED queries. Queries come
+// from a ring and are read back frames later, once the GPU has finished them,
+// so timing never makes the CPU wait for the GPU. If the ring is full a stage
+// simply goes unmeasured that frame. Stages must not nest or overlap.
+class GpuTimer {
+public:
+    struct Stage {
+        std::string name;
+        Histogram total;     // Every sample since init.
+        Histogram recent[2]; // Rolling window: the current half and the one before.
+        int active = 0;
+    };
+
+    GpuTimer();
+    ~GpuTimer();
+
+    // False if the context has no timer queries; the timer then does nothing.
+    bool init();
+    void cleanup();
+    bool enabled() const { return _enabled; }
+
+    size_t add_stage(const std::string& name);
+    void begin(size_t stage);
+    void end();
+    // Records every finished query; call once per frame.
+    void collect();
+
+    const std::vector<Stage>& stages() const { return _stages; }
+    // Roughly the last 2 * RECENT_SAMPLES samples of `stage`.
+    Histogram recent(size_t stage) const;
+    // One line per stage with its all-time summary.
+    std::string report() const;
+
+    static constexpr size_t RECENT_SAMPLES = 300;
+
+private:
+    void record(size_t stage, double ms);
+
+    std::vector<Stage> _stages;
+    std::vector<GLuint> _queries;    // The ring.
+    std::vector<size_t> _queryStage; // Stage measured by each query in flight.
+    size_t _head;                    // Next query to issue.
+    size_t _pending;                 // Queries issued but not yet read, oldest at _head - _pending.
+    bool _running;                   // Between begin() and end().
+    size_t _dropped;
+    bool _enabled;
+};
@@ -3,21 +3,56 @@
 #include "Config.h"
 #include "ImGuiIntegration.h"
 #include <SDL.h>
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
 
 class Core;
 
+// One frame's numbers for the performance HUD, filled in by Core.
+struct HudFrame {
+    static constexpr size_t MAX_STAGES = 12;
+
+    float frame_ms = 0.0f; // CPU work, excluding the pacing sleep.
+    const char* const* stage_names = nullptr;
+    float stage_ms[MAX_STAGES] = {};
+    size_t stage_count = 0;
+};
+
+// Performance HUD and preset search, drawn with ImGui on top of the window
+// after the render has been presented. Recordings read the render target
+// before that, so the HUD never appears in exports. While hidden it costs
+// nothing: no ImGui frame is started and no events are passed to it.
 class Gui {
 public:
     Gui(Config& config, Core& core);
     ~Gui();
 
     bool init(SDL_Window* window, SDL_GLContext context);
-    void render();
-    void handle_event(SDL_Event& event);
+    void render(const HudFrame& frame);
+    // True if ImGui wants the event for itself, e.g. while typing a search.
+    bool handle_event(SDL_Event& event);
     void cleanup();
 
+    bool visible() const { return _visible; }
+    void toggle() { _visible = !_visible; }
+
 private:
+    void render_performance(const HudFrame& frame);
+    void render_preset_search();
+
+    static constexpr size_t FRAME_HISTORY = 240;
+
     Config& _config;
     Core& _core;
     SDL_Window* _window;
-};
\ No newline at end of file
+    bool _initialized;
+    bool _visible;
+    std::array<float, FRAME_HISTORY> _frame_ms = {};
+    size_t _frame_index = 0; // Next slot in _frame_ms.
+    std::array<float, HudFrame::MAX_STAGES> _stage_ms = {}; // Smoothed so the numbers are readable.
+    char _search_query[128] = {};
+    std::vector<std::string> _search_results;
+    std::vector<std::string> _search_labels; // "<stem>##<path>" per result, built with them.
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <SDL.h>
+
+// An OpenGL 3.3 core context on a hidden window, for batch tools and workers that
+// render without showing anything. Falls back to SDL's offscreen video driver when
+// no display is available.
+class HeadlessContext {
+public:
+    HeadlessContext();
+    ~HeadlessContext();
+
+    bool init(int width, int height);
+    void cleanup();
+
+    SDL_Window* window() const { return _window; }
+    SDL_GLContext* context() { return &_context; }
+
+private:
+    bool create_window(int width, int height);
+
+    SDL_Window* _window;
+    SDL_GLContext _context;
+    bool _sdl_initialized;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Cumulative histogram with fixed bucket bounds, updated with relaxed atomics
+// so any thread can observe without locking.
+class AtomicHistogram {
+public:
+    AtomicHistogram(std::initializer_list<double> bounds);
+
+    void observe(double value);
+    // Appends the histogram in Prometheus text format.
+    void write(std::string& out, const char* name, const char* help) const;
+
+private:
+    std::vector<double> _bounds; // Upper bounds, ascending; +Inf is implicit.
+    std::unique_ptr<std::atomic<uint64_t>[]> _buckets;
+    std::atomic<uint64_t> _sum_us; // Sum in millionths, since C++17 has no atomic double add.
+};
+
+// Process-wide counters and gauges for long-running shows. Updated from the
+// render loop, the audio callback and the encoder with relaxed atomics; read by
+// the MetricsServer thread when scraped.
+struct Metrics {
+    // Frames
+    AtomicHistogram frame_seconds{0.004, 0.008, 0.0125, 0.0167, 0.025, 0.0333, 0.05, 0.1, 0.25};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> late_frames{0};    // Work took longer than the frame budget.
+    std::atomic<uint64_t> dropped_frames{0}; // Whole frame intervals missed because of late frames.
+
+    // Encoder
+    std::atomic<uint64_t> encoder_frames{0};
+    std::atomic<uint64_t> encoder_bytes{0};
+    std::atomic<uint64_t> encoder_queue_bytes{0}; // Written but not yet read by ffmpeg.
+    std::atomic<uint64_t> encoder_frame_bytes{0};
+    std::atomic<uint64_t> encoder_blocked_us{0};  // Time spent waiting on a full pipe.
+
+    // Audio
+    std::atomic<uint64_t> audio_callbacks{0};
+    std::atomic<uint64_t> audio_underruns{0};
+    std::atomic<int64_t> audio_last_callback_ns{0}; // steady_clock time of the latest callback.
+    std::atomic<int64_t> audio_buffer_ns{0};        // Playing time of one callback's buffer.
+
+    // Presets
+    std::atomic<int64_t> preset_index{-1}; // Position in the sorted preset list.
+    std::atomic<uint64_t> preset_loads{0};
+    std::atomic<uint64_t> preset_load_failures{0};
+    std::atomic<uint64_t> preset_last_load_us{0};
+    AtomicHistogram preset_load_seconds{0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0};
+
+    // GPU memory
+    std::atomic<uint64_t> gl_memory_estimate_bytes{0}; // Our own render targets and textures.
+    std::atomic<int64_t> gl_memory_available_kb{-1};   // From the driver, where it reports it.
+
+    static Metrics& get();
+    // Every metric in Prometheus text exposition format, plus process RSS.
+    std::string render() const;
+};
+
+// Serves Metrics::render() over HTTP from a background thread, on localhost TCP
+// ("9464" or "127.0.0.1:9464") or a Unix socket ("unix:/run/aurora.sock").
+class MetricsServer {
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    bool start(const std::string& listen);
+    void stop();
+
+private:
+    void run();
+    void serve(int client);
+
+    int _listen_fd;
+    std::string _socket_path; // Unlinked on stop when listening on a Unix socket.
+    std::atomic<bool> _running;
+    std::thread _thread;
+};
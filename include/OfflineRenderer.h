@@ -0,0 +1,110 @@
+#pragma once
+
+#include "AnimationManager.h"
+#include "Config.h"
+#include "HeadlessContext.h"
+#include "OverlayCompositor.h"
+#include "TextManager.h"
+#include "TextRenderer.h"
+#include "VideoExporter.h"
+#include "preset_manager.h"
+#include "renderer.h"
+#include <projectM-4/projectM.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct ExportCheckpoint;
+
+// One video to render: a whole track encoded together with its own audio, or
+// one segment of a track encoded as video only, to be concatenated with the
+// other segments afterwards (see BatchExport).
+struct OfflineJob {
+    std::string audio_path;
+    std::string output_path;
+    int first_frame = 0;
+    int end_frame = -1;          // One past the last frame to encode; -1 for the end of the track.
+    double preroll_seconds = 0;  // Rendered but not encoded before first_frame, so projectM's state has settled.
+    uint64_t seed = 0;           // Preset schedule and text animation; equal for every segment of a track.
+    bool encode_audio = true;
+    // Segments: the track's length in stereo samples, as the segments were planned
+    // from it, so every segment agrees on it. 0 to take it from the audio.
+    size_t track_samples = 0;
+    // Whole tracks only: encode in closed, video-only chunks of this many frames,
+    // saving an ExportCheckpoint after each, and join them at the end. 0 encodes one file.
+    int checkpoint_frames = 0;
+    bool resume = false; // Continue after the chunks a saved checkpoint lists, if it matches.
+};
+
+struct OfflineStats {
+    int frames = 0;
+    double audio_seconds = 0.0;
+    double seconds = 0.0; // Wall-clock time for the job, decoding and encoding included.
+};
+
+// Renders tracks to video without playing them. The audio is decoded up front
+// and handed to projectM one video frame's worth at a time, and projectM, the
+// preset shuffle and the text animation all run on video time, so a track
+// renders as fast as the GPU and encoder allow and matches its soundtrack
+// exactly. Needs no display or audio device; batch exports run one per worker
+// process (see BatchExport).
+//
+// Everything that would otherwise be random is derived from the job's seed:
+// presets follow PresetManager::get_scheduled_preset, the text animation has
+// its own seeded generator and is replayed from the start of the track, and
+// the C library generator projectM draws from is reseeded per segment (per
+// chunk for a checkpointed export, so a resumed one draws what it would have). A
+// segment therefore renders the same every time, and its presets and overlays
+// line up with those of its neighbours.
+class OfflineRenderer {
+public:
+    // Called every few frames with the frames done and the total.
+    using ProgressCallback = std::function<void(int frame, int frames)>;
+
+    // `presets` must already be loaded.
+    OfflineRenderer(const Config& config, PresetManager& presets);
+    ~OfflineRenderer();
+
+    bool init();
+    // Decodes the job's audio itself: all of it for a whole track, only the
+    // preroll and the frames to encode for a segment.
+    bool render(const OfflineJob& job, OfflineStats& stats, const ProgressCallback& progress = nullptr);
+    // Same, with the track already decoded (interleaved stereo at AudioInput::SAMPLE_RATE),
+    // e.g. once in a parent process for all of its segment workers.
+    bool render(const OfflineJob& job, const std::vector<int16_t>& pcm, OfflineStats& stats,
+                const ProgressCallback& progress = nullptr);
+    // Video frames covering `sample_frames` stereo samples.
+    static int frame_count(size_t sample_frames, int video_framerate);
+    void cleanup();
+
+private:
+    // `pcm` holds the track from stereo sample `pcm_first_sample` on, possibly not to its end;
+    // `track_samples` is the length of the whole track.
+    bool render_samples(const OfflineJob& job, const std::vector<int16_t>& pcm, size_t pcm_first_sample,
+                        size_t track_samples, OfflineStats& stats, const ProgressCallback& progress);
+    // Frames rendered but not encoded before `first_frame`.
+    int preroll_frames(const OfflineJob& job, int first_frame) const;
+    // Starts a fresh checkpoint, or picks up the saved one when resuming. False if it cannot be continued.
+    bool prepare_checkpoint(const OfflineJob& job, size_t sample_frames, ExportCheckpoint& checkpoint) const;
+    // The preset schedule slot playing at `frame`.
+    uint64_t preset_slot(int frame) const;
+    void feed_audio(const std::vector<int16_t>& pcm, size_t pcm_first_sample, size_t first_sample, size_t end_sample);
+    void draw_overlays(const std::vector<std::string>& title_lines);
+
+    Config _config; // A copy: rendering runs at the video frame rate.
+    PresetManager& _presets;
+    HeadlessContext _context;
+    Renderer _renderer;
+    TextRenderer _text_renderer;
+    TextManager _text_manager;
+    OverlayCompositor _overlay_compositor;
+    AnimationManager _animation_manager;
+    VideoExporter _video_exporter;
+    projectm_handle _pM;
+
+    std::vector<int16_t> _pcm; // The track, or a segment's part of it, when render() decodes it itself.
+    std::vector<float> _float_samples;
+    std::vector<unsigned char> _frame_buffer;
+    std::vector<unsigned char> _flipped_buffer;
+};
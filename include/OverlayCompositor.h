@@ -0,0 +1,71 @@
+#pragma once
+
+#include "TextRenderer.h"
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct OverlayTextStyle {
+    float scale = 1.0f;
+    glm::vec3 color = glm::vec3(1.0f);
+    bool show_border = true;
+    glm::vec3 border_color = glm::vec3(0.0f);
+    float border_thickness = 0.1f;
+
+    bool operator==(const OverlayTextStyle& other) const {
+        return scale == other.scale && color == other.color && show_border == other.show_border &&
+               border_color == other.border_color && border_thickness == other.border_thickness;
+    }
+    bool operator!=(const OverlayTextStyle& other) const { return !(*this == other); }
+};
+
+// Keeps each block of overlay text (title, artist, URL) pre-rendered in its own
+// premultiplied RGBA texture. Text is only rasterized again when a block's
+// lines or style change; every other frame draws one textured quad per block,
+// with position, scale and alpha as uniforms. Without framebuffer support the
+// blocks are drawn directly through the TextRenderer instead.
+class OverlayCompositor {
+public:
+    explicit OverlayCompositor(TextRenderer& textRenderer);
+    ~OverlayCompositor();
+
+    bool init();
+    void cleanup();
+    void setProjection(int width, int height);
+
+    // Sets the content of block `id`: `lines` placed at `offsets` from the block's origin.
+    void setBlock(size_t id, const std::vector<std::string>& lines, const std::vector<glm::vec2>& offsets,
+                  const OverlayTextStyle& style);
+    void setBlock(size_t id, const std::string& text, const OverlayTextStyle& style);
+    // Draws block `id` with its origin at (x, y), scaled about that origin.
+    void drawBlock(size_t id, float x, float y, float scale, float alpha);
+    // GPU memory held by the block textures.
+    size_t getTextureBytes() const;
+
+private:
+    struct Block {
+        std::vector<std::string> lines;
+        std::vector<glm::vec2> offsets;
+        OverlayTextStyle style;
+        GLuint fbo = 0;
+        GLuint texture = 0;
+        glm::ivec2 size = glm::ivec2(0);
+        glm::vec2 origin = glm::vec2(0.0f); // Texture's bottom-left corner relative to the block origin.
+        uint64_t atlas_generation = 0;      // Glyphs still on their way when rendered show up after a change.
+        bool dirty = true;
+    };
+
+    Block& block(size_t id);
+    bool renderBlock(Block& block);
+    void drawBlockDirect(const Block& block, float x, float y, float scale, float alpha);
+
+    TextRenderer& _textRenderer;
+    std::vector<Block> _blocks;
+    GLuint _shaderProgram;
+    GLuint _vao, _vbo;
+    GLint _projectionLoc, _rectLoc, _alphaLoc;
+    int _width, _height;
+    bool _initialized;
+};
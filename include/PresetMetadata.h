@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Static information read from a .milk file's header without rendering it.
+struct PresetInfo {
+    bool parsed = false;
+    float rating = 3.0f;
+    bool has_warp_shader = false;
+    bool has_comp_shader = false;
+    int shader_lines = 0;
+    int per_frame_equations = 0;
+    int per_pixel_equations = 0;
+    int per_point_equations = 0;
+    int custom_waves = 0;
+    int custom_shapes = 0;
+    int shape_instances = 0;
+    // Relative cost estimate; 1.0 is a bare preset with no equations or shaders.
+    float complexity = 0.0f;
+};
+
+class PresetMetadata {
+public:
+    static PresetInfo parse_data(const char* data, size_t size);
+    static PresetInfo parse_file(const std::string& path);
+
+    // Parses every file on a pool of worker threads. The result is index-aligned with `paths`.
+    // A thread_count of 0 uses std::thread::hardware_concurrency().
+    static std::vector<PresetInfo> parse_all(const std::vector<std::string>& paths, unsigned int thread_count = 0);
+    // Same, for presets that do not live in individual files; `parse_one` must be thread-safe.
+    static std::vector<PresetInfo> parse_all(size_t count, const std::function<PresetInfo(size_t)>& parse_one,
+                                             unsigned int thread_count = 0);
+
+    static float estimate_complexity(const PresetInfo& info);
+};
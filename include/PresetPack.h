@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// aurora-pack: many .milk presets in one memory-mapped file.
+//
+// Layout (all integers little-endian):
+//   PackHeader
+//   PackEntry[entry_count]   sorted by name, so lookups binary search
+//   names                    concatenated entry names, not NUL-terminated
+//   data                     concatenated preset contents, zlib-compressed when
+//                            PACK_FLAG_COMPRESSED is set; identical contents are
+//                            stored once and shared by every entry with that hash
+struct PackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+    uint64_t index_offset;
+    uint64_t names_offset;
+    uint64_t data_offset;
+};
+
+struct PackEntry {
+    uint64_t hash;        // fnv1a_64 of the uncompressed contents
+    uint64_t offset;      // absolute file offset of the stored bytes
+    uint32_t stored_size;
+    uint32_t raw_size;
+    uint32_t name_offset; // relative to names_offset
+    uint16_t name_length;
+    uint16_t flags;
+};
+
+enum PackFlags : uint16_t {
+    PACK_FLAG_COMPRESSED = 1 << 0
+};
+
+struct PackSource {
+    std::string name;
+    std::string data;
+};
+
+class PresetPack {
+public:
+    static constexpr char MAGIC[8] = {'A', 'U', 'R', 'P', 'A', 'C', 'K', '\0'};
+    static constexpr uint32_t VERSION = 1;
+
+    PresetPack();
+    ~PresetPack();
+    PresetPack(const PresetPack&) = delete;
+    PresetPack& operator=(const PresetPack&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return _mapping != nullptr; }
+
+    size_t size() const { return _entry_count; }
+    std::string_view name_at(size_t index) const;
+    uint64_t hash_at(size_t index) const;
+    // Returns the entry index, or -1 if the pack has no preset with that name.
+    long find(std::string_view name) const;
+    // Decompresses if needed. Safe to call from several threads at once.
+    bool read(size_t index, std::string& out) const;
+
+    // Writes `sources` as a new pack, sorting by name and storing duplicate contents once.
+    static bool write(const std::string& path, std::vector<PackSource> sources, bool compress);
+
+private:
+    const PackEntry& entry(size_t index) const;
+
+    void* _mapping;
+    size_t _mapping_size;
+    size_t _entry_count;
+    const PackEntry* _entries;
+    const char* _names;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct ProcessJobResult {
+    size_t job = 0;
+    int exit_code = -1;     // Child's exit status, or -1 if it died from a signal.
+    int signal = 0;         // Terminating signal, 0 if the child exited normally.
+    bool timed_out = false; // Killed for producing no output within the idle timeout.
+    bool cancelled = false; // Killed, or never started, because the run was cancelled.
+    double seconds = 0.0;
+    std::string output;     // Everything the child wrote to its output fd.
+};
+
+// Runs jobs in forked worker processes, at most `workers` at a time. Each job gets a
+// fresh process, so a crash, leak or GL context problem in one job cannot affect the
+// others. Fork before initializing SDL or OpenGL in the parent.
+class ProcessPool {
+public:
+    using JobFunction = std::function<int(size_t job, int output_fd)>;
+    using DoneCallback = std::function<void(const ProcessJobResult&)>;
+    using CancelCallback = std::function<bool()>;
+
+    // A `workers` of 0 uses one per core. `idle_timeout_seconds` > 0 kills a child
+    // that writes nothing for that long. `cancel` is polled a few times a second;
+    // once it returns true every running child is killed and no more are started.
+    // Results are returned in job order.
+    static std::vector<ProcessJobResult> run(size_t job_count, unsigned int workers, const JobFunction& job_fn,
+                                             const DoneCallback& on_done = nullptr, double idle_timeout_seconds = 0.0,
+                                             const CancelCallback& cancel = nullptr);
+
+    // write() that retries on EINTR and short writes; for use by job functions.
+    static bool write_all(int fd, const std::string& data);
+};
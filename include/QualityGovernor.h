@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+struct QualityLevel {
+    float render_scale; // Fraction of the render resolution projectM draws at.
+    int mesh_width;     // projectM per-vertex mesh.
+    int mesh_height;
+};
+
+// Trades image quality for frame rate on machines that cannot keep up. Frame
+// times are averaged over windows of about a second; a window over budget
+// steps one level down, and a run of windows well under budget steps one level
+// back up. A level that had to be left again shortly after reaching it needs
+// twice as long a run next time, so the governor settles instead of bouncing
+// between two levels. Disabled, it stays at full quality.
+class QualityGovernor {
+public:
+    QualityGovernor();
+
+    void configure(bool enabled, int fps);
+    // Records how long one frame took; true if the quality level changed.
+    bool add_frame(double frame_ms);
+
+    const QualityLevel& level() const;
+    size_t level_index() const { return _level; }
+    bool enabled() const { return _enabled; }
+
+private:
+    void change_level(size_t level);
+
+    bool _enabled;
+    double _budget_ms;
+    int _window_frames;
+    int _frames;
+    double _total_ms;
+    size_t _level;
+    int _good_windows;       // Consecutive windows comfortably under budget.
+    int _required_good;      // Good windows needed before stepping up.
+    int _windows_at_level;   // Windows since the last change.
+    int _cooldown;           // Windows ignored after a change while projectM settles.
+    bool _stepped_up;        // The last change raised quality.
+};
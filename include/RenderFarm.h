@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Config.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+// A render farm manifest: the tracks to export, where to write them, and
+// config overrides for all of them or for one track. The format is the config
+// file's "key = value", with a "[[track]]" line starting each track. Only
+// render settings and the segmenting options may be overridden:
+//
+//     video_framerate = 60          # overrides for every track
+//     [[track]]
+//     audio = "/music/mix.flac"
+//     output = "/renders/mix.mp4"   # optional; named like a recording otherwise
+//     segments = 8                  # optional; export_segments otherwise
+//     export_seed = 42              # overrides for this track only
+struct RenderManifest {
+    using Overrides = std::vector<std::pair<std::string, std::string>>;
+
+    struct Track {
+        std::string audio_path;
+        std::string output_path;
+        unsigned int segments = 0;
+        Overrides overrides;
+    };
+
+    Overrides overrides;
+    std::vector<Track> tracks;
+
+    // Also checks every override against the config keys.
+    static bool load(const std::string& path, RenderManifest& manifest);
+};
+
+// Farms offline exports out to `aurora --render-worker` processes, on this
+// machine or others, over a line-based TCP protocol:
+//
+//     worker -> coordinator   HELLO <name> | HEARTBEAT | RESULT <job> <exit code> <frames> <audio s> <render s>
+//     coordinator -> worker   JOB <job> <key=value>... | BYE
+//
+// Fields are tab-separated. Workers heartbeat while they render; a worker that
+// goes quiet for farm_heartbeat_timeout seconds or disconnects has its job
+// handed to another worker, up to farm_max_attempts times. A worker whose
+// coordinator hangs up kills the render in progress, and a render holds a lock
+// on <output>.lock so a retry waits for one that is still running instead of
+// writing beside it (giving up with exit code 4 after the render idle timeout).
+// Each track is one job, or one job per segment (see BatchExport), and the
+// coordinator joins the segments once all of them are in. Audio paths are
+// used as given, so workers on other machines need the audio and presets at
+// the same paths.
+// Outputs must lie inside the coordinator's output directory; they are sent
+// relative to it and written inside each worker's own output directory, e.g.
+// the same shared mount. Manifests may override render settings only: paths,
+// ffmpeg_command and the like come from each worker's own command line.
+class RenderCoordinator {
+public:
+    // Serves config.farm_manifest on config.farm_listen until every job has
+    // finished or failed. Returns the process exit code: 0 when every track was exported.
+    static int run(const Config& config);
+};
+
+class RenderWorker {
+public:
+    // Connects config.export_jobs workers (0: one per core) to config.farm_connect
+    // and renders jobs until the coordinator says BYE. Must run before SDL or
+    // OpenGL is initialized in this process, like BatchExport.
+    static int run(const Config& config);
+};
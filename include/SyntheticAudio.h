@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class SyntheticSignal {
+    SineSweep,
+    PinkNoise,
+    KickPattern,
+    Mix
+};
+
+// Deterministic test audio for headless runs: the same signal and seed always
+// produce the same samples, so renders and benchmarks are reproducible.
+class SyntheticAudio {
+public:
+    static constexpr int SAMPLE_RATE = 44100;
+
+    explicit SyntheticAudio(SyntheticSignal signal = SyntheticSignal::Mix, uint32_t seed = 1);
+
+    // Writes `frames` interleaved stereo samples in [-1, 1].
+    void generate(float* stereo_out, size_t frames);
+
+    static bool parse_signal(const std::string& name, SyntheticSignal& signal);
+
+private:
+    float next_sweep();
+    float next_pink();
+    float next_kick();
+
+    SyntheticSignal _signal;
+    uint64_t _sample_index;
+    uint32_t _rng_state;
+    double _sweep_phase;
+    double _kick_phase;
+    float _pink[7];
+};
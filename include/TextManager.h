@@ -1,17 +1,30 @@
 #pragma once
 
 #include "TextRenderer.h"
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class TextManager {
 public:
     TextManager(TextRenderer& textRenderer);
 
+    // Greedy word wrap to half the window width. Words wider than a line are
+    // broken between codepoints. Results are cached per text, width and scale.
     std::vector<std::string> split_text(const std::string& text, int window_width, float scale);
 
 private:
     std::string sanitize_text(const std::string& text);
+    std::vector<std::string> break_lines(const std::string& text, float max_width, float scale);
 
     TextRenderer& _textRenderer;
+    std::unordered_map<std::string, std::vector<std::string>> _lineCache;
+
+    // Scratch for break_lines, indexed by codepoint.
+    std::vector<uint32_t> _codepoints;
+    std::vector<size_t> _offsets;   // Byte offset of each codepoint, plus the text length.
+    std::vector<float> _kerning;    // Kerning between codepoint i - 1 and i.
+    std::vector<float> _pen;        // Pen position before codepoint i, including its kerning.
+    std::vector<size_t> _spaces;    // Indices of the spaces between words.
 };
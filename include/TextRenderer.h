@@ -1,18 +1,38 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
-#include <map>
 #include <glm/glm.hpp>
-#include <ft2build.h>
-#include FT_FREETYPE_H
 #include <GL/glew.h>
+#include "GlyphRasterizer.h"
 
+// Glyph metrics are in pixels at the atlas's base size and include the SDF padding.
 struct Character {
-    unsigned int textureID;
+    glm::vec4    uv;      // u0, v0, u1, v1 of the glyph's cell in the atlas
     glm::ivec2   size;
     glm::ivec2   bearing;
     unsigned int advance;
+    int          cell = -1;      // Atlas cell, or -1 while the glyph has no pixels there
+    bool         ready = false;  // Rasterized; until then it takes up space but is not drawn
+    uint64_t     last_used = 0;  // Frame serial of the last frame that used it
+};
+
+// The glyph quads of one string, built once and kept in a GPU buffer. Positions
+// are relative to the start of the baseline at scale 1; drawing only sets a
+// translate/scale uniform. Owned and rebuilt by TextRenderer when the atlas
+// changes under it.
+struct TextLayout {
+    GLuint vbo = 0;
+    GLsizei vertex_count = 0;
+    float width = 0.0f;                  // Sum of advances.
+    glm::vec4 bounds = glm::vec4(0.0f);  // x, y, w, h of the inked area, without SDF padding.
+    std::vector<uint32_t> codepoints;    // Non-ASCII glyphs, marked as used on every draw.
+    uint64_t atlas_generation = 0;
+    uint64_t last_used = 0;
 };
 
 class TextRenderer {
@@ -21,25 +41,74 @@ public:
     ~TextRenderer();
 
     bool init(const std::string& fontPath, int fontSize);
+    // Call once at the start of every frame, before any text is measured or drawn.
+    // Glyphs used since then are pinned in the atlas until the next call.
+    void beginFrame() { _drawSerial++; }
     void setProjection(int width, int height);
     void cleanup();
-    void renderText(const std::string& text, float x, float y, float scale, 
-                    const glm::vec3& color, float alpha = 1.0f, 
-                    bool show_border = true, const glm::vec3& border_color = glm::vec3(0.0f), 
+    // `text` is UTF-8.
+    void renderText(const std::string& text, float x, float y, float scale,
+                    const glm::vec3& color, float alpha = 1.0f,
+                    bool show_border = true, const glm::vec3& border_color = glm::vec3(0.0f),
                     float border_thickness = 0.1f);
+    // Cached layout for `text`; stays valid until the next TextRenderer call.
+    const TextLayout& getLayout(const std::string& text);
+    void renderLayout(const TextLayout& layout, float x, float y, float scale,
+                      const glm::vec3& color, float alpha = 1.0f,
+                      bool show_border = true, const glm::vec3& border_color = glm::vec3(0.0f),
+                      float border_thickness = 0.1f);
     float getTextWidth(const std::string& text, float scale);
+    // Building blocks for line breaking: the pen advance of one glyph and the
+    // kerning adjustment between two neighbours, in pixels at `scale`.
+    float getAdvance(uint32_t codepoint, float scale);
+    float getKerning(uint32_t left, uint32_t right, float scale);
     glm::vec4 getTextBounds(const std::string& text, float x, float y, float scale);
+    // Padding around each glyph's inked area that the border can draw into, in pixels at `scale`.
+    float getGlyphPadding(float scale) const;
+    // Changes whenever glyphs appear in or leave the atlas, so text drawn before may now look different.
+    uint64_t getAtlasGeneration() const { return _atlasGeneration; }
+    // Blends so that drawing into a cleared RGBA target leaves premultiplied alpha.
+    void setPremultipliedTarget(bool enabled) { _premultipliedTarget = enabled; }
     bool is_initialized() const { return _initialized; }
+    // GPU memory held by the glyph atlas.
+    size_t getTextureBytes() const;
 
 private:
     bool initShaders();
-    void renderTextPass(const std::string& text, float x, float y, float scale, const glm::vec3& color, float alpha, const glm::vec3& border_color, float border_thickness);
+    bool buildAtlas();
+    // ASCII comes from a flat table; anything else is looked up and, the first
+    // time, queued for rasterization on the glyph worker.
+    Character& glyph(uint32_t codepoint);
+    void uploadFinishedGlyphs();
+    // Pins the non-ASCII glyphs of `text` for this frame.
+    void markGlyphsUsed(const std::string& text);
+    void markGlyphsUsed(const std::vector<uint32_t>& codepoints);
+    int allocateCell();
+    void uploadGlyph(Character& ch, const GlyphBitmap& bitmap, int cell);
+    void buildLayout(const std::string& text, TextLayout& layout);
+    void evictLayouts();
 
     GLuint _shaderProgram;
-    GLuint _vao, _vbo;
-    FT_Library _ft;
-    FT_Face _face;
-    std::map<char, Character> _characters;
+    GLuint _vao; // Shared; pointed at each layout's buffer when drawing it.
+    GLuint _atlasTexture;
+    std::vector<float> _vertices; // Scratch for layout builds; six vec4 vertices per glyph.
+    GLint _projectionLoc, _transformLoc, _textColorLoc, _alphaLoc, _borderColorLoc, _borderThicknessLoc;
+    GlyphRasterizer _rasterizer;            // Render thread: ASCII at startup and advances.
+    AsyncGlyphRasterizer _asyncRasterizer;  // Everything else.
+    float _fontScale; // Requested font size / SDF base size.
+    std::array<Character, 128> _ascii;      // Pinned in the atlas, never evicted.
+    std::unordered_map<uint32_t, Character> _glyphs;
+    std::vector<uint32_t> _cellOwners;      // Codepoint in each atlas cell, FREE_CELL if none.
+    std::vector<int> _freeCells;
+    std::vector<std::pair<uint32_t, GlyphBitmap>> _finishedGlyphs; // Includes any waiting for a free cell.
+    uint64_t _atlasFullSerial; // Frame in which no cell could be freed; uploads wait for the next one.
+    std::vector<unsigned char> _cellPixels; // Staging buffer for one cell upload.
+    std::unordered_map<std::string, TextLayout> _layouts;
+    std::unordered_map<uint64_t, int> _kerningPairs; // (left << 32 | right) -> 26.6 kerning
+    bool _hasKerning;
+    uint64_t _atlasGeneration;  // Bumped whenever glyph UVs or sizes change.
+    uint64_t _drawSerial; // Frame serial, bumped by beginFrame().
     int _width, _height;
+    bool _premultipliedTarget;
     bool _initialized;
 };
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <cstdio>
+#include <vector>
 #include "Config.h"
 
 class VideoExporter {
@@ -9,9 +10,18 @@ public:
     VideoExporter(const Config& config);
     ~VideoExporter();
 
+    // Records to a timestamped file named after the first audio file, with that file as the soundtrack.
     bool start_export(int width, int height);
+    bool start_export(int width, int height, const std::string& audio_path, const std::string& output_path);
     void write_frame(const unsigned char* pixels);
-    void end_export();
+    // False if ffmpeg failed or no export was running.
+    bool end_export();
+
+    // "<video_directory>/<audio file name>_<timestamp>.mp4"
+    std::string output_path_for(const std::string& audio_path) const;
+    // Joins video-only parts encoded with the same settings, without re-encoding
+    // them, and adds `audio_path` as the soundtrack.
+    static bool concatenate(const std::vector<std::string>& parts, const std::string& audio_path, const std::string& output_path);
 
 private:
     const Config& _config;
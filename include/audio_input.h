@@ -2,14 +2,21 @@
 
 #include "Config.h"
 #include <SDL_mixer.h>
+#include <chrono>
 #include <projectM-4/projectM.h>
+#include <string>
+#include <vector>
 
 struct AudioData {
     projectm_handle pM;
+    std::vector<float> float_samples; // Reused by every callback; only the audio thread touches it.
+    std::chrono::steady_clock::time_point last_callback; // For spotting underruns; audio thread only.
 };
 
 class AudioInput {
 public:
+    static constexpr int SAMPLE_RATE = 44100;
+
     AudioInput(Config& config);
     ~AudioInput();
 
@@ -21,6 +28,18 @@ public:
     void set_projectm_handle(projectm_handle pM);
 
     static void audio_callback(void* userdata, Uint8* stream, int len);
+    // Scales 16-bit samples to [-1, 1) floats, as fed to projectM.
+    static void pcm_to_float(const int16_t* pcm, float* out, size_t count);
+
+    // Decodes a whole file to interleaved 16-bit stereo at 44.1 kHz without playing it.
+    // Opens the mixer on SDL's dummy audio driver if it is not open yet.
+    static bool decode_file(const std::string& path, std::vector<int16_t>& pcm);
+    // Length in stereo samples, from the header for formats that store the exact count
+    // (WAV, FLAC, Ogg), otherwise by decoding the file.
+    static bool probe_length(const std::string& path, size_t& sample_frames);
+    // Decodes `sample_count` stereo samples starting at `first_sample`, fewer at the end of the
+    // file, without decoding what comes before. Falls back to decode_file when ffmpeg is missing.
+    static bool decode_range(const std::string& path, size_t first_sample, size_t sample_count, std::vector<int16_t>& pcm);
 
 private:
     Config& _config;
@@ -8,12 +8,18 @@
 #include "AnimationManager.h"
 #include "TextRenderer.h"
 #include "TextManager.h"
+#include "OverlayCompositor.h"
+#include "QualityGovernor.h"
+#include "GpuTimer.h"
+#include "Metrics.h"
 #include "Gui.h"
 #include "VideoExporter.h"
 
 #include <SDL.h>
 #include <projectM-4/projectM.h>
 #include <memory>
+#include <string>
+#include <vector>
 
 class Core {
 public:
@@ -24,8 +30,17 @@ public:
     void run();
     void cleanup();
     Renderer& get_renderer() { return _renderer; }
+    PresetManager& get_preset_manager() { return _preset_manager; }
+    const GpuTimer& get_gpu_timer() const { return _gpu_timer; }
+    // Switches to `preset` at the start of the next frame; for the GUI and other controls.
+    void request_preset(const std::string& preset) { _requested_preset = preset; }
 
 private:
+    // Sizes the render FBO for the governor's current render scale.
+    void apply_render_scale();
+    // Publishes GPU memory gauges; asking the driver stalls, so only when `query_driver`.
+    void update_gl_memory_metrics(bool query_driver);
+
     Config& _config;
     SDL_Window* _window;
     SDL_GLContext _context;
@@ -36,9 +51,17 @@ private:
     PresetManager _preset_manager;
     TextRenderer _text_renderer;
     TextManager _text_manager;
+    OverlayCompositor _overlay_compositor;
     AnimationManager _animation_manager;
     VideoExporter _video_exporter;
+    QualityGovernor _quality_governor;
+    GpuTimer _gpu_timer;
+    MetricsServer _metrics_server;
     std::unique_ptr<Gui> _gui;
+    std::string _requested_preset;
+    // Recording readback buffers, kept across frames so steady-state frames do not allocate.
+    std::vector<unsigned char> _frame_buffer;
+    std::vector<unsigned char> _flipped_buffer;
 
     bool g_quit;
 };
@@ -1,7 +1,14 @@
 #pragma once
 
 #include "Config.h"
+#include "PresetMetadata.h"
+#include "PresetPack.h"
+#include "PresetSearchIndex.h"
+#include <projectM-4/projectM.h>
+#include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class PresetManager {
@@ -12,19 +19,50 @@ public:
     std::string get_next_preset();
     std::string get_prev_preset();
     std::string get_current_preset() const;
+    // The preset for time slot `slot` of a schedule identified by `seed`: a pure
+    // function of both, so any process can tell which preset plays at any time
+    // without replaying the shuffle. Adjacent slots never play the same preset.
+    std::string get_scheduled_preset(uint64_t seed, uint64_t slot) const;
+    // Fuzzy name search over every loaded preset except quarantined ones, best match first.
+    std::vector<std::string> search_presets(const std::string& query, size_t max_results = 20);
+    // Makes `preset` the current preset, as if next/prev had reached it. Returns "" if unknown.
+    std::string jump_to_preset(const std::string& preset);
+    // Loads a preset returned by this manager, from the preset pack or from disk.
+    bool load_preset(projectm_handle pM, const std::string& preset, bool smooth_transition);
+    // Reads a preset's raw .milk contents, from the pack or from disk.
+    bool read_preset_data(const std::string& preset, std::string& data) const;
 
     void mark_current_preset_as_broken();
     void toggle_favorite_current_preset();
 
+    // Returns nullptr when metadata scanning is disabled or the preset is unknown.
+    const PresetInfo* get_preset_info(const std::string& preset) const;
+    const std::vector<std::string>& get_all_presets() const { return _all_presets; }
 
 private:
     void load_favorites();
     void save_favorites();
     std::string get_random_preset(const std::vector<std::string>& preset_list);
+    void push_history(const std::string& preset);
+    void scan_preset_metadata();
+    void load_quarantine();
+    void load_cost_report();
+    void rebuild_playable_presets();
+    void remove_preset(const std::string& preset);
+    // Drops a preset from every list and from history, keeping the history position valid.
+    void forget_preset(const std::string& preset);
 
 
     const Config& _config;
-    std::vector<std::string> _all_presets;
+    PresetPack _pack;
+    std::string _preset_data; // Reused buffer for presets read from the pack.
+    std::vector<std::string> _all_presets; // Sorted so lookups can binary search.
+    std::vector<PresetInfo> _preset_info;  // Index-aligned with _all_presets when scanned.
+    std::vector<std::string> _playable_presets;
+    PresetSearchIndex _search_index; // Built on first search over _all_presets.
+    bool _search_index_dirty = true;
+    std::unordered_set<std::string> _quarantined_presets;             // From aurora_triage
+    std::unordered_map<std::string, float> _measured_frame_ms;        // From aurora_triage
     std::vector<std::string> _favorite_presets;
     std::vector<std::string> _history;
     int _current_preset_index = -1;
@@ -6,6 +6,7 @@
 #include <SDL.h>
 #include <projectM-4/projectM.h>
 #include <GL/glew.h>
+#include <vector>
 
 class Renderer {
 public:
@@ -13,11 +14,24 @@ public:
     ~Renderer();
 
     bool init(SDL_Window* window, SDL_GLContext* context, Config& config);
+    // Renders projectM into the FBO at the render size and leaves the FBO bound,
+    // so overlays drawn afterwards land in the same image.
     void render(projectm_handle pM);
+    // Scales the FBO into the window, letterboxed to keep its aspect ratio.
+    void present(int window_width, int window_height);
+    // The FBO as tightly packed RGB rows, bottom row first.
+    void read_pixels(std::vector<unsigned char>& rgb);
+    // Reallocates the FBO; a no-op if the size is unchanged.
+    bool resize(int width, int height);
     void cleanup();
 
     bool create_fbo(int width, int height);
     GLuint get_fbo_texture() const { return _fbo_texture; }
+    GLuint get_fbo() const { return _fbo; }
+    int get_width() const { return _width; }
+    int get_height() const { return _height; }
+    // GPU memory held by the render target: color plus depth/stencil, assuming 4 bytes per texel each.
+    size_t get_gpu_bytes() const { return static_cast<size_t>(_width) * _height * 8; }
 
 private:
     void render_to_fbo(projectm_handle pM);
@@ -27,4 +41,5 @@ private:
     GLuint _fbo;
     GLuint _fbo_texture;
     GLuint _rbo;
+    int _width, _height;
 };
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// What the current thread is doing, for attributing heap allocations. Every
+// phase except Other and ProjectM belongs to the per-frame path we own, and is
+// what the steady-state check watches.
+enum class AllocPhase : uint8_t {
+    Other,    // Outside any instrumented code: startup, loading, helper threads.
+    Events,
+    Animation,
+    Render,
+    ProjectM, // Inside projectM; reported but not checked, since we cannot fix it.
+    Overlay,
+    Readback,
+    Encode,
+    Present,
+    Audio,    // The audio callback, on SDL's audio thread.
+    Count
+};
+
+// Counts heap allocations per thread and per phase by replacing the global
+// operator new. Only compiled in with -DAURORA_ALLOC_TRACKING=ON; otherwise
+// enabled() is false, ALLOC_PHASE expands to nothing and nothing is counted.
+// Allocations made with malloc directly (C libraries, GL drivers) are not seen.
+class AllocTracker {
+public:
+    static bool enabled();
+
+    static AllocPhase phase();
+    static void set_phase(AllocPhase phase);
+    // Names the calling thread in the report; `name` must be a string literal.
+    static void set_thread_name(const char* name);
+
+    // Called from operator new; must not allocate.
+    static void record(size_t bytes);
+
+    // Counts a finished frame, for per-frame averages.
+    static void end_frame();
+    // From now on every allocation in a checked phase is a violation.
+    static void arm_check();
+    static bool check_armed();
+    static uint64_t violations();
+
+    // One line per thread and phase that allocated, plus the check result if armed.
+    static std::string report();
+};
+
+class AllocPhaseScope {
+public:
+    explicit AllocPhaseScope(AllocPhase phase) : _previous(AllocTracker::phase()) { AllocTracker::set_phase(phase); }
+    ~AllocPhaseScope() { AllocTracker::set_phase(_previous); }
+    AllocPhaseScope(const AllocPhaseScope&) = delete;
+    AllocPhaseScope& operator=(const AllocPhaseScope&) = delete;
+
+private:
+    AllocPhase _previous;
+};
+
+#ifdef AURORA_ALLOC_TRACKING
+#define ALLOC_CONCAT_INNER(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_INNER(a, b)
+// Attributes allocations to `phase` from here to the end of the enclosing block.
+#define ALLOC_PHASE(phase) AllocPhaseScope ALLOC_CONCAT(alloc_phase_, __LINE__)(AllocPhase::phase)
+#else
+#define ALLOC_PHASE(phase) ((void)0)
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Fixed-size histogram of durations in milliseconds with log-spaced buckets:
+// eight per doubling from 1 us to about 16 s, so percentiles are accurate to
+// within ~5% at any scale. Adding a sample never allocates.
+class Histogram {
+public:
+    Histogram();
+
+    void add(double value_ms);
+    void merge(const Histogram& other);
+    void reset();
+
+    uint64_t count() const { return _count; }
+    double mean() const { return _count ? _sum / _count : 0.0; }
+    double min() const { return _count ? _min : 0.0; }
+    double max() const { return _count ? _max : 0.0; }
+    // p in [0, 1]; 0 when empty.
+    double percentile(double p) const;
+    // "n=... mean=... p50=... p95=... p99=... max=..." in milliseconds.
+    std::string summary() const;
+
+    static constexpr int BUCKETS_PER_DOUBLING = 8;
+    static constexpr int BUCKET_COUNT = 24 * BUCKETS_PER_DOUBLING + 1;
+
+private:
+    std::array<uint64_t, BUCKET_COUNT> _buckets;
+    uint64_t _count;
+    double _sum;
+    double _min;
+    double _max;
+};
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
-#include <iostream>
-#include <mutex>
+#include <string_view>
+#include <type_traits>
 
 enum class LogLevel {
     DEBUG,
@@ -11,50 +15,111 @@ enum class LogLevel {
     ERROR
 };
 
+// Messages below this level compile to nothing: 0 keeps everything, 3 keeps only errors.
+#ifndef AURORA_LOG_MIN_LEVEL
+#define AURORA_LOG_MIN_LEVEL 0
+#endif
+
+// One formatted message, built on the caller's stack.
+struct LogMessage {
+    static constexpr size_t CAPACITY = 1000;
+
+    LogLevel level;
+    uint16_t length = 0;
+    char text[CAPACITY];
+
+    explicit LogMessage(LogLevel message_level) : level(message_level) {}
+
+    void append(std::string_view value);
+    void append(const char* value) { append(value ? std::string_view(value) : std::string_view("(null)")); }
+    void append(const std::string& value) { append(std::string_view(value)); }
+    void append(char value) { append(std::string_view(&value, 1)); }
+    void append(bool value) { append(value ? std::string_view("true") : std::string_view("false")); }
+    void append_signed(long long value);
+    void append_unsigned(unsigned long long value);
+    void append_double(double value);
+
+    template <typename T>
+    void append(const T& value) {
+        if constexpr (std::is_convertible_v<T, const char*>) {
+            append(static_cast<const char*>(value)); // char* and char arrays.
+        } else if constexpr (std::is_enum_v<T>) {
+            append_signed(static_cast<long long>(value));
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            append_signed(value);
+        } else if constexpr (std::is_integral_v<T>) {
+            append_unsigned(value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            append_double(value);
+        } else {
+            // Anything with a string() (std::filesystem::path and the like).
+            append(value.string());
+        }
+    }
+};
+
+// Logging that is safe from the audio callback and render loop: a message is
+// formatted into a stack buffer only if its level is enabled, then pushed
+// onto a lock-free ring that a background thread writes to stderr. Callers
+// never lock, allocate or wait on I/O. Pass the pieces of a message as
+// separate arguments rather than concatenating them, so filtered messages cost
+// nothing: Logger::info("Loaded ", count, " presets from ", path).
+// When the ring is full, messages are dropped and counted rather than blocking.
 class Logger {
 public:
     static void set_log_level(LogLevel level) {
-        _log_level = level;
+        _log_level.store(level, std::memory_order_relaxed);
     }
 
     static void set_verbose_logging(bool verbose) {
-        _verbose_logging = verbose;
+        _verbose_logging.store(verbose, std::memory_order_relaxed);
+    }
+
+    static bool enabled(LogLevel level) {
+        if (static_cast<int>(level) < AURORA_LOG_MIN_LEVEL) return false;
+        // Verbose logging turns on debug messages whatever the level.
+        if (level == LogLevel::DEBUG) return _verbose_logging.load(std::memory_order_relaxed);
+        return level >= _log_level.load(std::memory_order_relaxed);
     }
 
-    static void debug(const std::string& message) {
-        log(LogLevel::DEBUG, "DEBUG", message);
+    template <typename... Args>
+    static void debug(const Args&... args) {
+        log<LogLevel::DEBUG>(args...);
     }
 
-    static void info(const std::string& message) {
-        log(LogLevel::INFO, "INFO", message);
+    template <typename... Args>
+    static void info(const Args&... args) {
+        log<LogLevel::INFO>(args...);
     }
 
-    static void warn(const std::string& message) {
-        log(LogLevel::WARN, "WARNING", message);
+    template <typename... Args>
+    static void warn(const Args&... args) {
+        log<LogLevel::WARN>(args...);
     }
 
-    static void error(const std::string& message) {
-        log(LogLevel::ERROR, "ERROR", message);
+    template <typename... Args>
+    static void error(const Args&... args) {
+        log<LogLevel::ERROR>(args...);
     }
 
+    // Blocks until every message logged so far has been written.
+    static void flush();
+
 private:
-    static void log(LogLevel level, const std::string& prefix, const std::string& message) {
-        if (!_verbose_logging && level == LogLevel::DEBUG) {
-            return;
-        }
-        if (level >= _log_level) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            std::cerr << "[" << prefix << "] " << message << std::endl;
+    template <LogLevel level, typename... Args>
+    static void log(const Args&... args) {
+        if constexpr (static_cast<int>(level) >= AURORA_LOG_MIN_LEVEL) {
+            if (!enabled(level)) {
+                return;
+            }
+            LogMessage message(level);
+            (message.append(args), ...);
+            submit(message);
         }
     }
 
-    static LogLevel _log_level;
-    static bool _verbose_logging;
-    static std::mutex _mutex;
-};
+    static void submit(const LogMessage& message);
 
-// Initialize static members
-// These will be defined in the .cpp file
-// LogLevel Logger::_log_level = LogLevel::INFO;
-// bool Logger::_verbose_logging = false;
-// std::mutex Logger::_mutex;
+    static std::atomic<LogLevel> _log_level;
+    static std::atomic<bool> _verbose_logging;
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+// Minimal PNG encoder (8-bit RGB, zlib via the system library) for thumbnails and
+// debug captures. Set flip_vertically for rows read back from OpenGL, which are bottom-up.
+bool write_png(const std::string& path, const unsigned char* rgb, int width, int height, bool flip_vertically);
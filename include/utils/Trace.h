@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Scoped CPU spans written out as Chrome trace-event JSON, which Perfetto and
+// chrome://tracing open directly. Each thread appends to its own buffer, so
+// recording takes no shared lock. While tracing is off a span costs one
+// relaxed atomic load. Span names must be string literals or otherwise outlive
+// the trace.
+class Trace {
+public:
+    // Starts recording; finish() writes the spans to `path`.
+    static void start(const std::string& path);
+    static bool enabled() { return _enabled.load(std::memory_order_relaxed); }
+    // Stops recording and writes every span so far to `path`.
+    static bool write(const std::string& path);
+    // write() to the path given to start(), or, in a process forked since, to that
+    // path with the process id before the extension ("trace.1234.json"), so
+    // every worker of an export leaves its own trace. Does nothing if not started.
+    static bool finish();
+    // Call first thing in a forked child: drops the spans inherited from the
+    // parent, which writes those itself.
+    static void forked();
+    // Names the calling thread in the trace viewer; `name` must outlive the trace.
+    static void set_thread_name(const char* name);
+
+    static int64_t now_us();
+    static void record(const char* name, int64_t start_us, int64_t end_us);
+
+private:
+    static std::atomic<bool> _enabled;
+};
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : _name(Trace::enabled() ? name : nullptr), _start(0) {
+        if (_name) _start = Trace::now_us();
+    }
+    ~TraceScope() {
+        if (_name) Trace::record(_name, _start, Trace::now_us());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* _name;
+    int64_t _start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+// Records a span named `name` from here to the end of the enclosing block.
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
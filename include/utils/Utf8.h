@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+const uint32_t UTF8_REPLACEMENT_CHARACTER = 0xFFFD;
+
+// Decodes the codepoint starting at text[pos] and advances pos past it.
+// Malformed, overlong or truncated sequences decode to U+FFFD and consume one
+// byte, so decoding always makes progress.
+uint32_t utf8_decode_next(const std::string& text, size_t& pos);
+
+// True if `byte` starts a codepoint rather than continuing one.
+inline bool utf8_is_lead_byte(char byte) {
+    return (static_cast<unsigned char>(byte) & 0xC0) != 0x80;
+}
@@ -2,12 +2,19 @@
 #ifndef VISUALIZER_UTILS_COMMON_H
 #define VISUALIZER_UTILS_COMMON_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 // Common utility functions and definitions
 std::string sanitize_filename(const std::string &filepath);
 std::vector<std::string> wrapText(const std::string &text, int lineLengthTarget);
+// 64-bit FNV-1a; used for content hashes in preset packs and caches.
+uint64_t fnv1a_64(const void* data, size_t size);
+// Copies `rows` rows of `row_bytes` each from `src` to `dst` in reverse order, e.g.
+// turning bottom-up OpenGL readback into top-down video frames. Must not alias.
+void flip_rows(const unsigned char* src, unsigned char* dst, size_t row_bytes, int rows);
 
 #endif // VISUALIZER_UTILS_COMMON_H
 
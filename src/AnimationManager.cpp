@@ -1,45 +1,50 @@
 // src/AnimationManager.cpp
 #include "AnimationManager.h"
 #include "TextRenderer.h"
-#include <glm/gtc/random.hpp>
 #include <algorithm> // For std::min/max
 #include <iostream>
 #include <cmath>
+#include <sstream>
 
 AnimationManager::AnimationManager(Config &config, TextRenderer &textRenderer)
-    : _config(config), _textRenderer(textRenderer), _artistPosition(0.0f),
-      _artistVelocity(0.0f), _alpha(1.0f), _breathingScale(1.0f),
-      _currentState(AnimationState::BOUNCING) {}
+    : _config(config), _textRenderer(textRenderer),
+      _titleBlockWidth(0.0f), _titleBlockHeight(0.0f), _artistWidth(0.0f),
+      _artistPosition(0.0f), _artistVelocity(0.0f), _alpha(1.0f), _breathingScale(1.0f),
+      _currentState(AnimationState::BOUNCING), _rng(std::random_device{}()) {}
 
 void AnimationManager::reset(const std::vector<std::string>& title_lines) {
     initializePositions(title_lines);
     _titleBlockPosition = _initialTitleBlockPosition;
     _artistPosition = _initialArtistPosition;
 
-    _titleBlockVelocity = glm::linearRand(glm::vec2(-_config.bounce_speed, -_config.bounce_speed), glm::vec2(_config.bounce_speed, _config.bounce_speed));
-    _artistVelocity = glm::linearRand(glm::vec2(-_config.bounce_speed, -_config.bounce_speed), glm::vec2(_config.bounce_speed, _config.bounce_speed));
+    _titleBlockVelocity = randomVec2(_config.bounce_speed);
+    _artistVelocity = randomVec2(_config.bounce_speed);
 
     _alpha = 1.0f;
     _breathingScale = 1.0f;
     _currentState = AnimationState::BOUNCING;
+    updateTitlePositions();
 }
 
 void AnimationManager::initializePositions(const std::vector<std::string>& title_lines) {
     _titleLineOffsets.clear();
     float total_height = title_lines.size() * _config.songInfoFontSize;
+    std::vector<float> line_widths;
     float max_width = 0;
     for (const auto& line : title_lines) {
-        max_width = std::max(max_width, _textRenderer.getTextWidth(line, 1.0f));
+        line_widths.push_back(_textRenderer.getTextWidth(line, 1.0f));
+        max_width = std::max(max_width, line_widths.back());
     }
+    _titleBlockWidth = max_width;
+    _titleBlockHeight = total_height;
 
     _initialTitleBlockPosition = {
-        (_config.width - max_width) / 2.0f,
-        (_config.height / 2.0f) + (total_height / 2.0f)
+        (_config.render_width - max_width) / 2.0f,
+        (_config.render_height / 2.0f) + (total_height / 2.0f)
     };
 
     float current_y = 0;
-    for (const auto& line : title_lines) {
-        float titleWidth = _textRenderer.getTextWidth(line, 1.0f);
+    for (float titleWidth : line_widths) {
         _titleLineOffsets.push_back({
             (max_width - titleWidth) / 2.0f,
             current_y
@@ -47,14 +52,14 @@ void AnimationManager::initializePositions(const std::vector<std::string>& title
         current_y -= _config.songInfoFontSize;
     }
 
-    float artistWidth = _textRenderer.getTextWidth(_config.artistName, 1.0f);
+    _artistWidth = _textRenderer.getTextWidth(_config.artistName, 1.0f);
     _initialArtistPosition = {
-        (_config.width - artistWidth) / 2.0f,
+        (_config.render_width - _artistWidth) / 2.0f,
         _initialTitleBlockPosition.y - total_height - _config.songInfoFontSize
     };
 }
 
-void AnimationManager::update(double music_len, double current_time, const std::vector<std::string>& title_lines) {
+void AnimationManager::update(double music_len, double current_time) {
     if (music_len <= 0) return;
 
     float deltaTime = 1.0f / _config.fps;
@@ -72,7 +77,7 @@ void AnimationManager::update(double music_len, double current_time, const std::
             if (current_time >= _config.pre_fade_delay) {
                 _currentState = AnimationState::FADING_TO_TRANSPARENT;
             }
-            updateBouncing(deltaTime, title_lines);
+            updateBouncing(deltaTime);
             break;
         case AnimationState::FADING_TO_TRANSPARENT:
             {
@@ -82,14 +87,14 @@ void AnimationManager::update(double music_len, double current_time, const std::
                 if (_alpha <= _config.minFadeTransparency) {
                     _currentState = AnimationState::HOLDING_TRANSPARENT;
                 }
-                updateBouncing(deltaTime, title_lines);
+                updateBouncing(deltaTime);
             }
             break;
         case AnimationState::HOLDING_TRANSPARENT:
             if (time_until_end <= _config.transitionTime) {
                 _currentState = AnimationState::FADING_TO_OPAQUE;
             }
-            updateBouncing(deltaTime, title_lines);
+            updateBouncing(deltaTime);
             break;
         case AnimationState::FADING_TO_OPAQUE:
             {
@@ -99,7 +104,7 @@ void AnimationManager::update(double music_len, double current_time, const std::
                 if (_alpha >= 1.0f) {
                     _currentState = AnimationState::RETURNING_TO_CENTER;
                 }
-                updateBouncing(deltaTime, title_lines);
+                updateBouncing(deltaTime);
             }
             break;
         case AnimationState::RETURNING_TO_CENTER:
@@ -116,45 +121,55 @@ void AnimationManager::update(double music_len, double current_time, const std::
             break;
     }
      _alpha = std::max(0.0f, std::min(1.0f, _alpha));
+     updateTitlePositions();
 }
 
 
-void AnimationManager::updateBouncing(float deltaTime, const std::vector<std::string>& title_lines) {
+void AnimationManager::updateBouncing(float deltaTime) {
     _titleBlockPosition += _titleBlockVelocity * deltaTime;
 
-    float block_width = 0;
-    for(const auto& line : title_lines) {
-        block_width = std::max(block_width, _textRenderer.getTextWidth(line, 1.0f));
-    }
-    float block_height = title_lines.size() * _config.songInfoFontSize;
+    const float block_width = _titleBlockWidth;
+    const float block_height = _titleBlockHeight;
 
-    if (_titleBlockPosition.x < 0 || _titleBlockPosition.x + block_width > _config.width) {
+    if (_titleBlockPosition.x < 0 || _titleBlockPosition.x + block_width > _config.render_width) {
         _titleBlockVelocity.x *= -1;
-        _titleBlockVelocity += glm::linearRand(glm::vec2(-_config.bounce_randomness, -_config.bounce_randomness), glm::vec2(_config.bounce_randomness, _config.bounce_randomness));
-        _titleBlockPosition.x = std::max(0.0f, std::min(_titleBlockPosition.x, _config.width - block_width));
+        _titleBlockVelocity += randomVec2(_config.bounce_randomness);
+        _titleBlockPosition.x = std::max(0.0f, std::min(_titleBlockPosition.x, _config.render_width - block_width));
     }
-    if (_titleBlockPosition.y - block_height < 0 || _titleBlockPosition.y > _config.height) {
+    if (_titleBlockPosition.y - block_height < 0 || _titleBlockPosition.y > _config.render_height) {
         _titleBlockVelocity.y *= -1;
-        _titleBlockVelocity += glm::linearRand(glm::vec2(-_config.bounce_randomness, -_config.bounce_randomness), glm::vec2(_config.bounce_randomness, _config.bounce_randomness));
-        _titleBlockPosition.y = std::max(block_height, std::min(_titleBlockPosition.y, (float)_config.height));
+        _titleBlockVelocity += randomVec2(_config.bounce_randomness);
+        _titleBlockPosition.y = std::max(block_height, std::min(_titleBlockPosition.y, (float)_config.render_height));
     }
 
 
     _artistPosition += _artistVelocity * deltaTime;
-    float artistWidth = _textRenderer.getTextWidth(_config.artistName, 1.0f);
+    const float artistWidth = _artistWidth;
 
-    if (_artistPosition.x < 0 || _artistPosition.x + artistWidth > _config.width) {
+    if (_artistPosition.x < 0 || _artistPosition.x + artistWidth > _config.render_width) {
         _artistVelocity.x = -_artistVelocity.x;
-        _artistVelocity += glm::linearRand(glm::vec2(-_config.bounce_randomness, -_config.bounce_randomness), glm::vec2(_config.bounce_randomness, _config.bounce_randomness));
-        _artistPosition.x = std::max(0.0f, std::min(_artistPosition.x, _config.width - artistWidth));
+        _artistVelocity += randomVec2(_config.bounce_randomness);
+        _artistPosition.x = std::max(0.0f, std::min(_artistPosition.x, _config.render_width - artistWidth));
     }
-    if (_artistPosition.y < _config.songInfoFontSize || _artistPosition.y > _config.height) {
+    if (_artistPosition.y < _config.songInfoFontSize || _artistPosition.y > _config.render_height) {
         _artistVelocity.y = -_artistVelocity.y;
-        _artistVelocity += glm::linearRand(glm::vec2(-_config.bounce_randomness, -_config.bounce_randomness), glm::vec2(_config.bounce_randomness, _config.bounce_randomness));
-        _artistPosition.y = std::max((float)_config.songInfoFontSize, std::min(_artistPosition.y, (float)_config.height));
+        _artistVelocity += randomVec2(_config.bounce_randomness);
+        _artistPosition.y = std::max((float)_config.songInfoFontSize, std::min(_artistPosition.y, (float)_config.render_height));
     }
 }
 
+std::string AnimationManager::getRandomState() const {
+    std::ostringstream state;
+    state << _rng;
+    return state.str();
+}
+
+glm::vec2 AnimationManager::randomVec2(float extent) {
+    std::uniform_real_distribution<float> distribution(-std::abs(extent), std::abs(extent));
+    const float x = distribution(_rng);
+    return glm::vec2(x, distribution(_rng));
+}
+
 void AnimationManager::updateReturning(float deltaTime) {
     glm::vec2 direction = glm::normalize(_initialTitleBlockPosition - _titleBlockPosition);
     _titleBlockPosition += direction * _config.bounce_speed * deltaTime;
@@ -163,12 +178,16 @@ void AnimationManager::updateReturning(float deltaTime) {
     _artistPosition += artistDirection * _config.bounce_speed * deltaTime;
 }
 
-std::vector<glm::vec2> AnimationManager::getTitlePositions(const std::vector<std::string>& title_lines) const {
-    std::vector<glm::vec2> positions;
-    for (size_t i = 0; i < title_lines.size(); ++i) {
-        positions.push_back(_titleBlockPosition + _titleLineOffsets[i]);
+void AnimationManager::updateTitlePositions() {
+    // Same size as _titleLineOffsets after the first call, so this never reallocates.
+    _titlePositions.resize(_titleLineOffsets.size());
+    for (size_t i = 0; i < _titleLineOffsets.size(); ++i) {
+        _titlePositions[i] = _titleBlockPosition + _titleLineOffsets[i];
     }
-    return positions;
+}
+
+const std::vector<glm::vec2>& AnimationManager::getTitlePositions() const {
+    return _titlePositions;
 }
 
 glm::vec2 AnimationManager::getArtistPosition() const {
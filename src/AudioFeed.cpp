@@ -0,0 +1,24 @@
+// src/AudioFeed.cpp
+#include "AudioFeed.h"
+
+AudioFeed::AudioFeed(const std::string& source, const std::vector<int16_t>& pcm, int fps)
+    : _pcm(pcm), _position(0), _frames_per_video_frame(SyntheticAudio::SAMPLE_RATE / fps),
+      _buffer(_frames_per_video_frame * 2) {
+    SyntheticSignal signal = SyntheticSignal::Mix;
+    SyntheticAudio::parse_signal(source, signal);
+    _synthetic = SyntheticAudio(signal);
+}
+
+void AudioFeed::feed(projectm_handle pM) {
+    if (_pcm.empty()) {
+        _synthetic.generate(_buffer.data(), _frames_per_video_frame);
+        projectm_pcm_add_float(pM, _buffer.data(), _frames_per_video_frame, PROJECTM_STEREO);
+        return;
+    }
+    size_t samples = _frames_per_video_frame * 2;
+    if (_position + samples > _pcm.size()) {
+        _position = 0;
+    }
+    projectm_pcm_add_int16(pM, _pcm.data() + _position, _frames_per_video_frame, PROJECTM_STEREO);
+    _position += samples;
+}
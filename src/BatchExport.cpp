@@ -0,0 +1,297 @@
+// src/BatchExport.cpp
+#include "BatchExport.h"
+#include "ExportCheckpoint.h"
+#include "OfflineRenderer.h"
+#include "ProcessPool.h"
+#include "VideoExporter.h"
+#include "audio_input.h"
+#include "preset_manager.h"
+#include "utils/Logger.h"
+#include "utils/common.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern volatile sig_atomic_t g_quit_flag;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// A worker that reports nothing for this long is presumed hung. Decoding a long
+// mix happens before the first progress report, so this is generous.
+const double WORKER_IDLE_TIMEOUT_SECONDS = 300.0;
+// How often a worker reports progress, which also keeps it clear of the idle timeout.
+const double PROGRESS_INTERVAL_SECONDS = 5.0;
+
+// Output paths named after each track, made unique when two tracks share a file name.
+std::vector<std::string> output_paths(const Config& config) {
+    VideoExporter namer(config);
+    std::vector<std::string> paths;
+    for (const std::string& track : config.audio_file_paths) {
+        std::string path = namer.output_path_for(track);
+        const std::string stem = path.substr(0, path.size() - fs::path(path).extension().string().size());
+        for (int copy = 2; std::find(paths.begin(), paths.end(), path) != paths.end(); ++copy) {
+            path = stem + "_" + std::to_string(copy) + fs::path(path).extension().string();
+        }
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+std::string failure_reason(const ProcessJobResult& result) {
+    return result.timed_out ? "timed out"
+           : result.signal  ? "killed by signal " + std::to_string(result.signal)
+                            : "exit code " + std::to_string(result.exit_code);
+}
+
+// Splits one track into config.export_segments time segments, renders them side
+// by side and joins them. Each worker decodes only the audio its segment needs.
+bool export_segmented(const Config& config, PresetManager& presets, const std::string& track, const std::string& output,
+                      int& frames, double& audio_seconds) {
+    size_t track_samples = 0;
+    if (!AudioInput::probe_length(track, track_samples)) {
+        return false;
+    }
+    frames = OfflineRenderer::frame_count(track_samples, config.video_framerate);
+    audio_seconds = static_cast<double>(track_samples) / AudioInput::SAMPLE_RATE;
+    const int segments = std::min<int>(config.export_segments, frames);
+    if (segments == 0) {
+        Logger::error("No audio in ", track);
+        return false;
+    }
+    const std::vector<OfflineJob> jobs = BatchExport::segment_jobs(config, track, output, track_samples, segments);
+    std::vector<std::string> parts;
+    for (const OfflineJob& job : jobs) {
+        parts.push_back(job.output_path);
+    }
+
+    Logger::info("Rendering ", track, " in ", segments, " segments of about ",
+                 static_cast<int>(frames / segments / std::max(1, config.video_framerate)), "s each.");
+    size_t finished = 0;
+    size_t failed = 0;
+    ProcessPool::run(
+        jobs.size(), config.export_jobs,
+        [&](size_t job, int fd) { return BatchExport::run_job(config, presets, jobs[job], fd); },
+        [&](const ProcessJobResult& result) {
+            finished++;
+            int segment_frames = 0;
+            double segment_seconds = 0.0, render_seconds = 0.0;
+            BatchExport::parse_done(result.output, segment_frames, segment_seconds, render_seconds);
+            if (result.exit_code != 0) {
+                failed++;
+                Logger::error("[", finished, "/", segments, "] ", parts[result.job], " failed (", failure_reason(result), ").");
+                return;
+            }
+            Logger::info("[", finished, "/", segments, "] ", parts[result.job], ": ",
+                         BatchExport::throughput(segment_frames, segment_seconds, render_seconds));
+        },
+        WORKER_IDLE_TIMEOUT_SECONDS);
+
+    const bool ok = failed == 0 && !g_quit_flag && VideoExporter::concatenate(parts, track, output);
+    std::error_code error;
+    for (const std::string& part : parts) {
+        fs::remove(part, error);
+    }
+    return ok;
+}
+
+} // namespace
+
+int BatchExport::checkpoint_frames(const Config& config) {
+    if (config.checkpoint_seconds <= 0) {
+        return 0;
+    }
+    return std::max(1, static_cast<int>(std::lround(config.checkpoint_seconds * std::max(1, config.video_framerate))));
+}
+
+uint64_t BatchExport::track_seed(const Config& config, const std::string& track) {
+    if (config.export_seed != 0) {
+        return config.export_seed;
+    }
+    const std::string name = fs::path(track).filename().string();
+    return fnv1a_64(name.data(), name.size());
+}
+
+std::vector<OfflineJob> BatchExport::segment_jobs(const Config& config, const std::string& track, const std::string& output_path,
+                                                  size_t track_samples, int segments) {
+    const int frames = OfflineRenderer::frame_count(track_samples, config.video_framerate);
+    const std::string extension = fs::path(output_path).extension().string();
+    const std::string stem = output_path.substr(0, output_path.size() - extension.size());
+    std::vector<OfflineJob> jobs(segments);
+    for (int i = 0; i < segments; ++i) {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".part%03d", i);
+        jobs[i].audio_path = track;
+        jobs[i].output_path = stem + suffix + extension;
+        jobs[i].first_frame = static_cast<int>(static_cast<int64_t>(frames) * i / segments);
+        jobs[i].end_frame = static_cast<int>(static_cast<int64_t>(frames) * (i + 1) / segments);
+        jobs[i].preroll_seconds = config.segment_preroll_seconds;
+        jobs[i].seed = track_seed(config, track);
+        jobs[i].encode_audio = false;
+        jobs[i].track_samples = track_samples;
+    }
+    return jobs;
+}
+
+int BatchExport::run_job(const Config& config, PresetManager& presets, const OfflineJob& job, int output_fd) {
+    if (g_quit_flag) {
+        return 1;
+    }
+    OfflineRenderer renderer(config, presets);
+    if (!renderer.init()) {
+        return 2;
+    }
+    auto last_report = std::chrono::steady_clock::now();
+    auto report = [&](int frame, int frames) {
+        const auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double>(now - last_report).count() >= PROGRESS_INTERVAL_SECONDS) {
+            ProcessPool::write_all(output_fd, "PROGRESS\t" + std::to_string(frame) + "\t" + std::to_string(frames) + "\n");
+            last_report = now;
+        }
+    };
+    OfflineStats stats;
+    const bool ok = renderer.render(job, stats, report);
+    std::ostringstream done;
+    done << "DONE\t" << stats.frames << "\t" << stats.audio_seconds << "\t" << stats.seconds << "\n";
+    ProcessPool::write_all(output_fd, done.str());
+    return ok ? 0 : 1;
+}
+
+void BatchExport::parse_done(const std::string& output, int& frames, double& audio_seconds, double& render_seconds) {
+    std::istringstream lines(output);
+    for (std::string line; std::getline(lines, line);) {
+        if (line.rfind("DONE\t", 0) == 0) {
+            std::istringstream fields(line.substr(5));
+            fields >> frames >> audio_seconds >> render_seconds;
+        }
+    }
+}
+
+std::string BatchExport::throughput(int frames, double audio_seconds, double render_seconds) {
+    char text[128];
+    std::snprintf(text, sizeof(text), "%d frames in %.1fs: %.1f fps, %.2fx real time", frames, render_seconds,
+                  render_seconds > 0 ? frames / render_seconds : 0.0, render_seconds > 0 ? audio_seconds / render_seconds : 0.0);
+    return text;
+}
+
+
+int BatchExport::run(const Config& config) {
+    const std::vector<std::string>& tracks = config.audio_file_paths;
+    if (tracks.empty()) {
+        Logger::error("Batch export needs at least one audio file.");
+        return 1;
+    }
+    std::error_code error;
+    fs::create_directories(config.video_directory, error);
+    std::vector<std::string> outputs = output_paths(config);
+    std::vector<int> chunk_frames(tracks.size(), checkpoint_frames(config));
+    if (config.checkpoint_seconds > 0 && config.export_segments > 1) {
+        Logger::warn("Checkpoints are for whole-track exports; ignoring --checkpoint-seconds with --export-segments.");
+    } else if (config.resume_export) {
+        // Carry on into the file the interrupted export was writing, not a newly timestamped
+        // one, and in chunks of the size it used, whether or not --checkpoint-seconds is given.
+        for (size_t i = 0; i < tracks.size(); ++i) {
+            ExportCheckpoint checkpoint;
+            if (!ExportCheckpoint::find(config.video_directory, tracks[i], checkpoint)) {
+                continue;
+            }
+            if (config.checkpoint_seconds > 0 && chunk_frames[i] != checkpoint.chunk_frames) {
+                Logger::error("The checkpoint for ", tracks[i], " uses chunks of ", checkpoint.chunk_frames,
+                              " frames, but --checkpoint-seconds asks for ", chunk_frames[i],
+                              ". Resume without --checkpoint-seconds, or delete ",
+                              ExportCheckpoint::path_for(checkpoint.output_path), " to start over.");
+                return 1;
+            }
+            outputs[i] = checkpoint.output_path;
+            chunk_frames[i] = checkpoint.chunk_frames;
+            Logger::info("Found a checkpoint for ", tracks[i], " at frame ", checkpoint.next_frame, " of ",
+                         checkpoint.frames, ".");
+        }
+    }
+
+    // Longest tracks first, so a long one never starts last and leaves the other
+    // workers idle. File size stands in for duration, which would need a decode.
+    std::vector<size_t> order(tracks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<uintmax_t> sizes(tracks.size());
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        sizes[i] = fs::file_size(tracks[i], error);
+        if (error) sizes[i] = 0;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    // Scanned once here; the workers inherit the list.
+    PresetManager presets(config);
+    if (!config.use_default_projectm_visualizer) {
+        presets.load_presets();
+    }
+
+    Logger::info("Exporting ", tracks.size(), " tracks to ", config.video_directory, " with ",
+                 config.export_jobs > 0 ? std::to_string(config.export_jobs) : std::string("one per core"), " workers.");
+    const auto start = std::chrono::steady_clock::now();
+    size_t failed = 0;
+    double audio_seconds = 0.0;
+    if (config.export_segments > 1) {
+        // One track at a time, every worker on its segments.
+        for (size_t i = 0; i < order.size(); ++i) {
+            const size_t track = order[i];
+            const auto track_start = std::chrono::steady_clock::now();
+            int frames = 0;
+            double track_seconds = 0.0;
+            if (g_quit_flag || !export_segmented(config, presets, tracks[track], outputs[track], frames, track_seconds)) {
+                failed++;
+                Logger::error("[", i + 1, "/", tracks.size(), "] ", tracks[track], " failed.");
+                continue;
+            }
+            audio_seconds += track_seconds;
+            const double render_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - track_start).count();
+            Logger::info("[", i + 1, "/", tracks.size(), "] ", outputs[track], ": ", throughput(frames, track_seconds, render_seconds));
+        }
+    } else {
+        size_t finished = 0;
+        ProcessPool::run(
+            order.size(), config.export_jobs,
+            [&](size_t job, int fd) {
+                const size_t track = order[job];
+                OfflineJob offline_job;
+                offline_job.audio_path = tracks[track];
+                offline_job.output_path = outputs[track];
+                offline_job.seed = BatchExport::track_seed(config, tracks[track]);
+                offline_job.checkpoint_frames = chunk_frames[track];
+                offline_job.resume = config.resume_export;
+                offline_job.preroll_seconds = config.segment_preroll_seconds;
+                return BatchExport::run_job(config, presets, offline_job, fd);
+            },
+            [&](const ProcessJobResult& result) {
+                const size_t track = order[result.job];
+                finished++;
+                int frames = 0;
+                double track_seconds = 0.0, render_seconds = 0.0;
+                parse_done(result.output, frames, track_seconds, render_seconds);
+                if (result.exit_code != 0) {
+                    failed++;
+                    Logger::error("[", finished, "/", tracks.size(), "] ", tracks[track], " failed (", failure_reason(result), ").");
+                    return;
+                }
+                audio_seconds += track_seconds;
+                Logger::info("[", finished, "/", tracks.size(), "] ", outputs[track], ": ",
+                             throughput(frames, track_seconds, render_seconds));
+            },
+            WORKER_IDLE_TIMEOUT_SECONDS);
+    }
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    char summary[128];
+    std::snprintf(summary, sizeof(summary), "%.1fs of audio in %.1fs (%.2fx real time)", audio_seconds, elapsed,
+                  elapsed > 0 ? audio_seconds / elapsed : 0.0);
+    Logger::info("Exported ", tracks.size() - failed, " of ", tracks.size(), " tracks: ", summary, ".");
+    return failed ? 1 : 0;
+}
@@ -4,6 +4,7 @@
 #include "utils/Logger.h"
 #include <vector>
 #include <functional>
+#include <iostream>
 #include <unordered_map>
 
 void CliParser::display_help(const std::string &program_name) {
@@ -22,7 +23,15 @@ void CliParser::display_help(const std::string &program_name) {
             << BOLD << MAGENTA << "Display & Performance" << RESET << "\n"
             << "  " << BOLD << GREEN << "--width <px>" << RESET << "               Set window width (default: 1024).\n"
             << "  " << BOLD << GREEN << "--height <px>" << RESET << "              Set window height (default: 640).\n"
-            << "  " << BOLD << GREEN << "--fps <value>" << RESET << "              Set frames per second (default: 30).\n\n"
+            << "  " << BOLD << GREEN << "--render-width <px>" << RESET << "        Render and recording width (default: window width).\n"
+            << "  " << BOLD << GREEN << "--render-height <px>" << RESET << "       Render and recording height (default: window height).\n"
+            << "  " << BOLD << GREEN << "--fps <value>" << RESET << "              Set frames per second (default: 30).\n"
+            << "  " << BOLD << GREEN << "--adaptive-quality" << RESET << "         Lower render resolution and mesh size to hold the frame rate.\n"
+            << "  " << BOLD << GREEN << "--hud" << RESET << "                      Show the performance HUD at startup.\n"
+            << "  " << BOLD << GREEN << "--hud-key <key>" << RESET << "            Key to show or hide the performance HUD (default: F3).\n"
+            << "  " << BOLD << GREEN << "--trace-out <file>" << RESET << "         Write a Chrome/Perfetto trace of frame stages on exit.\n"
+            << "  " << BOLD << GREEN << "--alloc-check <frames>" << RESET << "     After <frames> frames, fail if a frame allocates (alloc tracking builds).\n"
+            << "  " << BOLD << GREEN << "--metrics-listen <addr>" << RESET << "    Serve Prometheus metrics on loopback [host:]port or unix:/path.\n\n"
 
             << BOLD << MAGENTA << "Text & Font" << RESET << "\n"
             << "  " << BOLD << GREEN << "--font-path <path>" << RESET << "         Path to the font file (TTF/OTF).\n"
@@ -60,6 +69,7 @@ void CliParser::display_help(const std::string &program_name) {
             << BOLD << MAGENTA << "Presets" << RESET << "\n"
             << "  " << BOLD << GREEN << "--preset-duration <sec>" << RESET << "    Time before switching to the next preset.\n"
             << "  " << BOLD << GREEN << "--preset-blend-time <sec>" << RESET << "  Time for the blend transition between presets.\n"
+            << "  " << BOLD << GREEN << "--preset-pack <path>" << RESET << "        Load presets from an aurora-pack file instead of the presets directory.\n"
             << "  " << BOLD << GREEN << "--preset-list-file <path>" << RESET << "  Path to a file containing a list of .milk presets.\n"
             << "  " << BOLD << GREEN << "--broken-preset-directory <path>" << RESET << " Directory to move broken presets to.\n"
             << "  " << BOLD << GREEN << "--favorites-file <path>" << RESET << "    Path to the favorites file.\n"
@@ -67,10 +77,26 @@ void CliParser::display_help(const std::string &program_name) {
             << "  " << BOLD << GREEN << "--prev-preset-key <key>" << RESET << "    Key to load the previous preset (e.g., 'p').\n"
             << "  " << BOLD << GREEN << "--mark-broken-preset-key <key>" << RESET << " Key to mark the current preset as broken (e.g., 'b').\n"
             << "  " << BOLD << GREEN << "--favorite-preset-key <key>" << RESET << " Key to mark the current preset as a favorite (e.g., 'f').\n"
+            << "  " << BOLD << GREEN << "--max-preset-complexity <val>" << RESET << " Skip presets whose estimated cost exceeds this (0 = off).\n"
+            << "  " << BOLD << GREEN << "--preset-quarantine-file <path>" << RESET << " Skip presets listed by aurora_triage.\n"
+            << "  " << BOLD << GREEN << "--preset-cost-report <path>" << RESET << " Measured preset frame times from aurora_triage.\n"
+            << "  " << BOLD << GREEN << "--max-preset-frame-ms <ms>" << RESET << " Skip presets measured slower than this (0 = off).\n"
             << "  " << BOLD << GREEN << "--use-default-projectm-visualizer" << RESET << " Use projectM's default visualizer for testing audio input.\n\n"
 
             << BOLD << MAGENTA << "Recording" << RESET << "\n"
             << "  " << BOLD << GREEN << "--record-video" << RESET << "             Enable video recording.\n"
+            << "  " << BOLD << GREEN << "--batch-export" << RESET << "             Render each audio file to its own video offline, in parallel.\n"
+            << "  " << BOLD << GREEN << "--export-jobs <n>" << RESET << "          Worker processes for --batch-export (default: one per core).\n"
+            << "  " << BOLD << GREEN << "--export-segments <n>" << RESET << "      Split each exported track into n segments rendered in parallel (default: 1).\n"
+            << "  " << BOLD << GREEN << "--segment-preroll <sec>" << RESET << "    Audio rendered before each segment to settle projectM (default: 10).\n"
+            << "  " << BOLD << GREEN << "--export-seed <n>" << RESET << "          Seed for exported preset schedules (default: 0, from the file name).\n"
+            << "  " << BOLD << GREEN << "--checkpoint-seconds <sec>" << RESET << " Export in closed chunks this long, checkpointing each (default: 0, off).\n"
+            << "  " << BOLD << GREEN << "--resume" << RESET << "                   Continue checkpointed exports where they stopped.\n"
+            << "  " << BOLD << GREEN << "--coordinator <manifest>" << RESET << "   Hand the exports in a manifest to render workers over TCP.\n"
+            << "  " << BOLD << GREEN << "--farm-listen <addr>" << RESET << "       Coordinator address, [host:]port (default: 127.0.0.1:7878).\n"
+            << "  " << BOLD << GREEN << "--render-worker <addr>" << RESET << "     Render jobs for the coordinator at [host:]port, --export-jobs at a time.\n"
+            << "  " << BOLD << GREEN << "--farm-attempts <n>" << RESET << "        Times a farm job is tried before its track fails (default: 3).\n"
+            << "  " << BOLD << GREEN << "--farm-heartbeat-timeout <sec>" << RESET << " Silence before a render worker is presumed dead (default: 30).\n"
             << "  " << BOLD << GREEN << "--audio-input-mode <mode>" << RESET << "  Set audio input mode (SystemDefault, PipeWire, PulseAudio, File). Default: PipeWire.\n"
             << "  " << BOLD << GREEN << "--pipewire-sink-name <name>" << RESET << " Set the name of the virtual PipeWire sink (default: AuroraSink).\n"
             << "  " << BOLD << GREEN << "--output-directory <path>" << RESET << "  Directory to save recorded videos.\n"
@@ -105,12 +131,29 @@ bool CliParser::parse(Config& config, int argc, char *argv[]) {
     std::unordered_map<std::string, std::function<void(const std::string&)>> parsers;
     parsers["--width"] = [&config](const std::string& v){ config.width = std::stoi(v); };
     parsers["--height"] = [&config](const std::string& v){ config.height = std::stoi(v); };
+    parsers["--render-width"] = [&config](const std::string& v){ config.render_width = std::stoi(v); };
+    parsers["--render-height"] = [&config](const std::string& v){ config.render_height = std::stoi(v); };
+    parsers["--trace-out"] = [&config](const std::string& v){ config.trace_out_path = v; };
+    parsers["--hud-key"] = [&config](const std::string& v){ config.hud_key = SDL_GetKeyFromName(v.c_str()); };
+    parsers["--metrics-listen"] = [&config](const std::string& v){ config.metrics_listen = v; };
+    parsers["--alloc-check"] = [&config](const std::string& v){ config.alloc_check_warmup_frames = std::stoi(v); };
     parsers["--fps"] = [&config](const std::string& v){ config.fps = std::stoi(v); };
     parsers["--output-directory"] = [&config](const std::string& v){ config.video_directory = v; };
+    parsers["--export-jobs"] = [&config](const std::string& v){ config.export_jobs = std::stoul(v); };
+    parsers["--export-segments"] = [&config](const std::string& v){ config.export_segments = std::stoul(v); };
+    parsers["--segment-preroll"] = [&config](const std::string& v){ config.segment_preroll_seconds = std::stod(v); };
+    parsers["--export-seed"] = [&config](const std::string& v){ config.export_seed = std::stoull(v); };
+    parsers["--checkpoint-seconds"] = [&config](const std::string& v){ config.checkpoint_seconds = std::stod(v); };
+    parsers["--coordinator"] = [&config](const std::string& v){ config.farm_manifest = v; };
+    parsers["--farm-listen"] = [&config](const std::string& v){ config.farm_listen = v; };
+    parsers["--render-worker"] = [&config](const std::string& v){ config.farm_connect = v; };
+    parsers["--farm-attempts"] = [&config](const std::string& v){ config.farm_max_attempts = std::stoul(v); };
+    parsers["--farm-heartbeat-timeout"] = [&config](const std::string& v){ config.farm_heartbeat_timeout = std::stod(v); };
     parsers["--video-framerate"] = [&config](const std::string& v){ config.video_framerate = std::stoi(v); };
     parsers["--ffmpeg-command"] = [&config](const std::string& v){ strncpy(config.ffmpeg_command, v.c_str(), sizeof(config.ffmpeg_command) - 1); config.ffmpeg_command[sizeof(config.ffmpeg_command) - 1] = '\0'; };
     parsers["--preset-duration"] = [&config](const std::string& v){ config.presetDuration = std::stod(v); };
     parsers["--preset-blend-time"] = [&config](const std::string& v){ config.presetBlendTime = std::stod(v); };
+    parsers["--preset-pack"] = [&config](const std::string& v){ config.preset_pack_file = v; };
     parsers["--preset-list-file"] = [&config](const std::string& v){ config.preset_list_file = v; };
     parsers["--broken-preset-directory"] = [&config](const std::string& v){ config.broken_preset_directory = v; };
     parsers["--favorites-file"] = [&config](const std::string& v){ config.favoritesFile = v; };
@@ -118,6 +161,10 @@ bool CliParser::parse(Config& config, int argc, char *argv[]) {
     parsers["--prev-preset-key"] = [&config](const std::string& v){ config.prev_preset_key = SDL_GetKeyFromName(v.c_str()); };
     parsers["--mark-broken-preset-key"] = [&config](const std::string& v){ config.mark_broken_preset_key = SDL_GetKeyFromName(v.c_str()); };
     parsers["--favorite-preset-key"] = [&config](const std::string& v){ config.favorite_preset_key = SDL_GetKeyFromName(v.c_str()); };
+    parsers["--max-preset-complexity"] = [&config](const std::string& v){ config.max_preset_complexity = std::stof(v); };
+    parsers["--preset-quarantine-file"] = [&config](const std::string& v){ config.preset_quarantine_file = v; };
+    parsers["--preset-cost-report"] = [&config](const std::string& v){ config.preset_cost_report = v; };
+    parsers["--max-preset-frame-ms"] = [&config](const std::string& v){ config.max_preset_frame_ms = std::stof(v); };
     parsers["--url-text"] = [&config](const std::string& v){ config.urlText = v; };
     parsers["--artist-name"] = [&config](const std::string& v){ config.artistName = v; };
     parsers["--font-path"] = [&config](const std::string& v){ config.font_path = v; };
@@ -152,6 +199,10 @@ bool CliParser::parse(Config& config, int argc, char *argv[]) {
 
     std::unordered_map<std::string, std::function<void()>> flag_parsers;
     flag_parsers["--record-video"] = [&config](){ config.enable_recording = true; };
+    flag_parsers["--batch-export"] = [&config](){ config.batch_export = true; };
+    flag_parsers["--resume"] = [&config](){ config.resume_export = true; };
+    flag_parsers["--adaptive-quality"] = [&config](){ config.adaptive_quality = true; };
+    flag_parsers["--hud"] = [&config](){ config.show_hud = true; };
     flag_parsers["--disable-text-animation"] = [&config](){ config.text_animation_enabled = false; };
     flag_parsers["--hide-title"] = [&config](){ config.show_song_title = false; };
     flag_parsers["--hide-artist"] = [&config](){ config.show_artist_name = false; };
@@ -176,7 +227,7 @@ bool CliParser::parse(Config& config, int argc, char *argv[]) {
                 if (flag_it != flag_parsers.end()) {
                     flag_it->second();
                 } else {
-                    Logger::error("Unknown option: " + arg);
+                    Logger::error("Unknown option: ", arg);
                     display_help(argv[0]);
                     return false;
                 }
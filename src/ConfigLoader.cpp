@@ -58,7 +58,7 @@ bool ConfigLoader::load(Config& config, const std::string &executable_path_str)
         if (!project_root.empty()) {
             config_path = project_root / "config" / "default.toml";
         } else {
-            std::cerr << "Warning: Could not find project root. Unable to load default config." << std::endl;
+            Logger::warn("Could not find project root. Unable to load default config.");
             // As a last resort, you might try a path relative to the executable
             config_path = fs::absolute(executable_path).parent_path().parent_path() / "config" / "default.toml";
         }
@@ -67,26 +67,29 @@ bool ConfigLoader::load(Config& config, const std::string &executable_path_str)
     if (!config_path.empty() && fs::exists(config_path)) {
         load_from_file(config, config_path.string());
     } else {
-        std::cerr << "Warning: No configuration file found. Using default values." << std::endl;
+        Logger::warn("No configuration file found. Using default values.");
     }
 
     return true;
 }
 
-void ConfigLoader::load_from_file(Config& config, const std::string &path) {
-    std::ifstream configFile(path);
-    if (!configFile.is_open()) {
-        std::cerr << "Warning: Could not open config file " << path
-                  << ". Using defaults." << std::endl;
-        return;
-    }
+using ConfigParsers = std::unordered_map<std::string, std::function<void(const std::string&)>>;
 
-    std::unordered_map<std::string, std::function<void(const std::string&)>> parsers;
+// One setter per config file key, writing into `config`.
+static ConfigParsers make_parsers(Config& config) {
+    ConfigParsers parsers;
     parsers["resolution_width"] = [&config](const std::string& v){ config.width = std::stoi(v); };
     parsers["resolution_height"] = [&config](const std::string& v){ config.height = std::stoi(v); };
+    parsers["render_width"] = [&config](const std::string& v){ config.render_width = std::stoi(v); };
+    parsers["render_height"] = [&config](const std::string& v){ config.render_height = std::stoi(v); };
     parsers["fps"] = [&config](const std::string& v){ config.fps = std::stoi(v); };
+    parsers["adaptive_quality"] = [&config](const std::string& v){ config.adaptive_quality = (v == "true"); };
+    parsers["show_hud"] = [&config](const std::string& v){ config.show_hud = (v == "true"); };
+    parsers["hud_key"] = [&config](const std::string& v){ config.hud_key = SDL_GetKeyFromName(v.c_str()); };
+    parsers["metrics_listen"] = [&config](const std::string& v){ config.metrics_listen = v; };
     parsers["font_path"] = [&config](const std::string& v){ config.font_path = v; };
     parsers["presets_directory"] = [&config](const std::string& v){ config.presetsDirectory = v; };
+    parsers["preset_pack_file"] = [&config](const std::string& v){ config.preset_pack_file = v; };
     parsers["favorites_file"] = [&config](const std::string& v){ config.favoritesFile = v; };
     parsers["shuffle_enabled"] = [&config](const std::string& v){ config.shuffleEnabled = (v == "true"); };
     parsers["preset_duration"] = [&config](const std::string& v){ config.presetDuration = std::stod(v); };
@@ -119,6 +122,14 @@ void ConfigLoader::load_from_file(Config& config, const std::string &path) {
     parsers["record_video"] = [&config](const std::string& v){ config.enable_recording = (v == "true"); };
     parsers["output_directory"] = [&config](const std::string& v){ config.video_directory = v; };
     parsers["video_framerate"] = [&config](const std::string& v){ config.video_framerate = std::stoi(v); };
+    parsers["export_jobs"] = [&config](const std::string& v){ config.export_jobs = std::stoul(v); };
+    parsers["export_segments"] = [&config](const std::string& v){ config.export_segments = std::stoul(v); };
+    parsers["segment_preroll_seconds"] = [&config](const std::string& v){ config.segment_preroll_seconds = std::stod(v); };
+    parsers["export_seed"] = [&config](const std::string& v){ config.export_seed = std::stoull(v); };
+    parsers["checkpoint_seconds"] = [&config](const std::string& v){ config.checkpoint_seconds = std::stod(v); };
+    parsers["farm_listen"] = [&config](const std::string& v){ config.farm_listen = v; };
+    parsers["farm_max_attempts"] = [&config](const std::string& v){ config.farm_max_attempts = std::stoul(v); };
+    parsers["farm_heartbeat_timeout"] = [&config](const std::string& v){ config.farm_heartbeat_timeout = std::stod(v); };
     parsers["ffmpeg_command"] = [&config](const std::string& v){ strncpy(config.ffmpeg_command, v.c_str(), sizeof(config.ffmpeg_command) - 1); config.ffmpeg_command[sizeof(config.ffmpeg_command) - 1] = '\0'; };
     parsers["preset_list_file"] = [&config](const std::string& v){ config.preset_list_file = v; };
     parsers["broken_preset_directory"] = [&config](const std::string& v){ config.broken_preset_directory = v; };
@@ -126,8 +137,22 @@ void ConfigLoader::load_from_file(Config& config, const std::string &path) {
     parsers["prev_preset_key"] = [&config](const std::string& v){ config.prev_preset_key = SDL_GetKeyFromName(v.c_str()); };
     parsers["mark_broken_preset_key"] = [&config](const std::string& v){ config.mark_broken_preset_key = SDL_GetKeyFromName(v.c_str()); };
     parsers["favorite_preset_key"] = [&config](const std::string& v){ config.favorite_preset_key = SDL_GetKeyFromName(v.c_str()); };
+    parsers["max_preset_complexity"] = [&config](const std::string& v){ config.max_preset_complexity = std::stof(v); };
+    parsers["preset_quarantine_file"] = [&config](const std::string& v){ config.preset_quarantine_file = v; };
+    parsers["preset_cost_report"] = [&config](const std::string& v){ config.preset_cost_report = v; };
+    parsers["max_preset_frame_ms"] = [&config](const std::string& v){ config.max_preset_frame_ms = std::stof(v); };
     parsers["use_default_projectm_visualizer"] = [&config](const std::string& v){ config.use_default_projectm_visualizer = (v == "true"); };
+    return parsers;
+}
+
+void ConfigLoader::load_from_file(Config& config, const std::string &path) {
+    std::ifstream configFile(path);
+    if (!configFile.is_open()) {
+        Logger::warn("Could not open config file ", path, ". Using defaults.");
+        return;
+    }
 
+    ConfigParsers parsers = make_parsers(config);
     std::string line;
     while (std::getline(configFile, line)) {
         auto commentPos = line.find('#');
@@ -155,4 +180,18 @@ void ConfigLoader::load_from_file(Config& config, const std::string &path) {
             }
         }
     }
-}
\ No newline at end of file
+}
+
+bool ConfigLoader::apply(Config& config, const std::string& key, const std::string& value) {
+    ConfigParsers parsers = make_parsers(config);
+    auto it = parsers.find(key);
+    if (it == parsers.end()) {
+        return false;
+    }
+    try {
+        it->second(remove_quotes(trim(value)));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,129 @@
+// src/ExportCheckpoint.cpp
+#include "ExportCheckpoint.h"
+#include "utils/Logger.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+const char* CHECKPOINT_EXTENSION = ".checkpoint";
+}
+
+std::string ExportCheckpoint::path_for(const std::string& output_path) {
+    return output_path + CHECKPOINT_EXTENSION;
+}
+
+std::string ExportCheckpoint::canonical_path(const std::string& path) {
+    std::error_code error;
+    const fs::path canonical = fs::weakly_canonical(fs::absolute(path, error), error);
+    return error ? path : canonical.string();
+}
+
+std::string ExportCheckpoint::chunk_path(const std::string& output_path, int chunk) {
+    const std::string extension = fs::path(output_path).extension().string();
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".chunk%03d", chunk);
+    return output_path.substr(0, output_path.size() - extension.size()) + suffix + extension;
+}
+
+bool ExportCheckpoint::save() const {
+    const std::string path = path_for(output_path);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        file.precision(17);
+        file << "audio_path = " << audio_path << "\n"
+             << "output_path = " << output_path << "\n"
+             << "encoder = " << encoder << "\n"
+             << "width = " << width << "\n"
+             << "height = " << height << "\n"
+             << "fps = " << fps << "\n"
+             << "frames = " << frames << "\n"
+             << "chunk_frames = " << chunk_frames << "\n"
+             << "preset_duration = " << preset_duration << "\n"
+             << "completed_chunks = " << completed_chunks << "\n"
+             << "next_frame = " << next_frame << "\n"
+             << "audio_sample = " << audio_sample << "\n"
+             << "seed = " << seed << "\n"
+             << "preset_slot = " << preset_slot << "\n"
+             << "animation_rng = " << animation_rng << "\n";
+        if (!file.flush()) {
+            Logger::error("Could not write checkpoint ", temporary);
+            return false;
+        }
+    }
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    if (error) {
+        Logger::error("Could not write checkpoint ", path, ": ", error.message());
+        return false;
+    }
+    return true;
+}
+
+bool ExportCheckpoint::load(const std::string& path, ExportCheckpoint& checkpoint) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    checkpoint = ExportCheckpoint();
+    try {
+        for (std::string line; std::getline(file, line);) {
+            const size_t equals = line.find(" = ");
+            if (equals == std::string::npos) continue;
+            const std::string key = line.substr(0, equals);
+            const std::string value = line.substr(equals + 3);
+            if (key == "audio_path") checkpoint.audio_path = value;
+            else if (key == "output_path") checkpoint.output_path = value;
+            else if (key == "encoder") checkpoint.encoder = std::stoull(value);
+            else if (key == "width") checkpoint.width = std::stoi(value);
+            else if (key == "height") checkpoint.height = std::stoi(value);
+            else if (key == "fps") checkpoint.fps = std::stoi(value);
+            else if (key == "frames") checkpoint.frames = std::stoi(value);
+            else if (key == "chunk_frames") checkpoint.chunk_frames = std::stoi(value);
+            else if (key == "preset_duration") checkpoint.preset_duration = std::stod(value);
+            else if (key == "completed_chunks") checkpoint.completed_chunks = std::stoi(value);
+            else if (key == "next_frame") checkpoint.next_frame = std::stoi(value);
+            else if (key == "audio_sample") checkpoint.audio_sample = std::stoull(value);
+            else if (key == "seed") checkpoint.seed = std::stoull(value);
+            else if (key == "preset_slot") checkpoint.preset_slot = std::stoull(value);
+            else if (key == "animation_rng") checkpoint.animation_rng = value;
+        }
+    } catch (const std::exception&) {
+        Logger::error("Corrupt checkpoint ", path);
+        return false;
+    }
+    if (checkpoint.output_path.empty() || checkpoint.chunk_frames <= 0) {
+        Logger::error("Incomplete checkpoint ", path);
+        return false;
+    }
+    return true;
+}
+
+bool ExportCheckpoint::find(const std::string& directory, const std::string& audio_path, ExportCheckpoint& checkpoint) {
+    const std::string track = canonical_path(audio_path);
+    std::error_code error;
+    for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        if (it->path().extension() == CHECKPOINT_EXTENSION && load(it->path().string(), checkpoint) &&
+            checkpoint.audio_path == track) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ExportCheckpoint::compatible_with(const ExportCheckpoint& other) const {
+    return audio_path == other.audio_path && output_path == other.output_path && encoder == other.encoder &&
+           width == other.width && height == other.height && fps == other.fps && frames == other.frames &&
+           chunk_frames == other.chunk_frames && preset_duration == other.preset_duration && seed == other.seed;
+}
+
+void ExportCheckpoint::remove_files() const {
+    std::error_code error;
+    for (int chunk = 0; chunk * chunk_frames < frames; ++chunk) {
+        fs::remove(chunk_path(output_path, chunk), error);
+    }
+    fs::remove(path_for(output_path), error);
+}
@@ -0,0 +1,241 @@
+// src/GlyphRasterizer.cpp
+#include "GlyphRasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include FT_MODULE_H
+
+#if FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 11)
+#define AURORA_FREETYPE_SDF 1
+#else
+#define AURORA_FREETYPE_SDF 0
+#endif
+
+namespace {
+
+const float DT_INFINITY = 1e20f;
+
+// Exact 1D squared Euclidean distance transform (Felzenszwalb & Huttenlocher).
+void distance_transform_1d(const float* f, int n, float* d, int* v, float* z) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -DT_INFINITY;
+    z[1] = DT_INFINITY;
+    for (int q = 1; q < n; ++q) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+        while (s <= z[k]) {
+            --k;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = DT_INFINITY;
+    }
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (z[k + 1] < q) ++k;
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+// In place: grid holds 0 at feature pixels and DT_INFINITY elsewhere; on return,
+// the squared distance from each pixel to the nearest feature pixel.
+void distance_transform_2d(std::vector<float>& grid, int width, int height) {
+    const int n = std::max(width, height);
+    std::vector<float> f(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+    for (int x = 0; x < width; ++x) {
+        for (int y = 0; y < height; ++y) f[y] = grid[y * width + x];
+        distance_transform_1d(f.data(), height, d.data(), v.data(), z.data());
+        for (int y = 0; y < height; ++y) grid[y * width + x] = d[y];
+    }
+    for (int y = 0; y < height; ++y) {
+        distance_transform_1d(grid.data() + y * width, width, d.data(), v.data(), z.data());
+        std::copy(d.begin(), d.begin() + width, grid.begin() + y * width);
+    }
+}
+
+} // namespace
+
+GlyphRasterizer::GlyphRasterizer() : _ft(nullptr), _face(nullptr), _pixel_size(0), _spread(0) {}
+
+GlyphRasterizer::~GlyphRasterizer() {
+    cleanup();
+}
+
+void GlyphRasterizer::cleanup() {
+    if (_face) FT_Done_Face(_face);
+    if (_ft) FT_Done_FreeType(_ft);
+    _face = nullptr;
+    _ft = nullptr;
+}
+
+bool GlyphRasterizer::init(const std::string& font_path, int pixel_size, int spread) {
+    cleanup();
+    if (FT_Init_FreeType(&_ft)) return false;
+    if (FT_New_Face(_ft, font_path.c_str(), 0, &_face)) return false;
+    FT_Set_Pixel_Sizes(_face, 0, pixel_size);
+    _pixel_size = pixel_size;
+    _spread = spread;
+#if AURORA_FREETYPE_SDF
+    FT_Property_Set(_ft, "sdf", "spread", &_spread);
+    FT_Property_Set(_ft, "bsdf", "spread", &_spread);
+#endif
+    return true;
+}
+
+bool GlyphRasterizer::rasterize(uint32_t codepoint, GlyphBitmap& out) {
+    if (!_face || FT_Load_Char(_face, codepoint, FT_LOAD_DEFAULT)) {
+        return false;
+    }
+    FT_GlyphSlot slot = _face->glyph;
+    out.advance = static_cast<unsigned int>(slot->advance.x);
+    out.pixels.clear();
+    out.width = out.height = out.bearing_x = out.bearing_y = 0;
+    if (slot->format == FT_GLYPH_FORMAT_OUTLINE && slot->outline.n_points == 0) {
+        return true; // Whitespace: an advance but nothing to draw.
+    }
+
+#if AURORA_FREETYPE_SDF
+    if (FT_Render_Glyph(slot, FT_RENDER_MODE_SDF) == 0 && slot->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY) {
+        const FT_Bitmap& bitmap = slot->bitmap;
+        out.width = static_cast<int>(bitmap.width);
+        out.height = static_cast<int>(bitmap.rows);
+        out.bearing_x = slot->bitmap_left;
+        out.bearing_y = slot->bitmap_top;
+        out.pixels.resize(static_cast<size_t>(out.width) * out.height);
+        for (int row = 0; row < out.height; ++row) {
+            memcpy(out.pixels.data() + row * out.width, bitmap.buffer + row * bitmap.pitch, out.width);
+        }
+        return true;
+    }
+    // Fonts the SDF module cannot handle (e.g. some bitmap strikes) take the slow path.
+    if (FT_Load_Char(_face, codepoint, FT_LOAD_DEFAULT)) {
+        return false;
+    }
+#endif
+    return rasterize_with_distance_transform(out);
+}
+
+bool GlyphRasterizer::load_advance(uint32_t codepoint, unsigned int& advance) {
+    if (!_face || FT_Load_Char(_face, codepoint, FT_LOAD_DEFAULT)) {
+        return false;
+    }
+    advance = static_cast<unsigned int>(_face->glyph->advance.x);
+    return true;
+}
+
+int GlyphRasterizer::kerning(uint32_t left, uint32_t right) {
+    if (!has_kerning()) {
+        return 0;
+    }
+    FT_Vector delta;
+    if (FT_Get_Kerning(_face, FT_Get_Char_Index(_face, left), FT_Get_Char_Index(_face, right),
+                       FT_KERNING_DEFAULT, &delta)) {
+        return 0;
+    }
+    return static_cast<int>(delta.x);
+}
+
+bool GlyphRasterizer::rasterize_with_distance_transform(GlyphBitmap& out) {
+    FT_GlyphSlot slot = _face->glyph;
+    if (FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL) || slot->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY) {
+        return false;
+    }
+    const FT_Bitmap& bitmap = slot->bitmap;
+    const int source_width = static_cast<int>(bitmap.width);
+    const int source_height = static_cast<int>(bitmap.rows);
+    out.width = source_width + 2 * _spread;
+    out.height = source_height + 2 * _spread;
+    out.bearing_x = slot->bitmap_left - _spread;
+    out.bearing_y = slot->bitmap_top + _spread;
+
+    // Squared distances to the nearest inside pixel and to the nearest outside pixel.
+    const size_t count = static_cast<size_t>(out.width) * out.height;
+    std::vector<float> to_inside(count, DT_INFINITY), to_outside(count, 0.0f);
+    for (int y = 0; y < source_height; ++y) {
+        for (int x = 0; x < source_width; ++x) {
+            if (bitmap.buffer[y * bitmap.pitch + x] >= 128) {
+                size_t i = static_cast<size_t>(y + _spread) * out.width + x + _spread;
+                to_inside[i] = 0.0f;
+                to_outside[i] = DT_INFINITY;
+            }
+        }
+    }
+    distance_transform_2d(to_inside, out.width, out.height);
+    distance_transform_2d(to_outside, out.width, out.height);
+
+    // Pixel centres sit half a pixel from the edge between them, hence the 0.5.
+    out.pixels.resize(count);
+    const float scale = 128.0f / std::max(1, _spread);
+    for (size_t i = 0; i < count; ++i) {
+        float distance = to_outside[i] > 0.0f ? std::sqrt(to_outside[i]) - 0.5f : 0.5f - std::sqrt(to_inside[i]);
+        out.pixels[i] = static_cast<unsigned char>(std::clamp(128.0f + distance * scale, 0.0f, 255.0f));
+    }
+    return true;
+}
+
+AsyncGlyphRasterizer::~AsyncGlyphRasterizer() {
+    stop();
+}
+
+bool AsyncGlyphRasterizer::start(const std::string& font_path, int pixel_size, int spread) {
+    stop();
+    if (!_rasterizer.init(font_path, pixel_size, spread)) {
+        return false;
+    }
+    _stop = false;
+    _thread = std::thread(&AsyncGlyphRasterizer::run, this);
+    return true;
+}
+
+void AsyncGlyphRasterizer::stop() {
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_one();
+        _thread.join();
+    }
+    _requests.clear();
+    _results.clear();
+    _rasterizer.cleanup();
+}
+
+void AsyncGlyphRasterizer::request(uint32_t codepoint) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _requests.push_back(codepoint);
+    }
+    _wake.notify_one();
+}
+
+void AsyncGlyphRasterizer::collect(std::vector<std::pair<uint32_t, GlyphBitmap>>& out) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& result : _results) {
+        out.push_back(std::move(result));
+    }
+    _results.clear();
+}
+
+void AsyncGlyphRasterizer::run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _wake.wait(lock, [this] { return _stop || !_requests.empty(); });
+        if (_stop) {
+            return;
+        }
+        uint32_t codepoint = _requests.front();
+        _requests.pop_front();
+
+        lock.unlock();
+        GlyphBitmap glyph;
+        if (!_rasterizer.rasterize(codepoint, glyph)) {
+            glyph = GlyphBitmap{};
+        }
+        lock.lock();
+        _results.emplace_back(codepoint, std::move(glyph));
+    }
+}
@@ -0,0 +1,112 @@
+// src/GpuTimer.cpp
+#include "GpuTimer.h"
+#include "utils/Logger.h"
+
+namespace {
+// A handful of stages per frame, read back a few frames late.
+const size_t QUERY_RING_SIZE = 64;
+}
+
+GpuTimer::GpuTimer() : _head(0), _pending(0), _running(false), _dropped(0), _enabled(false) {}
+
+GpuTimer::~GpuTimer() {
+    cleanup();
+}
+
+bool GpuTimer::init() {
+    if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query) {
+        Logger::info("GPU timer queries are not available; stage timings are off.");
+        return false;
+    }
+    _queries.resize(QUERY_RING_SIZE);
+    _queryStage.assign(QUERY_RING_SIZE, 0);
+    glGenQueries(static_cast<GLsizei>(_queries.size()), _queries.data());
+    _head = 0;
+    _pending = 0;
+    _running = false;
+    _enabled = true;
+    return true;
+}
+
+void GpuTimer::cleanup() {
+    if (!_queries.empty()) {
+        if (_running) glEndQuery(GL_TIME_ELAPSED);
+        glDeleteQueries(static_cast<GLsizei>(_queries.size()), _queries.data());
+        _queries.clear();
+    }
+    _running = false;
+    _enabled = false;
+}
+
+size_t GpuTimer::add_stage(const std::string& name) {
+    _stages.emplace_back();
+    _stages.back().name = name;
+    return _stages.size() - 1;
+}
+
+void GpuTimer::begin(size_t stage) {
+    if (!_enabled || _running) {
+        return;
+    }
+    if (_pending == _queries.size()) {
+        _dropped++; // Every query is still in flight; reusing one would stall.
+        return;
+    }
+    _queryStage[_head] = stage;
+    glBeginQuery(GL_TIME_ELAPSED, _queries[_head]);
+    _running = true;
+}
+
+void GpuTimer::end() {
+    if (!_running) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    _running = false;
+    _head = (_head + 1) % _queries.size();
+    _pending++;
+}
+
+void GpuTimer::collect() {
+    // Queries finish in the order they were issued, so stop at the first that is not ready.
+    while (_pending > 0) {
+        const size_t slot = (_head + _queries.size() - _pending) % _queries.size();
+        GLint available = 0;
+        glGetQueryObjectiv(_queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(_queries[slot], GL_QUERY_RESULT, &elapsed_ns);
+        record(_queryStage[slot], elapsed_ns / 1e6);
+        _pending--;
+    }
+}
+
+void GpuTimer::record(size_t stage, double ms) {
+    Stage& s = _stages[stage];
+    s.total.add(ms);
+    if (s.recent[s.active].count() >= RECENT_SAMPLES) {
+        s.active ^= 1;
+        s.recent[s.active].reset();
+    }
+    s.recent[s.active].add(ms);
+}
+
+Histogram GpuTimer::recent(size_t stage) const {
+    Histogram merged = _stages[stage].recent[0];
+    merged.merge(_stages[stage].recent[1]);
+    return merged;
+}
+
+std::string GpuTimer::report() const {
+    std::string report;
+    for (const auto& stage : _stages) {
+        if (!stage.total.count()) continue;
+        report += "gpu " + stage.name + " (ms): " + stage.total.summary() + "\n";
+    }
+    if (_dropped) {
+        report += "gpu timer: " + std::to_string(_dropped) + " stages unmeasured, query ring full\n";
+    }
+    return report;
+}
@@ -2,36 +2,118 @@
 #include "Gui.h"
 #include "core.h"
 #include "ImGuiIntegration.h"
+#include "Metrics.h"
 #include "renderer.h"
 #include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
 
-Gui::Gui(Config& config, Core& core) : _config(config), _core(core), _window(nullptr) {}
+Gui::Gui(Config& config, Core& core)
+    : _config(config), _core(core), _window(nullptr), _initialized(false), _visible(config.show_hud) {}
 
 Gui::~Gui() {}
 
 bool Gui::init(SDL_Window* window, SDL_GLContext context) {
     _window = window;
     ImGuiIntegration::init(_window, context);
+    _initialized = true;
     return true;
 }
 
-void Gui::render() {
+void Gui::render(const HudFrame& frame) {
+    if (!_initialized || !_visible) {
+        return;
+    }
     ImGuiIntegration::new_frame();
 
-    // Create a window to display the visualization
-    ImGui::Begin("Visualization");
-    ImVec2 window_size = ImGui::GetContentRegionAvail();
-    // The FBO texture is rendered upside down, so we need to flip the V coordinate
-    ImGui::Image((ImTextureID)(intptr_t)_core.get_renderer().get_fbo_texture(), window_size, ImVec2(0, 1), ImVec2(1, 0));
-    ImGui::End();
+    render_performance(frame);
+    render_preset_search();
 
     ImGuiIntegration::render();
 }
 
-void Gui::handle_event(SDL_Event& event) {
+void Gui::render_performance(const HudFrame& frame) {
+    _frame_ms[_frame_index] = frame.frame_ms;
+    _frame_index = (_frame_index + 1) % FRAME_HISTORY;
+    const size_t stage_count = std::min(frame.stage_count, HudFrame::MAX_STAGES);
+    for (size_t i = 0; i < stage_count; ++i) {
+        _stage_ms[i] += 0.1f * (frame.stage_ms[i] - _stage_ms[i]);
+    }
+
+    ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.6f);
+    ImGui::Begin("Performance", nullptr,
+                 ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav);
+
+    // Text goes through ImGui's own format buffer, so drawing the HUD allocates nothing per frame.
+    const float budget_ms = 1000.0f / std::max(1, _config.fps);
+    char label[64];
+    std::snprintf(label, sizeof(label), "%.2f ms / %.1f ms", frame.frame_ms, budget_ms);
+    ImGui::PlotLines("##frame_ms", _frame_ms.data(), static_cast<int>(FRAME_HISTORY), static_cast<int>(_frame_index), label,
+                     0.0f, 2.0f * budget_ms, ImVec2(260.0f, 60.0f));
+    for (size_t i = 0; i < stage_count; ++i) {
+        ImGui::Text("%-10s %6.2f ms", frame.stage_names[i], _stage_ms[i]);
+    }
+
+    ImGui::Separator();
+    const Metrics& metrics = Metrics::get();
+    ImGui::Text("Preset load  %.1f ms", metrics.preset_last_load_us.load(std::memory_order_relaxed) / 1000.0);
+    if (_config.enable_recording) {
+        const double frame_bytes = static_cast<double>(metrics.encoder_frame_bytes.load(std::memory_order_relaxed));
+        const double queued = static_cast<double>(metrics.encoder_queue_bytes.load(std::memory_order_relaxed));
+        ImGui::Text("Encoder      %.1f frames queued (%.1f MB)", frame_bytes > 0 ? queued / frame_bytes : 0.0,
+                    queued / (1024.0 * 1024.0));
+    }
+
+    // The device buffer drains from full at the last callback to empty when the next one is due.
+    const int64_t buffer_ns = metrics.audio_buffer_ns.load(std::memory_order_relaxed);
+    float audio_fill = 0.0f;
+    if (buffer_ns > 0) {
+        const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch()).count();
+        const int64_t elapsed_ns = now_ns - metrics.audio_last_callback_ns.load(std::memory_order_relaxed);
+        audio_fill = std::clamp(1.0f - static_cast<float>(elapsed_ns) / buffer_ns, 0.0f, 1.0f);
+    }
+    std::snprintf(label, sizeof(label), "Audio buffer %.0f%%, %llu underruns", audio_fill * 100.0f,
+                  static_cast<unsigned long long>(metrics.audio_underruns.load(std::memory_order_relaxed)));
+    ImGui::ProgressBar(audio_fill, ImVec2(260.0f, 0.0f), label);
+    ImGui::End();
+}
+
+void Gui::render_preset_search() {
+    ImGui::Begin("Presets");
+    // Re-query on every edit; the index answers in well under a millisecond. Labels
+    // are built here too, so frames without an edit allocate nothing.
+    if (ImGui::InputText("Search", _search_query, sizeof(_search_query))) {
+        _search_results = _core.get_preset_manager().search_presets(_search_query);
+        _search_labels.clear();
+        for (const auto& preset : _search_results) {
+            _search_labels.push_back(std::filesystem::path(preset).stem().string() + "##" + preset);
+        }
+    }
+    for (size_t i = 0; i < _search_results.size(); ++i) {
+        if (ImGui::Selectable(_search_labels[i].c_str())) {
+            _core.request_preset(_search_results[i]);
+        }
+    }
+    ImGui::End();
+}
+
+bool Gui::handle_event(SDL_Event& event) {
+    if (!_initialized || !_visible) {
+        return false;
+    }
     ImGuiIntegration::process_event(event);
+    const bool keyboard = event.type == SDL_KEYDOWN || event.type == SDL_KEYUP || event.type == SDL_TEXTINPUT;
+    return keyboard && ImGui::GetIO().WantCaptureKeyboard;
 }
 
 void Gui::cleanup() {
+    if (!_initialized) {
+        return;
+    }
     ImGuiIntegration::cleanup();
+    _initialized = false;
 }
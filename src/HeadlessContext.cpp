@@ -0,0 +1,77 @@
+// src/HeadlessContext.cpp
+#include "HeadlessContext.h"
+#include "utils/Logger.h"
+#include <GL/glew.h>
+#include <cstdlib>
+
+HeadlessContext::HeadlessContext() : _window(nullptr), _context(nullptr), _sdl_initialized(false) {}
+
+HeadlessContext::~HeadlessContext() {
+    cleanup();
+}
+
+bool HeadlessContext::init(int width, int height) {
+    if (!create_window(width, height)) {
+        // No display (e.g. on a render node): retry with SDL's EGL-backed offscreen driver.
+        if (getenv("SDL_VIDEODRIVER")) {
+            return false;
+        }
+        Logger::info("No display available, retrying with the offscreen video driver.");
+        cleanup();
+        SDL_setenv("SDL_VIDEODRIVER", "offscreen", 1);
+        if (!create_window(width, height)) {
+            return false;
+        }
+    }
+
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        Logger::error("glewInit failed in headless context.");
+        return false;
+    }
+    // GLEW can leave a spurious GL_INVALID_ENUM behind on core profiles.
+    glGetError();
+    return true;
+}
+
+bool HeadlessContext::create_window(int width, int height) {
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        Logger::error("SDL_Init failed: ", SDL_GetError());
+        return false;
+    }
+    _sdl_initialized = true;
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+
+    _window = SDL_CreateWindow("Aurora Visualizer (headless)", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                               width, height, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (!_window) {
+        Logger::error("SDL_CreateWindow failed: ", SDL_GetError());
+        return false;
+    }
+    _context = SDL_GL_CreateContext(_window);
+    if (!_context) {
+        Logger::error("SDL_GL_CreateContext failed: ", SDL_GetError());
+        return false;
+    }
+    // Never wait for vblank; headless frames are not presented.
+    SDL_GL_SetSwapInterval(0);
+    return true;
+}
+
+void HeadlessContext::cleanup() {
+    if (_context) {
+        SDL_GL_DeleteContext(_context);
+        _context = nullptr;
+    }
+    if (_window) {
+        SDL_DestroyWindow(_window);
+        _window = nullptr;
+    }
+    if (_sdl_initialized) {
+        SDL_Quit();
+        _sdl_initialized = false;
+    }
+}
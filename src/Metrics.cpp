@@ -0,0 +1,248 @@
+// src/Metrics.cpp
+#include "Metrics.h"
+#include "utils/Logger.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+AtomicHistogram::AtomicHistogram(std::initializer_list<double> bounds)
+    : _bounds(bounds), _buckets(new std::atomic<uint64_t>[bounds.size() + 1]), _sum_us(0) {
+    for (size_t i = 0; i <= _bounds.size(); ++i) _buckets[i].store(0, std::memory_order_relaxed);
+}
+
+void AtomicHistogram::observe(double value) {
+    size_t bucket = 0;
+    while (bucket < _bounds.size() && value > _bounds[bucket]) bucket++;
+    _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    _sum_us.fetch_add(static_cast<uint64_t>(std::llround(std::max(0.0, value) * 1e6)), std::memory_order_relaxed);
+}
+
+void AtomicHistogram::write(std::string& out, const char* name, const char* help) const {
+    char line[192];
+    std::snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    out += line;
+    // Buckets are read one at a time, so a scrape racing an update may be off by one; Prometheus tolerates that.
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < _bounds.size(); ++i) {
+        cumulative += _buckets[i].load(std::memory_order_relaxed);
+        std::snprintf(line, sizeof(line), "%s_bucket{le=\"%g\"} %llu\n", name, _bounds[i],
+                      static_cast<unsigned long long>(cumulative));
+        out += line;
+    }
+    cumulative += _buckets[_bounds.size()].load(std::memory_order_relaxed);
+    std::snprintf(line, sizeof(line), "%s_bucket{le=\"+Inf\"} %llu\n%s_sum %.6f\n%s_count %llu\n", name,
+                  static_cast<unsigned long long>(cumulative), name,
+                  _sum_us.load(std::memory_order_relaxed) / 1e6, name, static_cast<unsigned long long>(cumulative));
+    out += line;
+}
+
+namespace {
+
+void write_metric(std::string& out, const char* name, const char* type, const char* help, double value) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n%s %.17g\n", name, help, name, type, name, value);
+    out += line;
+}
+
+long resident_bytes() {
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) return -1;
+    long pages = 0, resident = 0;
+    const bool ok = std::fscanf(statm, "%ld %ld", &pages, &resident) == 2;
+    std::fclose(statm);
+    return ok ? resident * sysconf(_SC_PAGESIZE) : -1;
+}
+
+// Unlinks `path` only if it is a socket, so a mistyped --metrics-socket never deletes a
+// regular file. True when nothing is left at `path`.
+bool remove_socket_file(const std::string& path) {
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) {
+        return errno == ENOENT;
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        return false;
+    }
+    return unlink(path.c_str()) == 0 || errno == ENOENT;
+}
+
+} // namespace
+
+Metrics& Metrics::get() {
+    static Metrics metrics;
+    return metrics;
+}
+
+std::string Metrics::render() const {
+    auto value = [](const auto& metric) { return static_cast<double>(metric.load(std::memory_order_relaxed)); };
+    std::string out;
+    out.reserve(4096);
+    frame_seconds.write(out, "aurora_frame_seconds", "CPU time spent on each frame, excluding the pacing sleep.");
+    write_metric(out, "aurora_frames_total", "counter", "Frames rendered.", value(frames));
+    write_metric(out, "aurora_late_frames_total", "counter", "Frames whose work exceeded the frame budget.", value(late_frames));
+    write_metric(out, "aurora_dropped_frames_total", "counter", "Frame intervals missed because of late frames.", value(dropped_frames));
+
+    write_metric(out, "aurora_encoder_frames_total", "counter", "Frames written to the encoder.", value(encoder_frames));
+    write_metric(out, "aurora_encoder_bytes_total", "counter", "Bytes written to the encoder.", value(encoder_bytes));
+    write_metric(out, "aurora_encoder_queue_bytes", "gauge", "Bytes written to the encoder pipe and not yet consumed.", value(encoder_queue_bytes));
+    const double frame_bytes = value(encoder_frame_bytes);
+    write_metric(out, "aurora_encoder_queue_frames", "gauge", "Encoder backlog in frames.",
+                 frame_bytes > 0 ? value(encoder_queue_bytes) / frame_bytes : 0.0);
+    write_metric(out, "aurora_encoder_blocked_seconds_total", "counter", "Time the render loop spent writing to the encoder.",
+                 value(encoder_blocked_us) / 1e6);
+
+    write_metric(out, "aurora_audio_callbacks_total", "counter", "Audio buffers passed to projectM.", value(audio_callbacks));
+    write_metric(out, "aurora_audio_underruns_total", "counter", "Audio callbacks that arrived later than the buffer they replace lasted.",
+                 value(audio_underruns));
+
+    write_metric(out, "aurora_preset_index", "gauge", "Position of the current preset in the sorted preset list (-1 if none).",
+                 value(preset_index));
+    write_metric(out, "aurora_preset_loads_total", "counter", "Preset loads.", value(preset_loads));
+    write_metric(out, "aurora_preset_load_failures_total", "counter", "Preset loads that failed.", value(preset_load_failures));
+    preset_load_seconds.write(out, "aurora_preset_load_seconds", "Time to load a preset.");
+    write_metric(out, "aurora_preset_last_load_seconds", "gauge", "Time the most recent preset took to load.",
+                 value(preset_last_load_us) / 1e6);
+
+    write_metric(out, "aurora_resident_memory_bytes", "gauge", "Resident set size of the process.",
+                 static_cast<double>(resident_bytes()));
+    write_metric(out, "aurora_gl_memory_estimate_bytes", "gauge", "Estimated GPU memory in our own render targets and textures.",
+                 value(gl_memory_estimate_bytes));
+    const int64_t available_kb = gl_memory_available_kb.load(std::memory_order_relaxed);
+    if (available_kb >= 0) {
+        write_metric(out, "aurora_gl_memory_available_bytes", "gauge", "GPU memory available, as reported by the driver.",
+                     available_kb * 1024.0);
+    }
+    return out;
+}
+
+MetricsServer::MetricsServer() : _listen_fd(-1), _running(false) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(const std::string& listen) {
+    if (listen.rfind("unix:", 0) == 0) {
+        _socket_path = listen.substr(5);
+        sockaddr_un address{};
+        if (_socket_path.empty() || _socket_path.size() >= sizeof(address.sun_path)) {
+            Logger::error("Invalid metrics socket path: ", _socket_path);
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        memcpy(address.sun_path, _socket_path.c_str(), _socket_path.size() + 1);
+        // A stale socket from a previous run is replaced; anything else is left alone.
+        if (!remove_socket_file(_socket_path)) {
+            Logger::error("Not starting the metrics server: ", _socket_path, " exists and is not a socket.");
+            _socket_path.clear();
+            return false;
+        }
+        _listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (_listen_fd < 0 || bind(_listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            Logger::error("Could not bind metrics socket ", _socket_path, ": ", strerror(errno));
+            stop();
+            return false;
+        }
+    } else {
+        std::string host = "127.0.0.1";
+        std::string port = listen;
+        size_t colon = listen.rfind(':');
+        if (colon != std::string::npos) {
+            host = listen.substr(0, colon);
+            port = listen.substr(colon + 1);
+        }
+        if (host == "localhost") {
+            host = "127.0.0.1";
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(std::atoi(port.c_str())));
+        if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1 || address.sin_port == 0) {
+            Logger::error("Invalid metrics address: ", listen, " (expected [host:]port or unix:/path)");
+            return false;
+        }
+        // The endpoint has no authentication; it is for this machine only.
+        if ((ntohl(address.sin_addr.s_addr) >> 24) != 127) {
+            Logger::error("Not serving metrics on ", host, ": only loopback addresses (127.x.x.x) or unix:/path are allowed.");
+            return false;
+        }
+        _listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int reuse = 1;
+        if (_listen_fd >= 0) setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (_listen_fd < 0 || bind(_listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            Logger::error("Could not bind metrics address ", listen, ": ", strerror(errno));
+            stop();
+            return false;
+        }
+    }
+    if (::listen(_listen_fd, 8) < 0) {
+        Logger::error("Could not listen for metrics on ", listen, ": ", strerror(errno));
+        stop();
+        return false;
+    }
+    _running = true;
+    _thread = std::thread([this] { run(); });
+    Logger::info("Serving metrics on ", listen);
+    return true;
+}
+
+void MetricsServer::stop() {
+    _running = false;
+    if (_thread.joinable()) _thread.join();
+    if (_listen_fd >= 0) {
+        close(_listen_fd);
+        _listen_fd = -1;
+    }
+    if (!_socket_path.empty()) {
+        if (!remove_socket_file(_socket_path)) {
+            Logger::error("Leaving ", _socket_path, " in place: it is no longer a socket.");
+        }
+        _socket_path.clear();
+    }
+}
+
+void MetricsServer::run() {
+    while (_running) {
+        pollfd listener{_listen_fd, POLLIN, 0};
+        // Wake up now and then to notice stop().
+        if (poll(&listener, 1, 250) <= 0 || !(listener.revents & POLLIN)) continue;
+        int client = accept4(_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) continue;
+        serve(client);
+        close(client);
+    }
+}
+
+void MetricsServer::serve(int client) {
+    // Every path returns the metrics, so only wait for the end of the request headers.
+    char request[2048];
+    size_t received = 0;
+    while (received < sizeof(request) - 1) {
+        pollfd readable{client, POLLIN, 0};
+        if (poll(&readable, 1, 1000) <= 0) return;
+        ssize_t count = recv(client, request + received, sizeof(request) - 1 - received, 0);
+        if (count <= 0) return;
+        received += count;
+        request[received] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) break;
+    }
+
+    const std::string body = Metrics::get().render();
+    const std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                                 std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t count = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (count <= 0) return;
+        sent += count;
+    }
+}
@@ -0,0 +1,399 @@
+// src/OfflineRenderer.cpp
+#include "OfflineRenderer.h"
+#include "ExportCheckpoint.h"
+#include "QualityGovernor.h"
+#include "audio_input.h"
+#include "utils/Logger.h"
+#include "utils/Trace.h"
+#include "utils/common.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <filesystem>
+#include <cstdlib>
+#include <cstring>
+
+extern volatile sig_atomic_t g_quit_flag;
+
+namespace {
+enum OverlayBlock : size_t { OVERLAY_TITLE, OVERLAY_ARTIST, OVERLAY_URL };
+}
+
+OfflineRenderer::OfflineRenderer(const Config& config, PresetManager& presets)
+    : _config(config),
+      _presets(presets),
+      _text_manager(_text_renderer),
+      _overlay_compositor(_text_renderer),
+      _animation_manager(_config, _text_renderer),
+      _video_exporter(_config),
+      _pM(nullptr) {
+    // Every video frame is one step of video time, whatever the live frame rate is.
+    _config.fps = std::max(1, _config.video_framerate);
+    if (_config.render_width <= 0 || _config.render_height <= 0) {
+        _config.render_width = _config.width;
+        _config.render_height = _config.height;
+    }
+}
+
+OfflineRenderer::~OfflineRenderer() {
+    cleanup();
+}
+
+bool OfflineRenderer::init() {
+    if (!_context.init(_config.render_width, _config.render_height)) {
+        return false;
+    }
+    if (!_renderer.init(_context.window(), _context.context(), _config)) {
+        Logger::error("Failed to initialize the offline renderer.");
+        return false;
+    }
+    if (!_text_renderer.init(_config.font_path, _config.songInfoFontSize)) {
+        Logger::warn("Failed to load font ", _config.font_path, "; rendering without text overlays.");
+    }
+    _text_renderer.setProjection(_config.render_width, _config.render_height);
+    if (_text_renderer.is_initialized() && !_overlay_compositor.init()) {
+        Logger::warn("Overlay compositor unavailable; drawing overlay text directly.");
+    }
+    _overlay_compositor.setProjection(_config.render_width, _config.render_height);
+
+    _pM = projectm_create();
+    if (!_pM) {
+        Logger::error("Failed to create projectM instance.");
+        return false;
+    }
+    QualityGovernor quality;
+    quality.configure(false, _config.fps);
+    projectm_set_window_size(_pM, _config.render_width, _config.render_height);
+    projectm_set_mesh_size(_pM, quality.level().mesh_width, quality.level().mesh_height);
+    projectm_set_soft_cut_duration(_pM, _config.presetBlendTime);
+    // Presets change only on our schedule, never on projectM's own timer.
+    projectm_set_preset_locked(_pM, true);
+    return true;
+}
+
+bool OfflineRenderer::render(const OfflineJob& job, OfflineStats& stats, const ProgressCallback& progress) {
+    const auto start = std::chrono::steady_clock::now();
+    stats = OfflineStats();
+    if (!_pM) {
+        return false;
+    }
+    bool ok = false;
+    if (job.end_frame >= 0 && job.checkpoint_frames <= 0) {
+        // A segment only needs the audio of its preroll and its own frames, plus the
+        // track's length, which comes with the job when it was planned.
+        size_t track_samples = job.track_samples;
+        if (track_samples == 0 && !AudioInput::probe_length(job.audio_path, track_samples)) {
+            return false;
+        }
+        const size_t sample_rate = AudioInput::SAMPLE_RATE;
+        const size_t fps = _config.fps;
+        const int first_frame = std::clamp(job.first_frame, 0, frame_count(track_samples, _config.fps));
+        const size_t render_start = first_frame - preroll_frames(job, first_frame);
+        const size_t first_sample = std::min(track_samples, render_start * sample_rate / fps);
+        const size_t end_sample =
+            std::max(first_sample, std::min(track_samples, static_cast<size_t>(job.end_frame) * sample_rate / fps));
+        if (!AudioInput::decode_range(job.audio_path, first_sample, end_sample - first_sample, _pcm)) {
+            return false;
+        }
+        ok = render_samples(job, _pcm, first_sample, track_samples, stats, progress);
+    } else {
+        if (!AudioInput::decode_file(job.audio_path, _pcm)) {
+            return false;
+        }
+        ok = render_samples(job, _pcm, 0, _pcm.size() / 2, stats, progress);
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+int OfflineRenderer::frame_count(size_t sample_frames, int video_framerate) {
+    const size_t sample_rate = AudioInput::SAMPLE_RATE;
+    const size_t fps = std::max(1, video_framerate);
+    return static_cast<int>((sample_frames * fps + sample_rate - 1) / sample_rate);
+}
+
+bool OfflineRenderer::render(const OfflineJob& job, const std::vector<int16_t>& pcm, OfflineStats& stats,
+                             const ProgressCallback& progress) {
+    return render_samples(job, pcm, 0, pcm.size() / 2, stats, progress);
+}
+
+bool OfflineRenderer::render_samples(const OfflineJob& job, const std::vector<int16_t>& pcm, size_t pcm_first_sample,
+                                     size_t track_samples, OfflineStats& stats, const ProgressCallback& progress) {
+    TRACE_SCOPE("offline_render");
+    const auto start = std::chrono::steady_clock::now();
+    stats = OfflineStats();
+    if (!_pM) {
+        return false;
+    }
+    const size_t sample_frames = track_samples;
+    const size_t sample_rate = AudioInput::SAMPLE_RATE;
+    const int fps = _config.fps;
+    const int track_frames = frame_count(sample_frames, fps);
+    const double track_seconds = static_cast<double>(sample_frames) / sample_rate;
+    const bool checkpointed = job.checkpoint_frames > 0;
+    ExportCheckpoint checkpoint;
+    if (checkpointed && !prepare_checkpoint(job, sample_frames, checkpoint)) {
+        return false;
+    }
+    const int first_frame = checkpointed ? checkpoint.next_frame : std::clamp(job.first_frame, 0, track_frames);
+    const int end_frame = checkpointed || job.end_frame < 0 ? track_frames : std::min(job.end_frame, track_frames);
+    if (first_frame >= end_frame && !(checkpointed && track_frames > 0)) {
+        Logger::error("No audio in ", job.audio_path, " for frames ", first_frame, " to ", end_frame);
+        return false;
+    }
+    const int frames = end_frame - first_frame;
+    stats.audio_seconds = std::min(track_seconds, static_cast<double>(end_frame) / fps) - static_cast<double>(first_frame) / fps;
+    const int render_start = first_frame - preroll_frames(job, first_frame);
+
+    // projectM draws from the C library generator. Reseeding per segment cannot
+    // make a segment match a single-pass render, but it makes it reproducible.
+    enum SeedPoint : uint64_t { SEED_SEGMENT, SEED_CHUNK, SEED_PRESET };
+    auto reseed = [&](SeedPoint point, uint64_t position) {
+        const uint64_t key[3] = {job.seed, point, position};
+        std::srand(static_cast<unsigned>(fnv1a_64(key, sizeof(key))));
+    };
+    reseed(SEED_SEGMENT, static_cast<uint64_t>(first_frame));
+
+    _config.songTitle = sanitize_filename(job.audio_path);
+    std::vector<std::string> title_lines = _text_manager.split_text(_config.songTitle, _config.render_width, 1.0f);
+    const bool animate = _text_renderer.is_initialized() && _config.text_animation_enabled;
+    _animation_manager.seed(job.seed);
+    _animation_manager.reset(title_lines);
+    // The bouncing depends on every earlier frame; stepping it costs next to nothing next to rendering.
+    for (int frame = 0; animate && frame < render_start; ++frame) {
+        _animation_manager.update(track_seconds, static_cast<double>(frame) / fps);
+    }
+
+    // A checkpointed export goes to one chunk file per checkpoint, without audio.
+    auto open_output = [&](int frame) {
+        if (checkpointed) {
+            const std::string chunk = ExportCheckpoint::chunk_path(job.output_path, frame / checkpoint.chunk_frames);
+            return _video_exporter.start_export(_config.render_width, _config.render_height, "", chunk);
+        }
+        return _video_exporter.start_export(_config.render_width, _config.render_height, job.encode_audio ? job.audio_path : "",
+                                            job.output_path);
+    };
+    // Closes the chunk that ends before `frame` and records that everything before it is done.
+    auto close_chunk = [&](int frame) {
+        if (!_video_exporter.end_export()) {
+            return false;
+        }
+        checkpoint.completed_chunks = (frame + checkpoint.chunk_frames - 1) / checkpoint.chunk_frames;
+        checkpoint.next_frame = frame;
+        checkpoint.audio_sample = std::min(sample_frames, frame * sample_rate / fps);
+        checkpoint.preset_slot = preset_slot(frame);
+        checkpoint.animation_rng = _animation_manager.getRandomState();
+        return checkpoint.save();
+    };
+    if (first_frame < end_frame && !open_output(first_frame)) {
+        return false;
+    }
+
+    // Presets change on fixed slots of video time, so a segment knows what plays at any frame.
+    const bool use_presets = !_config.use_default_projectm_visualizer;
+    uint64_t slot = preset_slot(render_start);
+    if (use_presets) {
+        // A preset's random initial values depend only on its slot, not on when this run loaded it.
+        reseed(SEED_PRESET, slot);
+        _presets.load_preset(_pM, _presets.get_scheduled_preset(job.seed, slot), false);
+    }
+    const size_t row_bytes = static_cast<size_t>(_renderer.get_width()) * 3;
+
+    bool chunks_ok = true;
+    int frame = render_start;
+    for (; frame < end_frame && !g_quit_flag; ++frame) {
+        if (checkpointed && frame > first_frame && frame % checkpoint.chunk_frames == 0) {
+            chunks_ok = close_chunk(frame) && open_output(frame);
+            if (!chunks_ok) {
+                break;
+            }
+        }
+        // A checkpointed export is reseeded at every chunk, keyed by the chunk rather
+        // than by where this run started, so after a resume projectM draws the same
+        // numbers as in an export that never stopped.
+        if (checkpointed && frame >= first_frame && frame % checkpoint.chunk_frames == 0) {
+            reseed(SEED_CHUNK, static_cast<uint64_t>(frame / checkpoint.chunk_frames));
+        }
+        if (checkpointed && frame == first_frame && first_frame > 0 &&
+            checkpoint.animation_rng != _animation_manager.getRandomState()) {
+            Logger::warn("The text animation does not match the checkpoint; the title may jump where the export resumes.");
+        }
+        _text_renderer.beginFrame();
+        const double time = static_cast<double>(frame) / fps;
+        if (use_presets && preset_slot(frame) != slot) {
+            slot = preset_slot(frame);
+            reseed(SEED_PRESET, slot);
+            _presets.load_preset(_pM, _presets.get_scheduled_preset(job.seed, slot), true);
+        }
+
+        // Exactly the samples that play during this frame, so the video never drifts from its audio.
+        feed_audio(pcm, pcm_first_sample, std::min(sample_frames, frame * sample_rate / fps),
+                   std::min(sample_frames, (frame + 1) * sample_rate / fps));
+        projectm_set_frame_time(_pM, time);
+        _renderer.render(_pM);
+        if (animate) {
+            _animation_manager.update(track_seconds, time);
+        }
+        if (frame < first_frame) {
+            continue; // Preroll: projectM's feedback buffers and beat detection settle, nothing is encoded.
+        }
+
+        if (_text_renderer.is_initialized()) {
+            draw_overlays(title_lines);
+        }
+        _renderer.read_pixels(_frame_buffer);
+        _flipped_buffer.resize(_frame_buffer.size());
+        flip_rows(_frame_buffer.data(), _flipped_buffer.data(), row_bytes, _renderer.get_height());
+        _video_exporter.write_frame(_flipped_buffer.data());
+
+        if (progress && (frame - first_frame) % fps == 0) {
+            progress(frame - first_frame, frames);
+        }
+    }
+
+    bool encoded = false;
+    if (!checkpointed) {
+        encoded = _video_exporter.end_export();
+    } else if (frame < end_frame || !chunks_ok) {
+        _video_exporter.end_export(); // An unfinished chunk is rendered again on resume.
+    } else if (first_frame == end_frame || close_chunk(end_frame)) {
+        std::vector<std::string> chunks;
+        for (int chunk = 0; chunk * checkpoint.chunk_frames < end_frame; ++chunk) {
+            chunks.push_back(ExportCheckpoint::chunk_path(job.output_path, chunk));
+        }
+        encoded = VideoExporter::concatenate(chunks, job.audio_path, job.output_path);
+        if (encoded) {
+            checkpoint.remove_files();
+        }
+    }
+    stats.frames = std::max(0, frame - first_frame);
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (frame < end_frame || !chunks_ok) {
+        Logger::warn("Export of ", job.audio_path, " stopped after ", stats.frames, " of ", frames, " frames.",
+                     checkpointed ? " Run it again with --resume to continue." : "");
+        return false;
+    }
+    if (progress) {
+        progress(frames, frames);
+    }
+    return encoded;
+}
+
+bool OfflineRenderer::prepare_checkpoint(const OfflineJob& job, size_t sample_frames, ExportCheckpoint& checkpoint) const {
+    const int track_frames = frame_count(sample_frames, _config.fps);
+    checkpoint = ExportCheckpoint();
+    checkpoint.audio_path = ExportCheckpoint::canonical_path(job.audio_path);
+    checkpoint.output_path = ExportCheckpoint::canonical_path(job.output_path);
+    checkpoint.encoder = fnv1a_64(_config.ffmpeg_command, std::strlen(_config.ffmpeg_command));
+    checkpoint.width = _config.render_width;
+    checkpoint.height = _config.render_height;
+    checkpoint.fps = _config.fps;
+    checkpoint.frames = track_frames;
+    checkpoint.chunk_frames = job.checkpoint_frames;
+    checkpoint.preset_duration = _config.shuffleEnabled ? _config.presetDuration : 0.0;
+    checkpoint.seed = job.seed;
+    if (!job.resume) {
+        return true;
+    }
+
+    ExportCheckpoint saved;
+    if (!ExportCheckpoint::load(ExportCheckpoint::path_for(job.output_path), saved)) {
+        Logger::info("No checkpoint for ", job.output_path, "; starting from the beginning.");
+        return true;
+    }
+    if (!saved.compatible_with(checkpoint)) {
+        Logger::error("The checkpoint for ", job.output_path, " was saved with different settings; delete it to start over.");
+        return false;
+    }
+    // Where it says the export stands must be where these settings put that frame.
+    const int next_frame = saved.next_frame;
+    const uint64_t next_sample = static_cast<uint64_t>(std::max(0, next_frame)) * AudioInput::SAMPLE_RATE / _config.fps;
+    if (next_frame < 0 || next_frame > track_frames ||
+        saved.completed_chunks != (next_frame + saved.chunk_frames - 1) / saved.chunk_frames ||
+        saved.audio_sample != std::min<uint64_t>(sample_frames, next_sample) || saved.preset_slot != preset_slot(next_frame)) {
+        Logger::error("The checkpoint for ", job.output_path, " does not match its own frame ", next_frame,
+                      "; delete it to start over.");
+        return false;
+    }
+    for (int chunk = 0; chunk < saved.completed_chunks; ++chunk) {
+        if (!std::filesystem::exists(ExportCheckpoint::chunk_path(job.output_path, chunk))) {
+            Logger::error("Chunk ", chunk, " of ", job.output_path, " is missing; delete the checkpoint to start over.");
+            return false;
+        }
+    }
+    checkpoint = saved;
+    Logger::info("Resuming ", job.output_path, " at frame ", saved.next_frame, " of ", track_frames, " (",
+                 saved.completed_chunks, " chunks done).");
+    return true;
+}
+
+int OfflineRenderer::preroll_frames(const OfflineJob& job, int first_frame) const {
+    return std::min(first_frame, static_cast<int>(std::lround(std::max(0.0, job.preroll_seconds) * _config.fps)));
+}
+
+uint64_t OfflineRenderer::preset_slot(int frame) const {
+    if (!_config.shuffleEnabled || _config.presetDuration <= 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(static_cast<double>(frame) / _config.fps / _config.presetDuration);
+}
+
+void OfflineRenderer::feed_audio(const std::vector<int16_t>& pcm, size_t pcm_first_sample, size_t first_sample, size_t end_sample) {
+    // Only what was decoded; a range decode may stop a little short of what was asked for.
+    const size_t pcm_end_sample = pcm_first_sample + pcm.size() / 2;
+    first_sample = std::clamp(first_sample, pcm_first_sample, pcm_end_sample);
+    end_sample = std::clamp(end_sample, first_sample, pcm_end_sample);
+    const size_t count = (end_sample - first_sample) * 2;
+    if (count == 0) {
+        return;
+    }
+    _float_samples.resize(count);
+    AudioInput::pcm_to_float(pcm.data() + (first_sample - pcm_first_sample) * 2, _float_samples.data(), count);
+    projectm_pcm_add_float(_pM, _float_samples.data(), static_cast<unsigned int>(end_sample - first_sample), PROJECTM_STEREO);
+}
+
+void OfflineRenderer::draw_overlays(const std::vector<std::string>& title_lines) {
+    // The same blocks and styles as the live overlay in Core::run.
+    const float alpha = _config.text_animation_enabled ? _animation_manager.getAlpha() : 1.0f;
+    const float scale = _config.text_animation_enabled ? _animation_manager.getBreathingScale() : 1.0f;
+
+    OverlayTextStyle songInfoStyle;
+    songInfoStyle.color = _config.songInfoFontColor;
+    songInfoStyle.show_border = _config.show_text_border;
+    songInfoStyle.border_color = _config.songInfoBorderColor;
+    songInfoStyle.border_thickness = _config.songInfoBorderThickness;
+
+    if (_config.show_song_title) {
+        _overlay_compositor.setBlock(OVERLAY_TITLE, title_lines, _animation_manager.getTitleLineOffsets(), songInfoStyle);
+        glm::vec2 titlePos = _animation_manager.getTitleBlockPosition();
+        _overlay_compositor.drawBlock(OVERLAY_TITLE, titlePos.x, titlePos.y, scale, alpha);
+    }
+    if (_config.show_artist_name) {
+        _overlay_compositor.setBlock(OVERLAY_ARTIST, _config.artistName, songInfoStyle);
+        glm::vec2 artistPos = _animation_manager.getArtistPosition();
+        _overlay_compositor.drawBlock(OVERLAY_ARTIST, artistPos.x, artistPos.y, scale, alpha);
+    }
+    if (_config.show_url) {
+        OverlayTextStyle urlStyle;
+        urlStyle.scale = static_cast<float>(_config.urlFontSize) / static_cast<float>(_config.songInfoFontSize);
+        urlStyle.color = _config.urlFontColor;
+        urlStyle.show_border = _config.show_text_border;
+        urlStyle.border_color = _config.urlBorderColor;
+        urlStyle.border_thickness = _config.urlBorderThickness;
+        _overlay_compositor.setBlock(OVERLAY_URL, _config.urlText, urlStyle);
+        _overlay_compositor.drawBlock(OVERLAY_URL, 10, 10, scale, 1.0f);
+    }
+}
+
+void OfflineRenderer::cleanup() {
+    if (_pM) {
+        projectm_destroy(_pM);
+        _pM = nullptr;
+    }
+    _overlay_compositor.cleanup();
+    _text_renderer.cleanup();
+    _renderer.cleanup();
+    _context.cleanup();
+}
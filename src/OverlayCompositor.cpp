@@ -0,0 +1,277 @@
+// src/OverlayCompositor.cpp
+#include "OverlayCompositor.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+
+const char* quadVertexSource = R"glsl(
+#version 330 core
+layout (location = 0) in vec2 corner;
+out vec2 TexCoords;
+uniform mat4 projection;
+uniform vec4 rect; // x, y, width, height on screen
+void main() {
+    gl_Position = projection * vec4(rect.xy + corner * rect.zw, 0.0, 1.0);
+    TexCoords = corner;
+}
+)glsl";
+
+const char* quadFragmentSource = R"glsl(
+#version 330 core
+in vec2 TexCoords;
+out vec4 color;
+uniform sampler2D layer;
+uniform float alpha;
+void main() {
+    color = texture(layer, TexCoords) * alpha; // Premultiplied, so alpha scales every channel.
+}
+)glsl";
+
+GLuint compile_shader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        Logger::error("Overlay shader compilation failed: ", infoLog);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+} // namespace
+
+OverlayCompositor::OverlayCompositor(TextRenderer& textRenderer)
+    : _textRenderer(textRenderer), _shaderProgram(0), _vao(0), _vbo(0),
+      _projectionLoc(-1), _rectLoc(-1), _alphaLoc(-1), _width(0), _height(0), _initialized(false) {}
+
+OverlayCompositor::~OverlayCompositor() {
+    cleanup();
+}
+
+bool OverlayCompositor::init() {
+    GLuint vertexShader = compile_shader(GL_VERTEX_SHADER, quadVertexSource);
+    GLuint fragmentShader = compile_shader(GL_FRAGMENT_SHADER, quadFragmentSource);
+    if (!vertexShader || !fragmentShader) {
+        if (vertexShader) glDeleteShader(vertexShader);
+        if (fragmentShader) glDeleteShader(fragmentShader);
+        return false;
+    }
+    _shaderProgram = glCreateProgram();
+    glAttachShader(_shaderProgram, vertexShader);
+    glAttachShader(_shaderProgram, fragmentShader);
+    glLinkProgram(_shaderProgram);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    GLint success;
+    glGetProgramiv(_shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(_shaderProgram, 512, NULL, infoLog);
+        Logger::error("Overlay shader linking failed: ", infoLog);
+        cleanup();
+        return false;
+    }
+    _projectionLoc = glGetUniformLocation(_shaderProgram, "projection");
+    _rectLoc = glGetUniformLocation(_shaderProgram, "rect");
+    _alphaLoc = glGetUniformLocation(_shaderProgram, "alpha");
+
+    const float corners[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+    glGenVertexArrays(1, &_vao);
+    glGenBuffers(1, &_vbo);
+    glBindVertexArray(_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    _initialized = true;
+    return true;
+}
+
+void OverlayCompositor::cleanup() {
+    for (auto& block : _blocks) {
+        if (block.fbo) glDeleteFramebuffers(1, &block.fbo);
+        if (block.texture) glDeleteTextures(1, &block.texture);
+    }
+    _blocks.clear();
+    if (_vbo) glDeleteBuffers(1, &_vbo);
+    if (_vao) glDeleteVertexArrays(1, &_vao);
+    if (_shaderProgram) glDeleteProgram(_shaderProgram);
+    _shaderProgram = _vao = _vbo = 0;
+    _initialized = false;
+}
+
+void OverlayCompositor::setProjection(int width, int height) {
+    _width = width;
+    _height = height;
+}
+
+OverlayCompositor::Block& OverlayCompositor::block(size_t id) {
+    if (id >= _blocks.size()) {
+        _blocks.resize(id + 1);
+    }
+    return _blocks[id];
+}
+
+void OverlayCompositor::setBlock(size_t id, const std::vector<std::string>& lines, const std::vector<glm::vec2>& offsets,
+                                 const OverlayTextStyle& style) {
+    Block& b = block(id);
+    if (b.lines == lines && b.offsets == offsets && b.style == style) {
+        return;
+    }
+    b.lines = lines;
+    b.offsets = offsets;
+    b.offsets.resize(lines.size(), glm::vec2(0.0f));
+    b.style = style;
+    b.dirty = true;
+}
+
+void OverlayCompositor::setBlock(size_t id, const std::string& text, const OverlayTextStyle& style) {
+    Block& b = block(id);
+    if (b.lines.size() == 1 && b.lines[0] == text && b.offsets[0] == glm::vec2(0.0f) && b.style == style) {
+        return;
+    }
+    b.lines.assign(1, text);
+    b.offsets.assign(1, glm::vec2(0.0f));
+    b.style = style;
+    b.dirty = true;
+}
+
+bool OverlayCompositor::renderBlock(Block& b) {
+    // The texture covers every line's glyph quads, SDF padding included, since
+    // the border is drawn inside that padding.
+    const float padding = _textRenderer.getGlyphPadding(b.style.scale);
+    float min_x = 0.0f, min_y = 0.0f, max_x = 0.0f, max_y = 0.0f;
+    bool empty = true;
+    for (size_t i = 0; i < b.lines.size(); ++i) {
+        glm::vec4 bounds = _textRenderer.getTextBounds(b.lines[i], b.offsets[i].x, b.offsets[i].y, b.style.scale);
+        if (bounds.z <= 0.0f || bounds.w <= 0.0f) continue;
+        float x0 = bounds.x - padding, y0 = bounds.y - padding;
+        float x1 = bounds.x + bounds.z + padding, y1 = bounds.y + bounds.w + padding;
+        min_x = empty ? x0 : std::min(min_x, x0);
+        min_y = empty ? y0 : std::min(min_y, y0);
+        max_x = empty ? x1 : std::max(max_x, x1);
+        max_y = empty ? y1 : std::max(max_y, y1);
+        empty = false;
+    }
+    b.size = glm::ivec2(0);
+    if (empty) {
+        return true;
+    }
+    b.origin = glm::vec2(std::floor(min_x), std::floor(min_y));
+    const glm::ivec2 size(static_cast<int>(std::ceil(max_x - b.origin.x)), static_cast<int>(std::ceil(max_y - b.origin.y)));
+
+    if (!b.fbo) {
+        glGenFramebuffers(1, &b.fbo);
+        glGenTextures(1, &b.texture);
+    }
+    glBindTexture(GL_TEXTURE_2D, b.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previous_fbo = 0;
+    GLint previous_viewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_fbo);
+    glGetIntegerv(GL_VIEWPORT, previous_viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, b.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, b.texture, 0);
+    const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        const GLfloat transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glViewport(0, 0, size.x, size.y);
+        glClearBufferfv(GL_COLOR, 0, transparent);
+        _textRenderer.setProjection(size.x, size.y);
+        _textRenderer.setPremultipliedTarget(true);
+        for (size_t i = 0; i < b.lines.size(); ++i) {
+            _textRenderer.renderText(b.lines[i], b.offsets[i].x - b.origin.x, b.offsets[i].y - b.origin.y,
+                                     b.style.scale, b.style.color, 1.0f, b.style.show_border,
+                                     b.style.border_color, b.style.border_thickness);
+        }
+        _textRenderer.setPremultipliedTarget(false);
+        _textRenderer.setProjection(_width, _height);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, previous_fbo);
+    glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+
+    if (!complete) {
+        Logger::warn("Overlay framebuffer is incomplete; drawing overlay text directly.");
+        glDeleteFramebuffers(1, &b.fbo);
+        glDeleteTextures(1, &b.texture);
+        b.fbo = b.texture = 0;
+        return false;
+    }
+    b.size = size;
+    return true;
+}
+
+void OverlayCompositor::drawBlock(size_t id, float x, float y, float scale, float alpha) {
+    if (id >= _blocks.size()) {
+        return;
+    }
+    Block& b = _blocks[id];
+    if (!_initialized) {
+        drawBlockDirect(b, x, y, scale, alpha);
+        return;
+    }
+    if (b.dirty || b.atlas_generation != _textRenderer.getAtlasGeneration()) {
+        b.dirty = false;
+        bool rendered = renderBlock(b);
+        b.atlas_generation = _textRenderer.getAtlasGeneration();
+        if (!rendered) {
+            _initialized = false; // Stay on the direct path from now on.
+            drawBlockDirect(b, x, y, scale, alpha);
+            return;
+        }
+    }
+    if (b.size.x == 0 || b.size.y == 0 || alpha <= 0.0f) {
+        return;
+    }
+
+    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(_width), 0.0f, static_cast<float>(_height));
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(_shaderProgram);
+    glUniformMatrix4fv(_projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform4f(_rectLoc, x + b.origin.x * scale, y + b.origin.y * scale, b.size.x * scale, b.size.y * scale);
+    glUniform1f(_alphaLoc, alpha);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, b.texture);
+    glBindVertexArray(_vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    glDisable(GL_BLEND);
+}
+
+size_t OverlayCompositor::getTextureBytes() const {
+    size_t bytes = 0;
+    for (const Block& b : _blocks) {
+        if (b.texture) bytes += static_cast<size_t>(b.size.x) * b.size.y * 4;
+    }
+    return bytes;
+}
+
+void OverlayCompositor::drawBlockDirect(const Block& b, float x, float y, float scale, float alpha) {
+    for (size_t i = 0; i < b.lines.size(); ++i) {
+        _textRenderer.renderText(b.lines[i], x + b.offsets[i].x * scale, y + b.offsets[i].y * scale,
+                                 b.style.scale * scale, b.style.color, alpha, b.style.show_border,
+                                 b.style.border_color, b.style.border_thickness);
+    }
+}
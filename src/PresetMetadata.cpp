@@ -0,0 +1,164 @@
+// src/PresetMetadata.cpp
+#include "PresetMetadata.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <thread>
+
+namespace {
+
+struct ShapeState {
+    bool enabled = false;
+    int instances = 1;
+};
+
+// Parses the index in keys like "wavecode_3_enabled" where `prefix_len` skips "wavecode_".
+size_t parse_index(std::string_view key, size_t prefix_len) {
+    size_t value = 0;
+    for (size_t i = prefix_len; i < key.size() && key[i] >= '0' && key[i] <= '9'; ++i) {
+        value = value * 10 + (key[i] - '0');
+    }
+    return value;
+}
+
+int parse_int(std::string_view value) {
+    return std::atoi(std::string(value).c_str());
+}
+
+void parse_line(std::string_view line, PresetInfo& info, std::vector<bool>& waves, std::vector<ShapeState>& shapes) {
+    size_t eq = line.find('=');
+    if (eq == std::string_view::npos) {
+        return;
+    }
+    std::string_view key = line.substr(0, eq);
+    std::string_view value = line.substr(eq + 1);
+    auto starts_with = [&key](std::string_view prefix) { return key.substr(0, prefix.size()) == prefix; };
+    auto contains = [&key](std::string_view part) { return key.find(part) != std::string_view::npos; };
+
+    if (key == "fRating") {
+        info.rating = std::strtof(std::string(value).c_str(), nullptr);
+    } else if (starts_with("warp_")) {
+        info.has_warp_shader = true;
+        info.shader_lines++;
+    } else if (starts_with("comp_")) {
+        info.has_comp_shader = true;
+        info.shader_lines++;
+    } else if (starts_with("per_frame_init_")) {
+        // Runs once when the preset loads; irrelevant for steady-state cost.
+    } else if (starts_with("per_frame_")) {
+        info.per_frame_equations++;
+    } else if (starts_with("per_pixel_")) {
+        info.per_pixel_equations++;
+    } else if (starts_with("wave_") && contains("_per_point")) {
+        info.per_point_equations++;
+    } else if (starts_with("wavecode_") && contains("_enabled")) {
+        size_t index = parse_index(key, 9);
+        if (index >= waves.size()) waves.resize(index + 1, false);
+        waves[index] = parse_int(value) != 0;
+    } else if (starts_with("shapecode_") && contains("_enabled")) {
+        size_t index = parse_index(key, 10);
+        if (index >= shapes.size()) shapes.resize(index + 1);
+        shapes[index].enabled = parse_int(value) != 0;
+    } else if (starts_with("shapecode_") && contains("_num_inst")) {
+        size_t index = parse_index(key, 10);
+        if (index >= shapes.size()) shapes.resize(index + 1);
+        shapes[index].instances = std::max(1, parse_int(value));
+    }
+}
+
+} // namespace
+
+PresetInfo PresetMetadata::parse_data(const char* data, size_t size) {
+    PresetInfo info;
+    std::vector<bool> waves;
+    std::vector<ShapeState> shapes;
+
+    std::string_view text(data, size);
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t newline = text.find('\n', pos);
+        size_t line_end = newline == std::string_view::npos ? text.size() : newline;
+        std::string_view line = text.substr(pos, line_end - pos);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        parse_line(line, info, waves, shapes);
+        pos = line_end + 1;
+    }
+
+    info.custom_waves = static_cast<int>(std::count(waves.begin(), waves.end(), true));
+    for (const auto& shape : shapes) {
+        if (shape.enabled) {
+            info.custom_shapes++;
+            info.shape_instances += shape.instances;
+        }
+    }
+    info.parsed = true;
+    info.complexity = estimate_complexity(info);
+    return info;
+}
+
+PresetInfo PresetMetadata::parse_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return PresetInfo{};
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return parse_data(data.data(), data.size());
+}
+
+std::vector<PresetInfo> PresetMetadata::parse_all(const std::vector<std::string>& paths, unsigned int thread_count) {
+    return parse_all(paths.size(), [&paths](size_t i) { return parse_file(paths[i]); }, thread_count);
+}
+
+std::vector<PresetInfo> PresetMetadata::parse_all(size_t count, const std::function<PresetInfo(size_t)>& parse_one,
+                                                  unsigned int thread_count) {
+    std::vector<PresetInfo> results(count);
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    thread_count = std::min<unsigned int>(thread_count, std::max<size_t>(1, count));
+
+    // Files are tiny, so hand out small batches from a shared counter to keep every thread busy.
+    const size_t batch_size = 64;
+    std::atomic<size_t> next_index{0};
+    auto worker = [&]() {
+        for (;;) {
+            size_t begin = next_index.fetch_add(batch_size);
+            if (begin >= count) {
+                return;
+            }
+            size_t end = std::min(begin + batch_size, count);
+            for (size_t i = begin; i < end; ++i) {
+                results[i] = parse_one(i);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return results;
+}
+
+float PresetMetadata::estimate_complexity(const PresetInfo& info) {
+    // Weights reflect how often each part runs: per-pixel code runs for every mesh
+    // vertex, per-point code for every wave sample, shaders for every screen pixel.
+    float complexity = 1.0f;
+    complexity += info.per_frame_equations * 0.01f;
+    complexity += info.per_pixel_equations * 0.25f;
+    complexity += info.custom_waves * 0.5f + info.per_point_equations * 0.1f;
+    complexity += info.shape_instances * 0.2f;
+    if (info.has_warp_shader) complexity += 2.0f;
+    if (info.has_comp_shader) complexity += 2.0f;
+    complexity += info.shader_lines * 0.02f;
+    return complexity;
+}
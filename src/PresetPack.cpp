@@ -0,0 +1,232 @@
+// src/PresetPack.cpp
+#include "PresetPack.h"
+#include "utils/common.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <zlib.h>
+
+static_assert(sizeof(PackHeader) == 40, "PackHeader layout is part of the file format");
+static_assert(sizeof(PackEntry) == 32, "PackEntry layout is part of the file format");
+
+PresetPack::PresetPack()
+    : _mapping(nullptr), _mapping_size(0), _entry_count(0), _entries(nullptr), _names(nullptr) {}
+
+PresetPack::~PresetPack() {
+    close();
+}
+
+bool PresetPack::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Logger::error("Could not open preset pack: ", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(PackHeader)) {
+        Logger::error("Preset pack is too small to be valid: ", path);
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        Logger::error("Could not memory-map preset pack: ", path);
+        return false;
+    }
+    // Presets are picked at random, so read-ahead only wastes page cache.
+    madvise(mapping, st.st_size, MADV_RANDOM);
+
+    const PackHeader* header = static_cast<const PackHeader*>(mapping);
+    size_t size = st.st_size;
+    bool valid = memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 && header->version == VERSION && header->index_offset <= size &&
+                 header->index_offset + static_cast<uint64_t>(header->entry_count) * sizeof(PackEntry) <= size &&
+                 header->names_offset <= size && header->data_offset <= size;
+    if (!valid) {
+        Logger::error("Not a valid aurora-pack file (or unsupported version): ", path);
+        munmap(mapping, size);
+        return false;
+    }
+    // Every name and every stored preset must lie inside the file, so a truncated
+    // or corrupt pack is refused here rather than read past the mapping later.
+    const PackEntry* entries = reinterpret_cast<const PackEntry*>(static_cast<const char*>(mapping) + header->index_offset);
+    const uint64_t names_size = size - header->names_offset;
+    for (uint32_t i = 0; i < header->entry_count; ++i) {
+        const PackEntry& e = entries[i];
+        if (e.name_offset > names_size || e.name_length > names_size - e.name_offset || e.offset > size ||
+            e.stored_size > size - e.offset) {
+            Logger::error("Corrupt aurora-pack file (entry ", i, " is out of range): ", path);
+            munmap(mapping, size);
+            return false;
+        }
+    }
+
+    _mapping = mapping;
+    _mapping_size = size;
+    _entry_count = header->entry_count;
+    _entries = entries;
+    _names = static_cast<const char*>(mapping) + header->names_offset;
+    return true;
+}
+
+void PresetPack::close() {
+    if (_mapping) {
+        munmap(_mapping, _mapping_size);
+    }
+    _mapping = nullptr;
+    _mapping_size = 0;
+    _entry_count = 0;
+    _entries = nullptr;
+    _names = nullptr;
+}
+
+const PackEntry& PresetPack::entry(size_t index) const {
+    return _entries[index];
+}
+
+std::string_view PresetPack::name_at(size_t index) const {
+    const PackEntry& e = entry(index);
+    return std::string_view(_names + e.name_offset, e.name_length);
+}
+
+uint64_t PresetPack::hash_at(size_t index) const {
+    return entry(index).hash;
+}
+
+long PresetPack::find(std::string_view name) const {
+    size_t low = 0, high = _entry_count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int cmp = name_at(mid).compare(name);
+        if (cmp == 0) {
+            return static_cast<long>(mid);
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return -1;
+}
+
+bool PresetPack::read(size_t index, std::string& out) const {
+    if (index >= _entry_count) {
+        return false;
+    }
+    const PackEntry& e = entry(index);
+    const char* stored = static_cast<const char*>(_mapping) + e.offset;
+
+    if (!(e.flags & PACK_FLAG_COMPRESSED)) {
+        out.assign(stored, e.stored_size);
+        return true;
+    }
+    out.resize(e.raw_size);
+    uLongf raw_size = e.raw_size;
+    if (uncompress(reinterpret_cast<Bytef*>(&out[0]), &raw_size, reinterpret_cast<const Bytef*>(stored), e.stored_size) != Z_OK ||
+        raw_size != e.raw_size) {
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+bool PresetPack::write(const std::string& path, std::vector<PackSource> sources, bool compress) {
+    std::sort(sources.begin(), sources.end(), [](const PackSource& a, const PackSource& b) { return a.name < b.name; });
+    sources.erase(std::unique(sources.begin(), sources.end(), [](const PackSource& a, const PackSource& b) { return a.name == b.name; }),
+                  sources.end());
+
+    std::vector<PackEntry> entries(sources.size());
+    std::string names;
+    std::string data;
+    // Content hash -> index of the first source stored with that content.
+    std::unordered_map<uint64_t, size_t> stored_by_hash;
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const PackSource& source = sources[i];
+        if (source.name.size() > UINT16_MAX || source.data.size() > UINT32_MAX) {
+            Logger::error("Preset is too large for the pack format: ", source.name);
+            return false;
+        }
+        PackEntry& e = entries[i];
+        e.hash = fnv1a_64(source.data.data(), source.data.size());
+        e.name_offset = static_cast<uint32_t>(names.size());
+        e.name_length = static_cast<uint16_t>(source.name.size());
+        e.raw_size = static_cast<uint32_t>(source.data.size());
+        names += source.name;
+
+        auto it = stored_by_hash.find(e.hash);
+        if (it != stored_by_hash.end() && sources[it->second].data == source.data) {
+            const PackEntry& original = entries[it->second];
+            e.offset = original.offset;
+            e.stored_size = original.stored_size;
+            e.flags = original.flags;
+            continue;
+        }
+        stored_by_hash.emplace(e.hash, i);
+
+        e.offset = data.size(); // Relative for now; rebased once the header size is known.
+        e.flags = 0;
+        if (compress && !source.data.empty()) {
+            uLongf compressed_size = compressBound(source.data.size());
+            std::string compressed(compressed_size, '\0');
+            if (compress2(reinterpret_cast<Bytef*>(&compressed[0]), &compressed_size,
+                          reinterpret_cast<const Bytef*>(source.data.data()), source.data.size(), Z_BEST_COMPRESSION) == Z_OK &&
+                compressed_size < source.data.size()) {
+                compressed.resize(compressed_size);
+                data += compressed;
+                e.stored_size = static_cast<uint32_t>(compressed_size);
+                e.flags = PACK_FLAG_COMPRESSED;
+                continue;
+            }
+        }
+        data += source.data;
+        e.stored_size = static_cast<uint32_t>(source.data.size());
+    }
+    if (names.size() > UINT32_MAX) {
+        Logger::error("Too many preset names for the pack format.");
+        return false;
+    }
+
+    PackHeader header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.entry_count = static_cast<uint32_t>(entries.size());
+    header.index_offset = sizeof(PackHeader);
+    header.names_offset = header.index_offset + entries.size() * sizeof(PackEntry);
+    header.data_offset = header.names_offset + names.size();
+    for (auto& e : entries) {
+        e.offset += header.data_offset;
+    }
+
+    // Write to a temporary file and rename so a running visualizer never maps a half-written pack.
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            Logger::error("Could not open pack for writing: ", temp_path);
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PackEntry));
+        file.write(names.data(), names.size());
+        file.write(data.data(), data.size());
+        if (!file) {
+            Logger::error("Failed while writing pack: ", temp_path);
+            return false;
+        }
+    }
+    if (rename(temp_path.c_str(), path.c_str()) != 0) {
+        Logger::error("Could not move pack into place: ", path);
+        return false;
+    }
+    return true;
+}
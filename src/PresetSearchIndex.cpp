@@ -0,0 +1,204 @@
+// src/PresetSearchIndex.cpp
+#include "PresetSearchIndex.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+uint32_t pack_trigram(const std::string& text, size_t pos) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(text[pos])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 2]));
+}
+
+// Word-start trigrams come from the leading space, so "gei" in "geiss" and " ge"
+// both count. Queries are not padded at the end, because the user may still be typing.
+void collect_trigrams(const std::string& padded, std::vector<uint32_t>& out) {
+    for (size_t i = 0; i + 3 <= padded.size(); ++i) {
+        out.push_back(pack_trigram(padded, i));
+    }
+}
+
+// Length of the directory prefix shared by every name, up to and including the last '/'.
+size_t common_directory_length(const std::vector<std::string>& names) {
+    if (names.empty()) {
+        return 0;
+    }
+    size_t length = names[0].size();
+    for (const auto& name : names) {
+        size_t i = 0;
+        while (i < length && i < name.size() && name[i] == names[0][i]) {
+            ++i;
+        }
+        length = i;
+    }
+    size_t slash = names[0].rfind('/', length == 0 ? 0 : length - 1);
+    return (length == 0 || slash == std::string::npos) ? 0 : slash + 1;
+}
+
+} // namespace
+
+std::string PresetSearchIndex::normalize(const std::string& text) {
+    // Lowercase, and fold punctuation and path separators into single spaces so
+    // "geiss flower" finds "Geiss - Flower_2.milk".
+    std::string result;
+    result.reserve(text.size());
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (std::isalnum(u) || u >= 0x80) {
+            result += static_cast<char>(std::tolower(u));
+        } else if (!result.empty() && result.back() != ' ') {
+            result += ' ';
+        }
+    }
+    if (!result.empty() && result.back() == ' ') {
+        result.pop_back();
+    }
+    return result;
+}
+
+void PresetSearchIndex::clear() {
+    _names.clear();
+    _trigrams.clear();
+    _offsets.clear();
+    _postings.clear();
+    _hits.clear();
+    _touched.clear();
+}
+
+void PresetSearchIndex::build(const std::vector<std::string>& names) {
+    clear();
+    const size_t prefix = common_directory_length(names);
+    _names.reserve(names.size());
+
+    // (trigram << 32 | id) pairs; sorting them groups each trigram's ids in order.
+    std::vector<uint64_t> pairs;
+    std::vector<uint32_t> trigrams;
+    for (size_t id = 0; id < names.size(); ++id) {
+        std::string name = names[id].substr(prefix);
+        if (name.size() > 5 && name.compare(name.size() - 5, 5, ".milk") == 0) {
+            name.resize(name.size() - 5);
+        }
+        _names.push_back(normalize(name));
+
+        trigrams.clear();
+        collect_trigrams(" " + _names.back() + " ", trigrams);
+        for (uint32_t trigram : trigrams) {
+            pairs.push_back((static_cast<uint64_t>(trigram) << 32) | id);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    _postings.reserve(pairs.size());
+    for (uint64_t pair : pairs) {
+        uint32_t trigram = static_cast<uint32_t>(pair >> 32);
+        if (_trigrams.empty() || _trigrams.back() != trigram) {
+            _trigrams.push_back(trigram);
+            _offsets.push_back(static_cast<uint32_t>(_postings.size()));
+        }
+        _postings.push_back(static_cast<uint32_t>(pair));
+    }
+    _offsets.push_back(static_cast<uint32_t>(_postings.size()));
+    _hits.assign(_names.size(), 0);
+}
+
+std::vector<PresetSearchResult> PresetSearchIndex::search(const std::string& query, size_t max_results) const {
+    std::vector<PresetSearchResult> results;
+    const std::string needle = normalize(query);
+    if (needle.empty() || _names.empty() || max_results == 0) {
+        return results;
+    }
+
+    // Prefers names containing the query verbatim, then at a word start, then shorter names.
+    auto score = [&](size_t id, float trigram_fraction, bool may_contain) {
+        const std::string& name = _names[id];
+        float value = trigram_fraction;
+        size_t pos = may_contain ? name.find(needle) : std::string::npos;
+        if (pos != std::string::npos) {
+            value += 1.0f;
+            if (pos == 0 || name[pos - 1] == ' ') {
+                value += 0.5f;
+            }
+        }
+        return value - 0.001f * static_cast<float>(name.size());
+    };
+
+    std::vector<uint32_t> query_trigrams;
+    collect_trigrams(" " + needle, query_trigrams);
+    std::sort(query_trigrams.begin(), query_trigrams.end());
+    query_trigrams.erase(std::unique(query_trigrams.begin(), query_trigrams.end()), query_trigrams.end());
+
+    if (query_trigrams.empty()) {
+        // A single character has no trigram; a plain scan is still fast enough.
+        for (size_t id = 0; id < _names.size(); ++id) {
+            if (_names[id].find(needle) != std::string::npos) {
+                results.push_back({id, score(id, 0.0f, true)});
+            }
+        }
+    } else {
+        // Posting ranges of the query trigrams that occur at all, rarest first.
+        std::vector<std::pair<uint32_t, uint32_t>> lists;
+        for (uint32_t trigram : query_trigrams) {
+            auto it = std::lower_bound(_trigrams.begin(), _trigrams.end(), trigram);
+            if (it != _trigrams.end() && *it == trigram) {
+                size_t t = it - _trigrams.begin();
+                lists.emplace_back(_offsets[t], _offsets[t + 1]);
+            }
+        }
+        std::sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) {
+            return a.second - a.first < b.second - b.first;
+        });
+
+        // Require at least half of the query's trigrams, which tolerates a typo or two.
+        // A name with `required` hits must appear in one of the (total - required + 1)
+        // rarest lists, so only those lists introduce candidates; the long, common
+        // lists are only probed for the candidates found so far.
+        const size_t total = query_trigrams.size();
+        const size_t required = std::max<size_t>(1, (total + 1) / 2);
+        const size_t seeding = std::min(lists.size(), total - required + 1);
+        for (size_t l = 0; l < lists.size(); ++l) {
+            const uint32_t* begin = _postings.data() + lists[l].first;
+            const uint32_t* end = _postings.data() + lists[l].second;
+            if (l < seeding) {
+                for (const uint32_t* p = begin; p != end; ++p) {
+                    if (_hits[*p]++ == 0) {
+                        _touched.push_back(*p);
+                    }
+                }
+            } else if (_touched.size() * 16 < static_cast<size_t>(end - begin)) {
+                for (uint32_t id : _touched) {
+                    if (std::binary_search(begin, end, id)) {
+                        _hits[id]++;
+                    }
+                }
+            } else {
+                for (const uint32_t* p = begin; p != end; ++p) {
+                    if (_hits[*p] > 0) {
+                        _hits[*p]++;
+                    }
+                }
+            }
+        }
+        for (uint32_t id : _touched) {
+            if (_hits[id] >= required) {
+                // A verbatim match has every trigram, except perhaps the word-start one.
+                bool may_contain = static_cast<size_t>(_hits[id]) + 1 >= total;
+                results.push_back({id, score(id, static_cast<float>(_hits[id]) / static_cast<float>(total), may_contain)});
+            }
+            _hits[id] = 0;
+        }
+        _touched.clear();
+    }
+
+    auto better = [](const PresetSearchResult& a, const PresetSearchResult& b) {
+        return a.score != b.score ? a.score > b.score : a.index < b.index;
+    };
+    if (results.size() > max_results) {
+        std::partial_sort(results.begin(), results.begin() + max_results, results.end(), better);
+        results.resize(max_results);
+    } else {
+        std::sort(results.begin(), results.end(), better);
+    }
+    return results;
+}
@@ -0,0 +1,161 @@
+// src/ProcessPool.cpp
+#include "ProcessPool.h"
+#include "utils/Logger.h"
+#include "utils/Trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct RunningJob {
+    pid_t pid;
+    int fd;
+    Clock::time_point start;
+    Clock::time_point last_output;
+    ProcessJobResult result;
+};
+
+void finish_job(RunningJob& running) {
+    int status = 0;
+    while (waitpid(running.pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    if (WIFEXITED(status)) {
+        running.result.exit_code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        running.result.signal = WTERMSIG(status);
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - running.start;
+    running.result.seconds = elapsed.count();
+}
+
+} // namespace
+
+bool ProcessPool::write_all(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+std::vector<ProcessJobResult> ProcessPool::run(size_t job_count, unsigned int workers, const JobFunction& job_fn,
+                                               const DoneCallback& on_done, double idle_timeout_seconds,
+                                               const CancelCallback& cancel) {
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<ProcessJobResult> results(job_count);
+    std::vector<RunningJob> running;
+    size_t next_job = 0;
+    bool cancelled = false;
+
+    while (next_job < job_count || !running.empty()) {
+        // Keep every worker slot busy.
+        while (next_job < job_count && running.size() < workers) {
+            // Close-on-exec: an encoder a job starts must not hold other jobs' pipes
+            // open, or a crashed job's EOF would wait for that encoder to exit.
+            int pipe_fds[2];
+            if (pipe2(pipe_fds, O_CLOEXEC) != 0) {
+                Logger::error("ProcessPool: pipe() failed");
+                break;
+            }
+            // Anything buffered in stdio would otherwise be flushed twice, once per process.
+            fflush(stdout);
+            fflush(stderr);
+            pid_t pid = fork();
+            if (pid < 0) {
+                Logger::error("ProcessPool: fork() failed");
+                close(pipe_fds[0]);
+                close(pipe_fds[1]);
+                break;
+            }
+            if (pid == 0) {
+                close(pipe_fds[0]);
+                signal(SIGINT, SIG_DFL);
+                Trace::forked();
+                int code = job_fn(next_job, pipe_fds[1]);
+                close(pipe_fds[1]);
+                Trace::finish();
+                fflush(stdout);
+                fflush(stderr);
+                // Skip the parent's atexit handlers and static destructors.
+                _exit(code);
+            }
+            close(pipe_fds[1]);
+            RunningJob job{pid, pipe_fds[0], Clock::now(), Clock::now(), ProcessJobResult{}};
+            job.result.job = next_job++;
+            running.push_back(std::move(job));
+        }
+        if (running.empty()) {
+            break; // fork/pipe failures with nothing left in flight
+        }
+
+        std::vector<pollfd> fds(running.size());
+        for (size_t i = 0; i < running.size(); ++i) {
+            fds[i] = {running[i].fd, POLLIN, 0};
+        }
+        if (poll(fds.data(), fds.size(), 250) < 0 && errno != EINTR) {
+            Logger::error("ProcessPool: poll() failed");
+            break;
+        }
+        if (!cancelled && cancel && cancel()) {
+            // The children's pipes close as they die, and they are reaped below as usual.
+            cancelled = true;
+            for (RunningJob& job : running) {
+                kill(job.pid, SIGKILL);
+                job.result.cancelled = true;
+            }
+            for (; next_job < job_count; ++next_job) {
+                results[next_job].job = next_job;
+                results[next_job].cancelled = true;
+            }
+        }
+
+        for (size_t i = running.size(); i-- > 0;) {
+            RunningJob& job = running[i];
+            bool finished = false;
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                char buffer[4096];
+                ssize_t n = read(job.fd, buffer, sizeof(buffer));
+                if (n > 0) {
+                    job.result.output.append(buffer, n);
+                    job.last_output = Clock::now();
+                } else if (n == 0 || errno != EINTR) {
+                    finished = true;
+                }
+            }
+            if (!finished && idle_timeout_seconds > 0.0) {
+                std::chrono::duration<double> idle = Clock::now() - job.last_output;
+                if (idle.count() > idle_timeout_seconds) {
+                    kill(job.pid, SIGKILL);
+                    job.result.timed_out = true;
+                    finished = true;
+                }
+            }
+            if (finished) {
+                close(job.fd);
+                finish_job(job);
+                results[job.result.job] = job.result;
+                if (on_done) {
+                    on_done(job.result);
+                }
+                running.erase(running.begin() + i);
+            }
+        }
+    }
+    return results;
+}
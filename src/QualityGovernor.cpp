@@ -0,0 +1,102 @@
+// src/QualityGovernor.cpp
+#include "QualityGovernor.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <string>
+
+namespace {
+
+// Cheapest first to go: mesh density is barely visible, resolution is.
+const QualityLevel LEVELS[] = {
+    { 1.0f,  64, 48 },
+    { 1.0f,  48, 36 },
+    { 0.75f, 48, 36 },
+    { 0.75f, 32, 24 },
+    { 0.5f,  32, 24 },
+};
+const size_t LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+
+const double OVER_BUDGET = 1.05;   // Window average above this fraction of the budget steps down.
+const double UNDER_BUDGET = 0.7;   // Below this it counts towards stepping up.
+const int MIN_GOOD_WINDOWS = 3;
+const int MAX_GOOD_WINDOWS = 48;
+const int UNSTABLE_WINDOWS = 5;    // Stepping down within this many windows of stepping up.
+
+} // namespace
+
+QualityGovernor::QualityGovernor()
+    : _enabled(false), _budget_ms(1000.0 / 30.0), _window_frames(30), _frames(0), _total_ms(0.0),
+      _level(0), _good_windows(0), _required_good(MIN_GOOD_WINDOWS), _windows_at_level(0), _cooldown(0),
+      _stepped_up(false) {}
+
+void QualityGovernor::configure(bool enabled, int fps) {
+    _enabled = enabled;
+    fps = std::max(1, fps);
+    _budget_ms = 1000.0 / fps;
+    _window_frames = std::max(10, fps);
+    _frames = 0;
+    _total_ms = 0.0;
+    _level = 0;
+    _good_windows = 0;
+    _required_good = MIN_GOOD_WINDOWS;
+    _windows_at_level = 0;
+    _cooldown = 0;
+    _stepped_up = false;
+}
+
+const QualityLevel& QualityGovernor::level() const {
+    return LEVELS[_level];
+}
+
+bool QualityGovernor::add_frame(double frame_ms) {
+    if (!_enabled) {
+        return false;
+    }
+    _total_ms += frame_ms;
+    if (++_frames < _window_frames) {
+        return false;
+    }
+    const double average_ms = _total_ms / _frames;
+    _frames = 0;
+    _total_ms = 0.0;
+    _windows_at_level++;
+    if (_cooldown > 0) {
+        _cooldown--;
+        return false;
+    }
+
+    if (average_ms > _budget_ms * OVER_BUDGET) {
+        _good_windows = 0;
+        if (_level + 1 >= LEVEL_COUNT) {
+            return false;
+        }
+        if (_stepped_up && _windows_at_level <= UNSTABLE_WINDOWS) {
+            // The last step up did not hold; be slower to try it again.
+            _required_good = std::min(MAX_GOOD_WINDOWS, _required_good * 2);
+        }
+        change_level(_level + 1);
+        return true;
+    }
+
+    if (average_ms < _budget_ms * UNDER_BUDGET) {
+        if (_level > 0 && ++_good_windows >= _required_good) {
+            change_level(_level - 1);
+            return true;
+        }
+    } else {
+        _good_windows = 0;
+    }
+    return false;
+}
+
+void QualityGovernor::change_level(size_t level) {
+    _stepped_up = level < _level;
+    _level = level;
+    _good_windows = 0;
+    _windows_at_level = 0;
+    _cooldown = 1;
+    const QualityLevel& q = LEVELS[_level];
+    Logger::info("Quality level ", _level, ": render scale ",
+                 static_cast<int>(q.render_scale * 100), "%, mesh ",
+                 q.mesh_width, "x", q.mesh_height);
+}
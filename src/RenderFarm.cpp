@@ -0,0 +1,831 @@
+// src/RenderFarm.cpp
+#include "RenderFarm.h"
+#include "BatchExport.h"
+#include "ConfigLoader.h"
+#include "OfflineRenderer.h"
+#include "ProcessPool.h"
+#include "VideoExporter.h"
+#include "audio_input.h"
+#include "preset_manager.h"
+#include "utils/Logger.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+extern volatile sig_atomic_t g_quit_flag;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Well inside any sensible farm_heartbeat_timeout.
+const double HEARTBEAT_INTERVAL_SECONDS = 5.0;
+// Workers may be started before the coordinator.
+const double CONNECT_RETRY_SECONDS = 30.0;
+// A render child that reports nothing for this long is presumed hung, as in BatchExport.
+const double RENDER_IDLE_TIMEOUT_SECONDS = 300.0;
+
+// Config keys a manifest may override. Render settings travel to the workers
+// with each job. Nothing that names a file or a command may: workers take those
+// from their own command line, so a peer on the farm port cannot make them run
+// a program or write outside their output directory.
+const char* const RENDER_KEYS[] = {
+    "render_width", "render_height", "video_framerate", "shuffle_enabled", "preset_duration", "preset_blend_time",
+    "max_preset_complexity", "max_preset_frame_ms", "use_default_projectm_visualizer", "show_song_title",
+    "show_artist_name", "show_url", "artist_name", "url_text", "url_font_size", "url_font_color", "url_border_color",
+    "url_border_thickness", "song_info_font_size", "song_info_font_color", "song_info_border_color",
+    "song_info_border_thickness", "show_text_border", "text_animation_enabled", "transition_fade_time",
+    "pre_fade_delay", "bounce_duration", "bounce_speed", "bounce_randomness", "fade_to_min_duration",
+    "min_fade_transparency", "text_breathing_effect", "breathing_effect_amount", "breathing_effect_speed"};
+// Only change how the coordinator splits and seeds a track; workers get the result as job fields.
+const char* const PLANNING_KEYS[] = {"export_segments", "segment_preroll_seconds", "export_seed", "checkpoint_seconds"};
+
+bool is_render_key(const std::string& key) {
+    return std::find(std::begin(RENDER_KEYS), std::end(RENDER_KEYS), key) != std::end(RENDER_KEYS);
+}
+
+bool is_planning_key(const std::string& key) {
+    return std::find(std::begin(PLANNING_KEYS), std::end(PLANNING_KEYS), key) != std::end(PLANNING_KEYS);
+}
+
+// `path` relative to the directory `root`, both resolved through symlinks and
+// "..", or empty if it does not lie inside `root`.
+std::string path_under(const std::string& root, const std::string& path) {
+    std::error_code error;
+    const fs::path base = fs::weakly_canonical(fs::absolute(root, error), error);
+    if (error) return "";
+    const fs::path full = fs::weakly_canonical(fs::absolute(path, error), error);
+    if (error) return "";
+    const fs::path relative = full.lexically_relative(base);
+    if (relative.empty() || relative == "." || *relative.begin() == "..") {
+        return "";
+    }
+    return relative.string();
+}
+
+std::string trim(const std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+}
+
+std::string remove_quotes(const std::string& text) {
+    if (text.size() >= 2 && (text.front() == '"' || text.front() == '\'') && text.back() == text.front()) {
+        return text.substr(1, text.size() - 2);
+    }
+    return text;
+}
+
+// Tabs and newlines delimit the protocol, so no field may contain them.
+bool valid_field(const std::string& text) {
+    return text.find_first_of("\t\r\n") == std::string::npos;
+}
+
+std::vector<std::string> split_fields(const std::string& line) {
+    std::vector<std::string> fields;
+    std::istringstream stream(line);
+    for (std::string field; std::getline(stream, field, '\t');) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+// "[host:]port", host defaulting to 127.0.0.1.
+bool parse_address(const std::string& address, sockaddr_in& out) {
+    std::string host = "127.0.0.1";
+    std::string port = address;
+    const size_t colon = address.rfind(':');
+    if (colon != std::string::npos) {
+        host = address.substr(0, colon);
+        port = address.substr(colon + 1);
+    }
+    out = sockaddr_in{};
+    out.sin_family = AF_INET;
+    out.sin_port = htons(static_cast<uint16_t>(std::atoi(port.c_str())));
+    return inet_pton(AF_INET, host.c_str(), &out.sin_addr) == 1 && out.sin_port != 0;
+}
+
+bool send_line(int fd, const std::string& line) {
+    const std::string data = line + "\n";
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t count = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        sent += count;
+    }
+    return true;
+}
+
+// Appends whatever is waiting on `fd`; false once the peer has gone.
+bool receive(int fd, std::string& buffer) {
+    char data[4096];
+    ssize_t count = recv(fd, data, sizeof(data), 0);
+    if (count < 0 && (errno == EINTR || errno == EAGAIN)) return true;
+    if (count <= 0) return false;
+    buffer.append(data, count);
+    return true;
+}
+
+bool next_line(std::string& buffer, std::string& line) {
+    const size_t end = buffer.find('\n');
+    if (end == std::string::npos) {
+        return false;
+    }
+    line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+    return true;
+}
+
+bool apply_overrides(Config& config, const RenderManifest::Overrides& overrides) {
+    for (const auto& [key, value] : overrides) {
+        if (!ConfigLoader::apply(config, key, value)) {
+            Logger::error("Invalid override ", key, " = ", value);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Coordinator
+
+struct FarmTrack {
+    std::string audio_path;
+    std::string output_path;
+    RenderManifest::Overrides overrides; // The manifest's global ones, then the track's.
+    std::vector<size_t> jobs;
+    size_t done = 0;
+    bool segmented = false;
+    bool failed = false;
+    int frames = 0;
+    double audio_seconds = 0.0;
+    double render_seconds = 0.0; // Summed over the track's jobs, on whichever workers ran them.
+};
+
+enum class FarmJobState { PENDING, RUNNING, DONE, FAILED };
+
+struct FarmJob {
+    size_t track = 0;
+    OfflineJob job;
+    std::string wire_output; // job.output_path relative to the output directory, as sent to workers.
+    unsigned int attempts = 0;
+    FarmJobState state = FarmJobState::PENDING;
+};
+
+struct FarmWorker {
+    int fd = -1;
+    std::string name; // Empty until HELLO.
+    std::string input;
+    long job = -1;
+    Clock::time_point last_seen;
+};
+
+class Coordinator {
+public:
+    explicit Coordinator(const Config& config) : _config(config) {}
+
+    ~Coordinator() {
+        for (FarmWorker& worker : _workers) {
+            close(worker.fd);
+        }
+        if (_listen_fd >= 0) {
+            close(_listen_fd);
+        }
+    }
+
+    bool plan(const RenderManifest& manifest);
+    bool listen();
+    int serve();
+
+private:
+    void accept_worker();
+    // False when the worker should be dropped.
+    bool handle_line(FarmWorker& worker, const std::string& line);
+    void finish_job(size_t index, const std::vector<std::string>& fields);
+    void drop_worker(size_t index, const char* reason);
+    void retry_or_fail(size_t index, const std::string& reason);
+    void finish_track(FarmTrack& track);
+    void dispatch();
+    bool finished() const { return _finished_jobs == _jobs.size(); }
+
+    const Config& _config;
+    std::vector<FarmTrack> _tracks;
+    std::vector<FarmJob> _jobs;
+    std::vector<FarmWorker> _workers;
+    size_t _finished_jobs = 0;
+    size_t _failed_tracks = 0;
+    int _listen_fd = -1;
+};
+
+bool Coordinator::plan(const RenderManifest& manifest) {
+    for (const RenderManifest::Track& entry : manifest.tracks) {
+        FarmTrack track;
+        track.audio_path = entry.audio_path;
+        track.overrides = manifest.overrides;
+        track.overrides.insert(track.overrides.end(), entry.overrides.begin(), entry.overrides.end());
+        Config track_config = _config;
+        if (!apply_overrides(track_config, track.overrides)) {
+            return false;
+        }
+        track.output_path = entry.output_path.empty() ? VideoExporter(track_config).output_path_for(track.audio_path)
+                                                      : entry.output_path;
+        for (const FarmTrack& other : _tracks) {
+            if (other.output_path == track.output_path) {
+                Logger::error("Two tracks in the manifest write ", track.output_path);
+                return false;
+            }
+        }
+        std::error_code error;
+        fs::create_directories(fs::path(track.output_path).parent_path(), error);
+
+        std::vector<OfflineJob> jobs;
+        const unsigned int segments = entry.segments > 0 ? entry.segments : track_config.export_segments;
+        if (segments > 1) {
+            // Planned exactly as a batch export plans them; the length goes out with
+            // each job, so every worker agrees on it and decodes only its own part.
+            size_t track_samples = 0;
+            if (!AudioInput::probe_length(track.audio_path, track_samples)) {
+                return false;
+            }
+            const int frames = OfflineRenderer::frame_count(track_samples, track_config.video_framerate);
+            jobs = BatchExport::segment_jobs(track_config, track.audio_path, track.output_path, track_samples,
+                                             std::min<int>(segments, frames));
+            track.segmented = true;
+        } else {
+            OfflineJob job;
+            job.audio_path = track.audio_path;
+            job.output_path = track.output_path;
+            job.seed = BatchExport::track_seed(track_config, track.audio_path);
+            // A retried whole track resumes from its last checkpoint rather than starting over.
+            job.checkpoint_frames = BatchExport::checkpoint_frames(track_config);
+            job.preroll_seconds = track_config.segment_preroll_seconds;
+            jobs.push_back(job);
+        }
+        if (jobs.empty()) {
+            Logger::error("No audio in ", track.audio_path);
+            return false;
+        }
+        for (OfflineJob& job : jobs) {
+            track.jobs.push_back(_jobs.size());
+            FarmJob farm_job;
+            farm_job.track = _tracks.size();
+            // Workers only write inside their own output directory, so outputs are sent relative to it.
+            farm_job.wire_output = path_under(_config.video_directory, job.output_path);
+            if (farm_job.wire_output.empty()) {
+                Logger::error(job.output_path, " is outside the output directory ", _config.video_directory,
+                              "; set --output-directory to a directory the workers share.");
+                return false;
+            }
+            farm_job.job = std::move(job);
+            _jobs.push_back(std::move(farm_job));
+        }
+        _tracks.push_back(std::move(track));
+    }
+    return true;
+}
+
+bool Coordinator::listen() {
+    sockaddr_in address;
+    if (!parse_address(_config.farm_listen, address)) {
+        Logger::error("Invalid farm address: ", _config.farm_listen, " (expected [host:]port)");
+        return false;
+    }
+    _listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int reuse = 1;
+    if (_listen_fd >= 0) setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (_listen_fd < 0 || bind(_listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(_listen_fd, 64) < 0) {
+        Logger::error("Could not listen for render workers on ", _config.farm_listen, ": ", strerror(errno));
+        return false;
+    }
+    Logger::info("Waiting for render workers on ", _config.farm_listen, " for ", _jobs.size(), " jobs from ",
+                 _tracks.size(), " tracks.");
+    return true;
+}
+
+int Coordinator::serve() {
+    while (!finished() && !g_quit_flag) {
+        std::vector<pollfd> fds;
+        fds.push_back({_listen_fd, POLLIN, 0});
+        for (const FarmWorker& worker : _workers) {
+            fds.push_back({worker.fd, POLLIN, 0});
+        }
+        if (poll(fds.data(), fds.size(), 250) < 0 && errno != EINTR) {
+            Logger::error("Coordinator: poll() failed: ", strerror(errno));
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            accept_worker();
+        }
+
+        const auto now = Clock::now();
+        // Backwards, so dropping a worker does not disturb the indices still to visit.
+        // Workers accepted above have no pollfd yet and are left for the next round.
+        for (size_t i = fds.size() - 1; i-- > 0;) {
+            FarmWorker& worker = _workers[i];
+            bool alive = true;
+            if (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+                alive = receive(worker.fd, worker.input);
+                worker.last_seen = now;
+                std::string line;
+                while (alive && next_line(worker.input, line)) {
+                    alive = handle_line(worker, line);
+                }
+            }
+            if (!alive) {
+                drop_worker(i, "disconnected");
+            } else if (std::chrono::duration<double>(now - worker.last_seen).count() > _config.farm_heartbeat_timeout) {
+                drop_worker(i, "stopped sending heartbeats");
+            }
+        }
+        dispatch();
+    }
+    if (g_quit_flag) {
+        _failed_tracks = _tracks.size() - std::count_if(_tracks.begin(), _tracks.end(), [](const FarmTrack& track) {
+            return !track.failed && track.done == track.jobs.size();
+        });
+    }
+
+    for (FarmWorker& worker : _workers) {
+        send_line(worker.fd, "BYE");
+    }
+    std::error_code error;
+    for (const FarmTrack& track : _tracks) {
+        if (track.segmented && track.done < track.jobs.size()) {
+            for (size_t job : track.jobs) {
+                fs::remove(_jobs[job].job.output_path, error);
+            }
+        }
+    }
+    const size_t exported = _tracks.size() - _failed_tracks;
+    Logger::info("Exported ", exported, " of ", _tracks.size(), " tracks.");
+    return exported == _tracks.size() ? 0 : 1;
+}
+
+void Coordinator::accept_worker() {
+    int fd = accept4(_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    FarmWorker worker;
+    worker.fd = fd;
+    worker.last_seen = Clock::now();
+    _workers.push_back(std::move(worker));
+}
+
+bool Coordinator::handle_line(FarmWorker& worker, const std::string& line) {
+    const std::vector<std::string> fields = split_fields(line);
+    if (fields.empty()) {
+        return true;
+    }
+    if (fields[0] == "HELLO" && fields.size() >= 2) {
+        worker.name = fields[1];
+        Logger::info("Render worker ", worker.name, " connected.");
+        return true;
+    }
+    if (fields[0] == "HEARTBEAT") {
+        return true;
+    }
+    if (fields[0] == "RESULT" && fields.size() >= 6 && worker.job >= 0 && fields[1] == std::to_string(worker.job)) {
+        const size_t job = worker.job;
+        worker.job = -1;
+        finish_job(job, fields);
+        return true;
+    }
+    Logger::warn("Unexpected message from render worker ", worker.name.empty() ? "(unnamed)" : worker.name, ": ", line);
+    return false;
+}
+
+void Coordinator::finish_job(size_t index, const std::vector<std::string>& fields) {
+    FarmJob& job = _jobs[index];
+    const int exit_code = std::atoi(fields[2].c_str());
+    if (exit_code != 0) {
+        retry_or_fail(index, "exit code " + std::to_string(exit_code));
+        return;
+    }
+    job.state = FarmJobState::DONE;
+    _finished_jobs++;
+    FarmTrack& track = _tracks[job.track];
+    int frames = 0;
+    double audio_seconds = 0.0, render_seconds = 0.0;
+    std::istringstream values(fields[3] + " " + fields[4] + " " + fields[5]);
+    values >> frames >> audio_seconds >> render_seconds;
+    track.frames += frames;
+    track.audio_seconds += audio_seconds;
+    track.render_seconds += render_seconds;
+    Logger::info("[", _finished_jobs, "/", _jobs.size(), "] ", job.job.output_path, ": ",
+                 BatchExport::throughput(frames, audio_seconds, render_seconds));
+    if (++track.done == track.jobs.size()) {
+        finish_track(track);
+    }
+}
+
+void Coordinator::finish_track(FarmTrack& track) {
+    if (track.segmented) {
+        std::vector<std::string> parts;
+        for (size_t job : track.jobs) {
+            parts.push_back(_jobs[job].job.output_path);
+        }
+        const bool joined = VideoExporter::concatenate(parts, track.audio_path, track.output_path);
+        std::error_code error;
+        for (const std::string& part : parts) {
+            fs::remove(part, error);
+        }
+        if (!joined) {
+            track.failed = true;
+            _failed_tracks++;
+            return;
+        }
+    }
+    Logger::info("Finished ", track.output_path, ": ", track.frames, " frames, ", track.audio_seconds, "s of audio in ",
+                 track.render_seconds, "s of worker time.");
+}
+
+void Coordinator::retry_or_fail(size_t index, const std::string& reason) {
+    FarmJob& job = _jobs[index];
+    if (job.attempts < _config.farm_max_attempts) {
+        Logger::warn(job.job.output_path, " failed (", reason, "); retrying, attempt ", job.attempts + 1, " of ",
+                     _config.farm_max_attempts, ".");
+        job.state = FarmJobState::PENDING;
+        return;
+    }
+    Logger::error(job.job.output_path, " failed (", reason, ") after ", job.attempts, " attempts.");
+    job.state = FarmJobState::FAILED;
+    _finished_jobs++;
+    FarmTrack& track = _tracks[job.track];
+    if (!track.failed) {
+        track.failed = true;
+        _failed_tracks++;
+        // The rest of a failed track is not worth rendering.
+        for (size_t other : track.jobs) {
+            if (_jobs[other].state == FarmJobState::PENDING) {
+                _jobs[other].state = FarmJobState::FAILED;
+                _finished_jobs++;
+            }
+        }
+    }
+}
+
+void Coordinator::drop_worker(size_t index, const char* reason) {
+    FarmWorker& worker = _workers[index];
+    Logger::warn("Render worker ", worker.name.empty() ? "(unnamed)" : worker.name, " ", reason, ".");
+    close(worker.fd);
+    const long job = worker.job;
+    _workers.erase(_workers.begin() + index);
+    if (job >= 0) {
+        retry_or_fail(job, std::string("worker ") + reason);
+    }
+}
+
+void Coordinator::dispatch() {
+    size_t next = 0;
+    for (FarmWorker& worker : _workers) {
+        if (worker.name.empty() || worker.job >= 0) {
+            continue;
+        }
+        while (next < _jobs.size() && _jobs[next].state != FarmJobState::PENDING) {
+            next++;
+        }
+        if (next == _jobs.size()) {
+            return;
+        }
+        FarmJob& job = _jobs[next];
+        const OfflineJob& offline = job.job;
+        std::ostringstream line;
+        line.precision(17);
+        line << "JOB\t" << next << "\taudio=" << offline.audio_path << "\toutput=" << job.wire_output
+             << "\tfirst_frame=" << offline.first_frame << "\tend_frame=" << offline.end_frame
+             << "\ttrack_samples=" << offline.track_samples
+             << "\tpreroll=" << offline.preroll_seconds << "\tseed=" << offline.seed
+             << "\tencode_audio=" << (offline.encode_audio ? 1 : 0) << "\tcheckpoint_frames=" << offline.checkpoint_frames
+             << "\tresume=" << (job.attempts > 0 ? 1 : 0);
+        for (const auto& [key, value] : _tracks[job.track].overrides) {
+            if (is_render_key(key)) {
+                line << "\tset." << key << "=" << value;
+            }
+        }
+        if (!send_line(worker.fd, line.str())) {
+            continue; // The next poll notices the dead connection.
+        }
+        job.state = FarmJobState::RUNNING;
+        job.attempts++;
+        worker.job = static_cast<long>(next);
+        worker.last_seen = Clock::now();
+        Logger::info("Sent ", offline.output_path, " to ", worker.name, ".");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Worker
+
+int connect_to(const std::string& address_text) {
+    sockaddr_in address;
+    if (!parse_address(address_text, address)) {
+        Logger::error("Invalid coordinator address: ", address_text, " (expected [host:]port)");
+        return -1;
+    }
+    const auto start = Clock::now();
+    while (!g_quit_flag) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            return fd;
+        }
+        const int connect_error = errno;
+        if (fd >= 0) close(fd);
+        if (std::chrono::duration<double>(Clock::now() - start).count() > CONNECT_RETRY_SECONDS) {
+            Logger::error("Could not connect to the coordinator at ", address_text, ": ", strerror(connect_error));
+            return -1;
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    return -1;
+}
+
+// Renders one JOB line in a child process; returns the RESULT line. Only
+// RENDER_KEYS are taken from the coordinator, and the output must resolve to a
+// path inside this worker's output directory; anything else makes the job malformed.
+// The coordinator's socket is watched while the child renders: if it hangs up the
+// child is killed and `hung_up` is set, since nobody is left to take the result.
+std::string run_farm_job(const Config& config, const std::vector<std::string>& fields, int fd, std::string& input,
+                         bool& hung_up) {
+    const std::string& id = fields[1];
+    Config job_config = config;
+    OfflineJob job;
+    bool valid = true;
+    for (size_t i = 2; i < fields.size(); ++i) {
+        const size_t equals = fields[i].find('=');
+        const std::string key = fields[i].substr(0, equals);
+        const std::string value = equals == std::string::npos ? "" : fields[i].substr(equals + 1);
+        try {
+            if (key == "audio") job.audio_path = value;
+            else if (key == "output") {
+                job.output_path = value.empty() || fs::path(value).is_absolute()
+                                      ? ""
+                                      : path_under(config.video_directory, (fs::path(config.video_directory) / value).string());
+                if (job.output_path.empty()) Logger::error("Job output ", value, " is outside ", config.video_directory, ".");
+            }
+            else if (key == "first_frame") job.first_frame = std::stoi(value);
+            else if (key == "end_frame") job.end_frame = std::stoi(value);
+            else if (key == "track_samples") job.track_samples = std::stoull(value);
+            else if (key == "preroll") job.preroll_seconds = std::stod(value);
+            else if (key == "seed") job.seed = std::stoull(value);
+            else if (key == "encode_audio") job.encode_audio = value == "1";
+            else if (key == "checkpoint_frames") job.checkpoint_frames = std::stoi(value);
+            else if (key == "resume") job.resume = value == "1";
+            else if (key.rfind("set.", 0) == 0) {
+                const bool allowed = is_render_key(key.substr(4));
+                if (!allowed) Logger::error("The coordinator may not set ", key.substr(4), " on a worker.");
+                valid = allowed && ConfigLoader::apply(job_config, key.substr(4), value) && valid;
+            }
+        } catch (const std::exception&) {
+            valid = false;
+        }
+    }
+    if (!valid || job.audio_path.empty() || job.output_path.empty()) {
+        Logger::error("Malformed job from the coordinator: job ", id);
+        return "RESULT\t" + id + "\t3\t0\t0\t0";
+    }
+    job.output_path = (fs::path(config.video_directory) / job.output_path).string();
+    std::error_code error;
+    fs::create_directories(fs::path(job.output_path).parent_path(), error);
+
+    auto coordinator_gone = [&](int wait_ms) {
+        pollfd readable{fd, POLLIN, 0};
+        if (poll(&readable, 1, wait_ms) > 0 && !receive(fd, input)) {
+            hung_up = true;
+        }
+        return hung_up;
+    };
+
+    // A retry can reach a worker sharing this directory while the render the
+    // coordinator gave up on is still writing the same chunks and checkpoint.
+    // The render child inherits the lock, so it is held until that child is gone;
+    // wait for it as long as a hung render would be allowed to live.
+    const std::string lock_path = job.output_path + ".lock";
+    int lock_fd = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    const auto lock_start = Clock::now();
+    bool waiting = false;
+    while (lock_fd >= 0 && flock(lock_fd, LOCK_EX | LOCK_NB) != 0) {
+        if (errno != EWOULDBLOCK || coordinator_gone(250) ||
+            std::chrono::duration<double>(Clock::now() - lock_start).count() > RENDER_IDLE_TIMEOUT_SECONDS) {
+            close(lock_fd);
+            lock_fd = -1;
+        } else if (!waiting) {
+            Logger::warn("Waiting for an earlier render of ", job.output_path, " to stop.");
+            waiting = true;
+        }
+    }
+    if (hung_up) {
+        return "";
+    }
+    if (lock_fd < 0) {
+        Logger::error(job.output_path, " is still being rendered by another process; job ", id, " not started.");
+        return "RESULT\t" + id + "\t4\t0\t0\t0";
+    }
+
+    Logger::info("Rendering ", job.output_path);
+    const std::vector<ProcessJobResult> results = ProcessPool::run(
+        1, 1,
+        [&](size_t, int output_fd) {
+            PresetManager presets(job_config);
+            if (!job_config.use_default_projectm_visualizer) {
+                presets.load_presets();
+            }
+            return BatchExport::run_job(job_config, presets, job, output_fd);
+        },
+        nullptr, RENDER_IDLE_TIMEOUT_SECONDS, [&] { return coordinator_gone(0); });
+    const ProcessJobResult& result = results[0];
+    if (result.exit_code == 0) {
+        fs::remove(lock_path, error); // Kept after a failure, for the retry to lock.
+    }
+    close(lock_fd);
+    if (hung_up) {
+        Logger::warn("The coordinator hung up; stopped rendering ", job.output_path, ".");
+    }
+    int frames = 0;
+    double audio_seconds = 0.0, render_seconds = 0.0;
+    BatchExport::parse_done(result.output, frames, audio_seconds, render_seconds);
+    std::ostringstream line;
+    line << "RESULT\t" << id << "\t" << result.exit_code << "\t" << frames << "\t" << audio_seconds << "\t" << render_seconds;
+    return line.str();
+}
+
+// One connection to the coordinator, rendering a job at a time until BYE.
+int serve_coordinator(const Config& config, size_t slot) {
+    const int fd = connect_to(config.farm_connect);
+    if (fd < 0) {
+        return 1;
+    }
+    char host[256] = "localhost";
+    gethostname(host, sizeof(host) - 1);
+    const std::string name = std::string(host) + ":" + std::to_string(getpid()) + "/" + std::to_string(slot);
+
+    // Heartbeats go out from their own thread so they keep coming while a job renders.
+    std::mutex send_mutex;
+    std::atomic<bool> stop{false};
+    auto send = [&](const std::string& line) {
+        std::lock_guard<std::mutex> lock(send_mutex);
+        return send_line(fd, line);
+    };
+    std::thread heartbeat([&] {
+        auto last = Clock::now();
+        while (!stop.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            if (std::chrono::duration<double>(Clock::now() - last).count() >= HEARTBEAT_INTERVAL_SECONDS) {
+                send("HEARTBEAT");
+                last = Clock::now();
+            }
+        }
+    });
+
+    int code = 1;
+    std::string input;
+    bool connected = send("HELLO\t" + name);
+    while (connected && !g_quit_flag) {
+        pollfd readable{fd, POLLIN, 0};
+        if (poll(&readable, 1, 250) <= 0) continue;
+        connected = receive(fd, input);
+        std::string line;
+        while (connected && next_line(input, line)) {
+            const std::vector<std::string> fields = split_fields(line);
+            if (fields.empty()) continue;
+            if (fields[0] == "BYE") {
+                code = 0;
+                connected = false;
+            } else if (fields[0] == "JOB" && fields.size() >= 2) {
+                bool hung_up = false;
+                const std::string result = run_farm_job(config, fields, fd, input, hung_up);
+                connected = !hung_up && send(result);
+            }
+        }
+    }
+    if (code != 0 && !g_quit_flag) {
+        Logger::error("Lost the connection to the coordinator.");
+    }
+    stop = true;
+    heartbeat.join();
+    close(fd);
+    return code;
+}
+
+} // namespace
+
+bool RenderManifest::load(const std::string& path, RenderManifest& manifest) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        Logger::error("Could not open render manifest ", path);
+        return false;
+    }
+    manifest = RenderManifest();
+    Config scratch; // Overrides are tried on a copy so bad keys and values are caught here.
+    int line_number = 0;
+    for (std::string line; std::getline(file, line);) {
+        line_number++;
+        // A '#' inside quotes is part of the value (paths may contain one).
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            if (line[i] == '"') quoted = !quoted;
+            if (line[i] == '#' && !quoted) {
+                line.resize(i);
+                break;
+            }
+        }
+        line = trim(line);
+        if (line.empty()) {
+            continue;
+        }
+        if (line == "[[track]]") {
+            manifest.tracks.emplace_back();
+            continue;
+        }
+        const size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            Logger::error(path, ":", line_number, ": expected key = value or [[track]]");
+            return false;
+        }
+        const std::string key = trim(line.substr(0, equals));
+        const std::string value = remove_quotes(trim(line.substr(equals + 1)));
+        if (!valid_field(key) || !valid_field(value) || key.find('=') != std::string::npos) {
+            Logger::error(path, ":", line_number, ": keys and values cannot contain tabs");
+            return false;
+        }
+        Track* track = manifest.tracks.empty() ? nullptr : &manifest.tracks.back();
+        try {
+            if (track && key == "audio") {
+                track->audio_path = value;
+            } else if (track && key == "output") {
+                track->output_path = value;
+            } else if (track && key == "segments") {
+                track->segments = std::stoul(value);
+            } else if (!is_render_key(key) && !is_planning_key(key)) {
+                Logger::error(path, ":", line_number, ": ", key,
+                              " cannot be set in a manifest; give it to the workers on their command line");
+                return false;
+            } else if (ConfigLoader::apply(scratch, key, value)) {
+                (track ? track->overrides : manifest.overrides).emplace_back(key, value);
+            } else {
+                Logger::error(path, ":", line_number, ": unknown option or bad value: ", key, " = ", value);
+                return false;
+            }
+        } catch (const std::exception&) {
+            Logger::error(path, ":", line_number, ": bad value for ", key, ": ", value);
+            return false;
+        }
+    }
+    for (const Track& track : manifest.tracks) {
+        if (track.audio_path.empty()) {
+            Logger::error(path, ": every [[track]] needs an audio file");
+            return false;
+        }
+    }
+    if (manifest.tracks.empty()) {
+        Logger::error(path, ": no [[track]] entries");
+        return false;
+    }
+    return true;
+}
+
+int RenderCoordinator::run(const Config& config) {
+    RenderManifest manifest;
+    if (!RenderManifest::load(config.farm_manifest, manifest)) {
+        return 1;
+    }
+    Coordinator coordinator(config);
+    if (!coordinator.plan(manifest) || !coordinator.listen()) {
+        return 1;
+    }
+    return coordinator.serve();
+}
+
+int RenderWorker::run(const Config& config) {
+    if (config.farm_connect.empty()) {
+        Logger::error("--render-worker needs the coordinator's address.");
+        return 1;
+    }
+    const unsigned int slots = config.export_jobs > 0 ? config.export_jobs : std::max(1u, std::thread::hardware_concurrency());
+    Logger::info("Starting ", slots, " render workers for ", config.farm_connect, ".");
+    size_t failed = 0;
+    ProcessPool::run(slots, slots, [&](size_t slot, int) { return serve_coordinator(config, slot); },
+                     [&](const ProcessJobResult& result) { failed += result.exit_code != 0; });
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,86 @@
+// src/SyntheticAudio.cpp
+#include "SyntheticAudio.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const double TWO_PI = 6.283185307179586;
+const uint64_t SWEEP_SAMPLES = 8 * SyntheticAudio::SAMPLE_RATE;
+const double SWEEP_START_HZ = 40.0;
+const double SWEEP_END_HZ = 8000.0;
+const uint64_t KICK_INTERVAL_SAMPLES = SyntheticAudio::SAMPLE_RATE / 2; // 120 BPM
+}
+
+SyntheticAudio::SyntheticAudio(SyntheticSignal signal, uint32_t seed)
+    : _signal(signal), _sample_index(0), _rng_state(seed ? seed : 1), _sweep_phase(0.0), _kick_phase(0.0), _pink{} {}
+
+bool SyntheticAudio::parse_signal(const std::string& name, SyntheticSignal& signal) {
+    if (name == "sweep") signal = SyntheticSignal::SineSweep;
+    else if (name == "pink") signal = SyntheticSignal::PinkNoise;
+    else if (name == "kick") signal = SyntheticSignal::KickPattern;
+    else if (name == "mix") signal = SyntheticSignal::Mix;
+    else return false;
+    return true;
+}
+
+void SyntheticAudio::generate(float* stereo_out, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        float sample = 0.0f;
+        switch (_signal) {
+            case SyntheticSignal::SineSweep:
+                sample = next_sweep();
+                break;
+            case SyntheticSignal::PinkNoise:
+                sample = next_pink();
+                break;
+            case SyntheticSignal::KickPattern:
+                sample = next_kick();
+                break;
+            case SyntheticSignal::Mix:
+                sample = 0.35f * next_sweep() + 0.25f * next_pink() + 0.6f * next_kick();
+                break;
+        }
+        sample = std::max(-1.0f, std::min(1.0f, sample));
+        stereo_out[i * 2] = sample;
+        stereo_out[i * 2 + 1] = sample;
+        _sample_index++;
+    }
+}
+
+float SyntheticAudio::next_sweep() {
+    // Exponential sweep so every octave gets the same time; restarts every SWEEP_SAMPLES.
+    double progress = static_cast<double>(_sample_index % SWEEP_SAMPLES) / SWEEP_SAMPLES;
+    double frequency = SWEEP_START_HZ * std::pow(SWEEP_END_HZ / SWEEP_START_HZ, progress);
+    _sweep_phase = std::fmod(_sweep_phase + TWO_PI * frequency / SAMPLE_RATE, TWO_PI);
+    return static_cast<float>(0.8 * std::sin(_sweep_phase));
+}
+
+float SyntheticAudio::next_pink() {
+    // xorshift32 white noise through Paul Kellet's pink filter.
+    _rng_state ^= _rng_state << 13;
+    _rng_state ^= _rng_state >> 17;
+    _rng_state ^= _rng_state << 5;
+    float white = static_cast<float>(_rng_state) / 4294967295.0f * 2.0f - 1.0f;
+
+    _pink[0] = 0.99886f * _pink[0] + white * 0.0555179f;
+    _pink[1] = 0.99332f * _pink[1] + white * 0.0750759f;
+    _pink[2] = 0.96900f * _pink[2] + white * 0.1538520f;
+    _pink[3] = 0.86650f * _pink[3] + white * 0.3104856f;
+    _pink[4] = 0.55000f * _pink[4] + white * 0.5329522f;
+    _pink[5] = -0.7616f * _pink[5] - white * 0.0168980f;
+    float pink = _pink[0] + _pink[1] + _pink[2] + _pink[3] + _pink[4] + _pink[5] + _pink[6] + white * 0.5362f;
+    _pink[6] = white * 0.115926f;
+    return pink * 0.11f;
+}
+
+float SyntheticAudio::next_kick() {
+    // A pitch-dropping sine with an exponential decay, retriggered on every beat.
+    uint64_t position = _sample_index % KICK_INTERVAL_SAMPLES;
+    if (position == 0) {
+        _kick_phase = 0.0;
+    }
+    double t = static_cast<double>(position) / SAMPLE_RATE;
+    double frequency = 45.0 + 110.0 * std::exp(-t * 30.0);
+    _kick_phase += TWO_PI * frequency / SAMPLE_RATE;
+    return static_cast<float>(std::sin(_kick_phase) * std::exp(-t * 8.0));
+}
@@ -1,9 +1,15 @@
 // src/TextManager.cpp
 #include "TextManager.h"
+#include "utils/Utf8.h"
 #include <algorithm>
 #include <regex>
 #include <sstream> // Required for std::stringstream
 
+namespace {
+// Enough for every title and window size seen in one session; cleared wholesale past that.
+const size_t MAX_CACHED_LINE_BREAKS = 64;
+}
+
 TextManager::TextManager(TextRenderer& textRenderer) : _textRenderer(textRenderer) {}
 
 std::string TextManager::sanitize_text(const std::string& text) {
@@ -23,7 +29,9 @@ std::string TextManager::sanitize_text(const std::string& text) {
     std::string result;
     for (char c : sanitized) {
         // removed this manually because songs often have round brackets c == '(' || c == ')') {
-        if (isalnum(c) || c == ' ' || c == '[' || c == ']') {
+        // Bytes >= 0x80 are UTF-8 sequences (accented, Cyrillic, CJK, ...) and are kept whole.
+        unsigned char u = static_cast<unsigned char>(c);
+        if (u >= 0x80 || isalnum(u) || c == ' ' || c == '[' || c == ']') {
             result += c;
         }
     }
@@ -32,53 +40,88 @@ std::string TextManager::sanitize_text(const std::string& text) {
 }
 
 std::vector<std::string> TextManager::split_text(const std::string& text, int window_width, float scale) {
-    std::string sanitized = sanitize_text(text);
-    std::vector<std::string> lines;
-    if (sanitized.empty()) {
-        return lines;
+    // Titles only change per song and widths per resize, so nearly every call is a hit.
+    std::string key = std::to_string(window_width) + ' ' + std::to_string(scale) + ' ' + text;
+    auto it = _lineCache.find(key);
+    if (it != _lineCache.end()) {
+        return it->second;
     }
 
-    std::string current_line;
-    std::stringstream ss(sanitized);
-    std::string word;
+    std::vector<std::string> lines = break_lines(sanitize_text(text), window_width * 0.5f, scale);
+    if (_lineCache.size() >= MAX_CACHED_LINE_BREAKS) {
+        _lineCache.clear();
+    }
+    _lineCache.emplace(std::move(key), lines);
+    return lines;
+}
 
-    const float max_width = window_width * 0.5f;
+std::vector<std::string> TextManager::break_lines(const std::string& text, float max_width, float scale) {
+    std::vector<std::string> lines;
 
+    // Collapse whitespace runs into single spaces between words.
+    std::string normalized;
+    std::stringstream ss(text);
+    std::string word;
     while (ss >> word) {
-        std::string test_line = current_line.empty() ? word : current_line + " " + word;
-        if (_textRenderer.getTextWidth(test_line, scale) > max_width) {
-            if (!current_line.empty()) {
-                lines.push_back(current_line);
-                current_line = word;
-            } else {
-                // The word itself is longer than the max width, so we must split it.
-                std::string temp_word = word;
-                while (_textRenderer.getTextWidth(temp_word, scale) > max_width) {
-                    size_t split_pos = 0;
-                    // Find the last character that fits
-                    for (size_t i = 1; i <= temp_word.length(); ++i) {
-                         if (_textRenderer.getTextWidth(temp_word.substr(0, i), scale) > max_width) {
-                            split_pos = i - 1;
-                            break;
-                        }
-                    }
-                    // If we can't even fit one character, something is wrong.
-                    // To prevent infinite loops, we'll just push the first character.
-                    if (split_pos == 0 && !temp_word.empty()) {
-                        split_pos = 1;
-                    }
-                    lines.push_back(temp_word.substr(0, split_pos));
-                    temp_word = temp_word.substr(split_pos);
-                }
-                current_line = temp_word;
-            }
-        } else {
-            current_line = test_line;
+        if (!normalized.empty()) {
+            normalized += ' ';
+        }
+        normalized += word;
+    }
+    if (normalized.empty()) {
+        return lines;
+    }
+
+    // One pass over the text measures everything: the width of any run [a, b)
+    // is then _pen[b] - _pen[a] - _kerning[a], since the kerning in front of a
+    // line's first glyph does not apply.
+    _codepoints.clear();
+    _offsets.clear();
+    _kerning.clear();
+    _pen.clear();
+    _spaces.clear();
+    float pen = 0.0f;
+    for (size_t pos = 0; pos < normalized.size();) {
+        _offsets.push_back(pos);
+        uint32_t codepoint = utf8_decode_next(normalized, pos);
+        float kerning = _codepoints.empty() ? 0.0f : _textRenderer.getKerning(_codepoints.back(), codepoint, scale);
+        if (codepoint == ' ') {
+            _spaces.push_back(_codepoints.size());
         }
+        _codepoints.push_back(codepoint);
+        _kerning.push_back(kerning);
+        _pen.push_back(pen);
+        // Clamped so the prefix sums stay sorted for the binary search below.
+        pen += std::max(0.0f, kerning + _textRenderer.getAdvance(codepoint, scale));
     }
+    const size_t count = _codepoints.size();
+    _offsets.push_back(normalized.size());
+    _pen.push_back(pen);
 
-    if (!current_line.empty()) {
-        lines.push_back(current_line);
+    size_t start = 0;
+    while (start < count) {
+        // Furthest end such that [start, end) fits.
+        const float limit = _pen[start] + _kerning[start] + max_width;
+        size_t end = std::upper_bound(_pen.begin() + start + 1, _pen.end(), limit) - _pen.begin() - 1;
+        size_t next = end;
+        if (end >= count) {
+            end = next = count;
+        } else {
+            // Prefer the last space that keeps the line within the width.
+            auto space = std::upper_bound(_spaces.begin(), _spaces.end(), end);
+            if (space != _spaces.begin() && *(space - 1) > start) {
+                end = *(space - 1);
+                next = end + 1;
+            } else if (end == start) {
+                // Not even one glyph fits; take it anyway so the loop always advances.
+                end = next = start + 1;
+            }
+        }
+        lines.push_back(normalized.substr(_offsets[start], _offsets[end] - _offsets[start]));
+        start = next;
+        if (start < count && _codepoints[start] == ' ') {
+            ++start; // Only after a forced split right in front of a space.
+        }
     }
 
     return lines;
@@ -1,5 +1,8 @@
 #include "TextRenderer.h"
+#include "utils/Utf8.h"
 #include <GL/glew.h>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,8 +14,9 @@ const char* vertexShaderSource = R"glsl(
 layout (location = 0) in vec4 vertex;
 out vec2 TexCoords;
 uniform mat4 projection;
+uniform vec3 transform; // x, y translation and uniform scale of the layout
 void main() {
-    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+    gl_Position = projection * vec4(vertex.xy * transform.z + transform.xy, 0.0, 1.0);
     TexCoords = vertex.zw;
 }
 )glsl";
@@ -36,139 +40,420 @@ void main() {
 }
 )glsl";
 
-TextRenderer::TextRenderer() : _shaderProgram(0), _vao(0), _vbo(0), _ft(nullptr), _face(nullptr), _width(0), _height(0), _initialized(false) {}
+// The atlas is a grid of equal cells. ASCII is rasterized into the first cells
+// at startup and stays there; other glyphs are rasterized on first use and
+// evicted least-recently-drawn first once the grid is full. The cell border
+// keeps linear filtering from reaching into the neighbouring cell.
+const int ATLAS_SIZE = 2048;
+const int CELL_SIZE = 80;
+const int CELL_BORDER = 1;
+const int CELLS_PER_ROW = ATLAS_SIZE / CELL_SIZE;
+const uint32_t FREE_CELL = 0xFFFFFFFF;
+// Glyphs are rendered once as distance fields at this size and scaled in the
+// shader, so one atlas serves every font size and the breathing animation.
+const int SDF_BASE_SIZE = 48;
+const int SDF_SPREAD = 8;
+// Layouts kept alive at once; titles, artist and URL need only a handful.
+const size_t MAX_CACHED_LAYOUTS = 64;
+
+TextRenderer::TextRenderer()
+    : _shaderProgram(0), _vao(0), _atlasTexture(0),
+      _projectionLoc(-1), _transformLoc(-1), _textColorLoc(-1), _alphaLoc(-1), _borderColorLoc(-1), _borderThicknessLoc(-1),
+      _fontScale(1.0f), _ascii(), _atlasFullSerial(UINT64_MAX), _hasKerning(false), _atlasGeneration(0), _drawSerial(0), _width(0), _height(0),
+      _premultipliedTarget(false), _initialized(false) {}
 
 TextRenderer::~TextRenderer() {
     cleanup();
 }
 
 void TextRenderer::cleanup() {
+    _asyncRasterizer.stop();
     if (_shaderProgram) glDeleteProgram(_shaderProgram);
-    for (auto const& [key, val] : _characters) {
-        glDeleteTextures(1, &val.textureID);
+    if (_atlasTexture) glDeleteTextures(1, &_atlasTexture);
+    _ascii = {};
+    _glyphs.clear();
+    _kerningPairs.clear();
+    _cellOwners.clear();
+    _freeCells.clear();
+    _finishedGlyphs.clear();
+    _atlasFullSerial = UINT64_MAX;
+    for (auto& [text, layout] : _layouts) {
+        if (layout.vbo) glDeleteBuffers(1, &layout.vbo);
     }
-    _characters.clear();
-    if (_vbo) glDeleteBuffers(1, &_vbo);
+    _layouts.clear();
     if (_vao) glDeleteVertexArrays(1, &_vao);
-    if (_face) FT_Done_Face(_face);
-    if (_ft) FT_Done_FreeType(_ft);
+    _rasterizer.cleanup();
+    _shaderProgram = _atlasTexture = _vao = 0;
+    _initialized = false;
 }
 
 bool TextRenderer::init(const std::string& fontPath, int fontSize) {
-    if (FT_Init_FreeType(&_ft)) return false;
-    if (FT_New_Face(_ft, fontPath.c_str(), 0, &_face)) return false;
-    FT_Set_Pixel_Sizes(_face, 0, fontSize);
+    if (!_rasterizer.init(fontPath, SDF_BASE_SIZE, SDF_SPREAD)) return false;
+    if (!_asyncRasterizer.start(fontPath, SDF_BASE_SIZE, SDF_SPREAD)) return false;
+    _fontScale = static_cast<float>(fontSize) / SDF_BASE_SIZE;
+    _hasKerning = _rasterizer.has_kerning();
 
     if (!initShaders()) return false;
-
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    for (unsigned char c = 0; c < 128; c++) {
-        if (FT_Load_Char(_face, c, FT_LOAD_RENDER)) continue;
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, _face->glyph->bitmap.width, _face->glyph->bitmap.rows, 0, GL_RED, GL_UNSIGNED_BYTE, _face->glyph->bitmap.buffer);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        _characters[c] = {texture, glm::ivec2(_face->glyph->bitmap.width, _face->glyph->bitmap.rows), glm::ivec2(_face->glyph->bitmap_left, _face->glyph->bitmap_top), static_cast<unsigned int>(_face->glyph->advance.x)};
-    }
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if (!buildAtlas()) return false;
 
     glGenVertexArrays(1, &_vao);
-    glGenBuffers(1, &_vbo);
     glBindVertexArray(_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
     _initialized = true;
     return true;
 }
 
+bool TextRenderer::buildAtlas() {
+    glGenTextures(1, &_atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, _atlasTexture);
+    std::vector<unsigned char> empty(static_cast<size_t>(ATLAS_SIZE) * ATLAS_SIZE, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_SIZE, ATLAS_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, empty.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    const int cell_count = CELLS_PER_ROW * CELLS_PER_ROW;
+    _cellOwners.assign(cell_count, FREE_CELL);
+    _freeCells.clear();
+    for (int cell = cell_count - 1; cell >= 0; --cell) {
+        _freeCells.push_back(cell);
+    }
+    _cellPixels.resize(static_cast<size_t>(CELL_SIZE) * CELL_SIZE);
+
+    // Control characters stay as zero-width, empty glyphs.
+    for (auto& ch : _ascii) {
+        ch.ready = true;
+    }
+    GlyphBitmap bitmap;
+    for (uint32_t c = 32; c < 127; c++) {
+        if (!_rasterizer.rasterize(c, bitmap)) continue;
+        _ascii[c].advance = bitmap.advance;
+        uploadGlyph(_ascii[c], bitmap, bitmap.pixels.empty() ? -1 : allocateCell());
+        if (_ascii[c].cell >= 0) {
+            _cellOwners[_ascii[c].cell] = c;
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
+}
+
+Character& TextRenderer::glyph(uint32_t codepoint) {
+    if (codepoint < 128) {
+        return _ascii[codepoint];
+    }
+    auto it = _glyphs.find(codepoint);
+    if (it != _glyphs.end()) {
+        return it->second;
+    }
+    // The advance is needed for layout right away and is cheap; the pixels follow
+    // from the worker, and the glyph is drawn from the first frame after that.
+    Character ch{};
+    if (!_rasterizer.load_advance(codepoint, ch.advance)) {
+        ch.ready = true; // Nothing the font can render; takes no space.
+    } else {
+        _asyncRasterizer.request(codepoint);
+    }
+    return _glyphs.emplace(codepoint, ch).first->second;
+}
+
+void TextRenderer::uploadFinishedGlyphs() {
+    _asyncRasterizer.collect(_finishedGlyphs);
+    // Once the atlas is full of this frame's glyphs nothing can be placed until the next frame.
+    if (_finishedGlyphs.empty() || _atlasFullSerial == _drawSerial) {
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, _atlasTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    size_t waiting = 0;
+    for (size_t i = 0; i < _finishedGlyphs.size(); ++i) {
+        auto& entry = _finishedGlyphs[i];
+        auto it = _glyphs.find(entry.first);
+        if (it == _glyphs.end() || it->second.ready) {
+            continue;
+        }
+        const GlyphBitmap& bitmap = entry.second;
+        int cell = bitmap.pixels.empty() || _atlasFullSerial == _drawSerial ? -1 : allocateCell();
+        if (!bitmap.pixels.empty() && cell < 0) {
+            // Every cell holds a glyph used this frame. Keep the bitmap and place it in a later frame.
+            _atlasFullSerial = _drawSerial;
+            if (waiting != i) {
+                _finishedGlyphs[waiting] = std::move(entry);
+            }
+            waiting++;
+            continue;
+        }
+        uploadGlyph(it->second, bitmap, cell);
+        if (cell >= 0) {
+            _cellOwners[cell] = entry.first;
+        }
+        // Layouts built while this glyph was pending have no quad for it yet.
+        _atlasGeneration++;
+    }
+    _finishedGlyphs.resize(waiting);
+}
+
+void TextRenderer::markGlyphsUsed(const std::string& text) {
+    for (size_t pos = 0; pos < text.size();) {
+        uint32_t codepoint = utf8_decode_next(text, pos);
+        if (codepoint < 128) {
+            continue;
+        }
+        auto it = _glyphs.find(codepoint);
+        if (it != _glyphs.end()) {
+            it->second.last_used = _drawSerial;
+        }
+    }
+}
+
+void TextRenderer::markGlyphsUsed(const std::vector<uint32_t>& codepoints) {
+    for (uint32_t codepoint : codepoints) {
+        auto it = _glyphs.find(codepoint);
+        if (it != _glyphs.end()) {
+            it->second.last_used = _drawSerial;
+        }
+    }
+}
+
+int TextRenderer::allocateCell() {
+    if (!_freeCells.empty()) {
+        int cell = _freeCells.back();
+        _freeCells.pop_back();
+        return cell;
+    }
+    // Evict the least recently used glyph, but never one used in the current frame.
+    int victim = -1;
+    uint64_t oldest = _drawSerial;
+    for (size_t cell = 0; cell < _cellOwners.size(); ++cell) {
+        uint32_t owner = _cellOwners[cell];
+        if (owner == FREE_CELL || owner < 128) {
+            continue;
+        }
+        const Character& ch = _glyphs[owner];
+        if (ch.last_used < oldest) {
+            oldest = ch.last_used;
+            victim = static_cast<int>(cell);
+        }
+    }
+    if (victim >= 0) {
+        // Forgetting the glyph entirely means its next use requests it again.
+        _glyphs.erase(_cellOwners[victim]);
+        _cellOwners[victim] = FREE_CELL;
+        _atlasGeneration++;
+    }
+    return victim;
+}
+
+void TextRenderer::uploadGlyph(Character& ch, const GlyphBitmap& bitmap, int cell) {
+    ch.ready = true;
+    ch.last_used = _drawSerial; // Not evicted in the frame it arrives in.
+    ch.cell = cell;
+    ch.bearing = glm::ivec2(bitmap.bearing_x, bitmap.bearing_y);
+    if (cell < 0) {
+        ch.size = glm::ivec2(0, 0);
+        return;
+    }
+    // Oversized glyphs (rare at the base size) are cropped to the cell.
+    const int max_extent = CELL_SIZE - 2 * CELL_BORDER;
+    const int w = std::min(bitmap.width, max_extent);
+    const int h = std::min(bitmap.height, max_extent);
+    ch.size = glm::ivec2(w, h);
+
+    // Upload the whole cell so nothing of the previous occupant is left to filter in.
+    std::fill(_cellPixels.begin(), _cellPixels.end(), 0);
+    for (int row = 0; row < h; ++row) {
+        memcpy(_cellPixels.data() + (row + CELL_BORDER) * CELL_SIZE + CELL_BORDER, bitmap.pixels.data() + row * bitmap.width, w);
+    }
+    const int cell_x = (cell % CELLS_PER_ROW) * CELL_SIZE;
+    const int cell_y = (cell / CELLS_PER_ROW) * CELL_SIZE;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, cell_x, cell_y, CELL_SIZE, CELL_SIZE, GL_RED, GL_UNSIGNED_BYTE, _cellPixels.data());
+
+    const float atlas = static_cast<float>(ATLAS_SIZE);
+    const int x0 = cell_x + CELL_BORDER;
+    const int y0 = cell_y + CELL_BORDER;
+    ch.uv = glm::vec4(x0 / atlas, y0 / atlas, (x0 + w) / atlas, (y0 + h) / atlas);
+}
+
 void TextRenderer::setProjection(int width, int height) {
     _width = width;
     _height = height;
     glUseProgram(_shaderProgram);
     glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(_width), 0.0f, static_cast<float>(_height));
-    glUniformMatrix4fv(glGetUniformLocation(_shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniformMatrix4fv(_projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
     glUseProgram(0);
 }
 
 void TextRenderer::renderText(const std::string& text, float x, float y, float scale, const glm::vec3& color, float alpha, bool show_border, const glm::vec3& border_color, float border_thickness) {
-    // NOTE: The contrast adjustment logic was causing heap corruption and has been disabled.
-    float final_border_thickness = show_border ? border_thickness : 0.0f;
-    renderTextPass(text, x, y, scale, color, alpha, border_color, final_border_thickness);
+    renderLayout(getLayout(text), x, y, scale, color, alpha, show_border, border_color, border_thickness);
 }
 
-glm::vec4 TextRenderer::getTextBounds(const std::string& text, float x, float y, float scale) {
-    float min_x = x, max_x = x;
-    float min_y = y, max_y = y;
-
-    for (const char& c : text) {
-        Character ch = _characters[c];
-        float xpos = x + ch.bearing.x * scale;
-        float ypos = y - (ch.size.y - ch.bearing.y) * scale;
-        float w = ch.size.x * scale;
-        float h = ch.size.y * scale;
-
-        min_x = std::min(min_x, xpos);
-        max_x = std::max(max_x, xpos + w);
-        min_y = std::min(min_y, ypos);
-        max_y = std::max(max_y, ypos + h);
-        
+const TextLayout& TextRenderer::getLayout(const std::string& text) {
+    // Pin this string's glyphs before placing new ones, so an upload can only
+    // evict glyphs that no text has used this frame.
+    auto it = _layouts.find(text);
+    if (it != _layouts.end()) {
+        markGlyphsUsed(it->second.codepoints);
+    } else {
+        markGlyphsUsed(text);
+    }
+    uploadFinishedGlyphs();
+    if (it == _layouts.end()) {
+        evictLayouts();
+        it = _layouts.emplace(text, TextLayout{}).first;
+        buildLayout(text, it->second);
+    } else if (it->second.atlas_generation != _atlasGeneration) {
+        buildLayout(text, it->second);
+    }
+    it->second.last_used = _drawSerial;
+    markGlyphsUsed(it->second.codepoints);
+    return it->second;
+}
+
+void TextRenderer::buildLayout(const std::string& text, TextLayout& layout) {
+    // Quads are laid out at scale 1 in the requested font size, starting at the origin.
+    const float scale = _fontScale;
+    float x = 0.0f;
+    float min_x = 0.0f, max_x = 0.0f, min_y = 0.0f, max_y = 0.0f;
+    _vertices.clear();
+    layout.codepoints.clear();
+    uint32_t previous = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        uint32_t codepoint = utf8_decode_next(text, pos);
+        if (previous) {
+            x += getKerning(previous, codepoint, 1.0f);
+        }
+        previous = codepoint;
+        const Character& ch = glyph(codepoint);
+        if (codepoint >= 128) {
+            layout.codepoints.push_back(codepoint);
+        }
+        if (ch.size.x > 0 && ch.size.y > 0) {
+            float xpos = x + ch.bearing.x * scale;
+            float ypos = -(ch.size.y - ch.bearing.y) * scale;
+            float w = ch.size.x * scale;
+            float h = ch.size.y * scale;
+            const float quad[6][4] = {
+                { xpos,     ypos + h,   ch.uv.x, ch.uv.y }, { xpos,     ypos,       ch.uv.x, ch.uv.w }, { xpos + w, ypos,       ch.uv.z, ch.uv.w },
+                { xpos,     ypos + h,   ch.uv.x, ch.uv.y }, { xpos + w, ypos,       ch.uv.z, ch.uv.w }, { xpos + w, ypos + h,   ch.uv.z, ch.uv.y }
+            };
+            _vertices.insert(_vertices.end(), &quad[0][0], &quad[0][0] + 24);
+
+            // Bounds leave out the distance field's padding.
+            const float padding = SDF_SPREAD * scale;
+            min_x = std::min(min_x, xpos + padding);
+            max_x = std::max(max_x, xpos + w - padding);
+            min_y = std::min(min_y, ypos + padding);
+            max_y = std::max(max_y, ypos + h - padding);
+        }
         x += (ch.advance >> 6) * scale;
     }
-    return glm::vec4(min_x, min_y, max_x - min_x, max_y - min_y);
+
+    layout.width = x;
+    layout.bounds = glm::vec4(min_x, min_y, max_x - min_x, max_y - min_y);
+    layout.vertex_count = static_cast<GLsizei>(_vertices.size() / 4);
+    layout.atlas_generation = _atlasGeneration;
+    if (!layout.vbo) {
+        glGenBuffers(1, &layout.vbo);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, layout.vbo);
+    glBufferData(GL_ARRAY_BUFFER, _vertices.size() * sizeof(float), _vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TextRenderer::evictLayouts() {
+    if (_layouts.size() < MAX_CACHED_LAYOUTS) {
+        return;
+    }
+    auto oldest = _layouts.begin();
+    for (auto it = _layouts.begin(); it != _layouts.end(); ++it) {
+        if (it->second.last_used < oldest->second.last_used) {
+            oldest = it;
+        }
+    }
+    if (oldest->second.vbo) glDeleteBuffers(1, &oldest->second.vbo);
+    _layouts.erase(oldest);
 }
 
-void TextRenderer::renderTextPass(const std::string& text, float x, float y, float scale, const glm::vec3& color, float alpha, const glm::vec3& border_color, float border_thickness) {
+void TextRenderer::renderLayout(const TextLayout& layout, float x, float y, float scale, const glm::vec3& color, float alpha, bool show_border, const glm::vec3& border_color, float border_thickness) {
+    markGlyphsUsed(layout.codepoints);
+    if (layout.vertex_count == 0) {
+        return;
+    }
+
+    // NOTE: The contrast adjustment logic was causing heap corruption and has been disabled.
+    float final_border_thickness = show_border ? border_thickness : 0.0f;
     glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (_premultipliedTarget) {
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
     glUseProgram(_shaderProgram);
-    glUniform3f(glGetUniformLocation(_shaderProgram, "textColor"), color.x, color.y, color.z);
-    glUniform1f(glGetUniformLocation(_shaderProgram, "alpha"), alpha);
-    glUniform3f(glGetUniformLocation(_shaderProgram, "borderColor"), border_color.x, border_color.y, border_color.z);
-    glUniform1f(glGetUniformLocation(_shaderProgram, "borderThickness"), border_thickness);
+    glUniform3f(_transformLoc, x, y, scale);
+    glUniform3f(_textColorLoc, color.x, color.y, color.z);
+    glUniform1f(_alphaLoc, alpha);
+    glUniform3f(_borderColorLoc, border_color.x, border_color.y, border_color.z);
+    glUniform1f(_borderThicknessLoc, final_border_thickness);
     glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _atlasTexture);
     glBindVertexArray(_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, layout.vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glDrawArrays(GL_TRIANGLES, 0, layout.vertex_count);
 
-    for (const char& c : text) {
-        Character ch = _characters[c];
-        float xpos = x + ch.bearing.x * scale;
-        float ypos = y - (ch.size.y - ch.bearing.y) * scale;
-        float w = ch.size.x * scale;
-        float h = ch.size.y * scale;
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 0.0f }, { xpos,     ypos,       0.0f, 1.0f }, { xpos + w, ypos,       1.0f, 1.0f },
-            { xpos,     ypos + h,   0.0f, 0.0f }, { xpos + w, ypos,       1.0f, 1.0f }, { xpos + w, ypos + h,   1.0f, 0.0f }
-        };
-        glBindTexture(GL_TEXTURE_2D, ch.textureID);
-        glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        x += (ch.advance >> 6) * scale;
-    }
-
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
     glUseProgram(0);
     glDisable(GL_BLEND);
 }
 
+glm::vec4 TextRenderer::getTextBounds(const std::string& text, float x, float y, float scale) {
+    const glm::vec4& bounds = getLayout(text).bounds;
+    return glm::vec4(x + bounds.x * scale, y + bounds.y * scale, bounds.z * scale, bounds.w * scale);
+}
+
 float TextRenderer::getTextWidth(const std::string& text, float scale) {
     float width = 0.0f;
-    for (const char& c : text) {
-        width += (_characters[c].advance >> 6) * scale;
+    uint32_t previous = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        uint32_t codepoint = utf8_decode_next(text, pos);
+        if (previous) {
+            width += getKerning(previous, codepoint, scale);
+        }
+        width += getAdvance(codepoint, scale);
+        previous = codepoint;
     }
     return width;
 }
 
+float TextRenderer::getGlyphPadding(float scale) const {
+    return SDF_SPREAD * _fontScale * scale;
+}
+
+size_t TextRenderer::getTextureBytes() const {
+    return _initialized ? static_cast<size_t>(ATLAS_SIZE) * ATLAS_SIZE : 0;
+}
+
+float TextRenderer::getAdvance(uint32_t codepoint, float scale) {
+    return (glyph(codepoint).advance >> 6) * scale * _fontScale;
+}
+
+float TextRenderer::getKerning(uint32_t left, uint32_t right, float scale) {
+    if (!_hasKerning) {
+        return 0.0f;
+    }
+    const uint64_t key = (static_cast<uint64_t>(left) << 32) | right;
+    auto it = _kerningPairs.find(key);
+    if (it == _kerningPairs.end()) {
+        it = _kerningPairs.emplace(key, _rasterizer.kerning(left, right)).first;
+    }
+    return (it->second / 64.0f) * scale * _fontScale;
+}
+
 bool TextRenderer::initShaders() {
     GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
@@ -204,5 +489,12 @@ bool TextRenderer::initShaders() {
 
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+
+    _projectionLoc = glGetUniformLocation(_shaderProgram, "projection");
+    _transformLoc = glGetUniformLocation(_shaderProgram, "transform");
+    _textColorLoc = glGetUniformLocation(_shaderProgram, "textColor");
+    _alphaLoc = glGetUniformLocation(_shaderProgram, "alpha");
+    _borderColorLoc = glGetUniformLocation(_shaderProgram, "borderColor");
+    _borderThicknessLoc = glGetUniformLocation(_shaderProgram, "borderThickness");
     return true;
 }
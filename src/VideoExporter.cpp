@@ -1,11 +1,19 @@
 #include "VideoExporter.h"
-#include <iostream>
+#include "Metrics.h"
+#include "utils/Logger.h"
+#include "utils/Trace.h"
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <sstream>
 #include <stdexcept>
 #include <chrono>
 #include <iomanip>
 #include <filesystem>
+#include <cerrno>
 #include <cstring>
+#include <cstdlib>
+#include <fstream>
 
 namespace fs = std::filesystem;
 
@@ -31,6 +39,44 @@ static std::string sanitize_filename(const std::string& input) {
     return output;
 }
 
+// Single-quotes `text` for /bin/sh, so file names with quotes, '$' or backticks stay one literal argument.
+static std::string shell_quote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+
+// Runs `args` (program first, looked up in PATH) without a shell and waits for it.
+// Returns its exit status, or -1 if it could not be run or died from a signal.
+static int run_program(const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        return -1;
+    }
+    if (pid == 0) {
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
 // Helper function to replace placeholders in a string
 static std::string replace_placeholders(std::string str, const std::string& from, const std::string& to) {
     size_t start_pos = 0;
@@ -49,19 +95,8 @@ VideoExporter::~VideoExporter() {
     }
 }
 
-bool VideoExporter::start_export(int width, int height) {
-    _width = width;
-    _height = height;
-
-    if (strlen(_config.ffmpeg_command) == 0) {
-        std::cerr << "Error: ffmpeg_command is not set in the configuration." << std::endl;
-        return false;
-    }
-
-    std::string sanitized_filename = "output";
-    if (!_config.audio_file_paths.empty()) {
-        sanitized_filename = sanitize_filename(_config.audio_file_paths[0]);
-    }
+std::string VideoExporter::output_path_for(const std::string& audio_path) const {
+    std::string sanitized_filename = audio_path.empty() ? "output" : sanitize_filename(audio_path);
 
     auto now = std::chrono::system_clock::now();
     auto in_time_t = std::chrono::system_clock::to_time_t(now);
@@ -69,40 +104,115 @@ bool VideoExporter::start_export(int width, int height) {
     ss << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d_%H-%M-%S");
     std::string timestamp = ss.str();
 
-    std::string output_path = _config.video_directory + "/" + sanitized_filename + "_" + timestamp + ".mp4";
+    return _config.video_directory + "/" + sanitized_filename + "_" + timestamp + ".mp4";
+}
+
+bool VideoExporter::start_export(int width, int height) {
+    const std::string audio_path = _config.audio_file_paths.empty() ? "" : _config.audio_file_paths[0];
+    return start_export(width, height, audio_path, output_path_for(audio_path));
+}
+
+bool VideoExporter::start_export(int width, int height, const std::string& audio_path, const std::string& output_path) {
+    TRACE_SCOPE("export_start");
+    _width = width;
+    _height = height;
+
+    if (strlen(_config.ffmpeg_command) == 0) {
+        Logger::error("ffmpeg_command is not set in the configuration.");
+        return false;
+    }
 
     std::string command = _config.ffmpeg_command;
     command = replace_placeholders(command, "{WIDTH}", std::to_string(_width));
     command = replace_placeholders(command, "{HEIGHT}", std::to_string(_height));
     command = replace_placeholders(command, "{FPS}", std::to_string(_config.video_framerate));
-    if (!_config.audio_file_paths.empty()) {
-        command = replace_placeholders(command, "{AUDIO_FILE_PATH}", "\"" + _config.audio_file_paths[0] + "\"");
+    // Paths are arbitrary file names; quote them for the shell whether or not the
+    // command already wraps the placeholder in double quotes.
+    if (!audio_path.empty()) {
+        command = replace_placeholders(command, "\"{AUDIO_FILE_PATH}\"", shell_quote(audio_path));
+        command = replace_placeholders(command, "{AUDIO_FILE_PATH}", shell_quote(audio_path));
     } else {
+        // Video only: drop the audio input, quoted or not.
         command = replace_placeholders(command, "-i \"{AUDIO_FILE_PATH}\"", "");
+        command = replace_placeholders(command, "-i {AUDIO_FILE_PATH}", "");
     }
-    command = replace_placeholders(command, "{OUTPUT_PATH}", "\"" + output_path + "\"");
+    command = replace_placeholders(command, "\"{OUTPUT_PATH}\"", shell_quote(output_path));
+    command = replace_placeholders(command, "{OUTPUT_PATH}", shell_quote(output_path));
 
-    std::cout << "Starting ffmpeg with command: " << command << std::endl;
+    Logger::info("Starting ffmpeg with command: ", command);
 
     _ffmpeg_pipe = popen(command.c_str(), "w");
     if (!_ffmpeg_pipe) {
-        std::cerr << "Error: Could not open ffmpeg pipe." << std::endl;
+        Logger::error("Could not open ffmpeg pipe.");
         return false;
     }
+    Metrics::get().encoder_frame_bytes.store(static_cast<uint64_t>(_width) * _height * 3, std::memory_order_relaxed);
 
     return true;
 }
 
-void VideoExporter::end_export() {
-    if (_ffmpeg_pipe) {
-        pclose(_ffmpeg_pipe);
-        _ffmpeg_pipe = nullptr;
-        std::cout << "Stopped ffmpeg process." << std::endl;
+bool VideoExporter::end_export() {
+    TRACE_SCOPE("export_end");
+    if (!_ffmpeg_pipe) {
+        return false;
     }
+    int status = pclose(_ffmpeg_pipe);
+    _ffmpeg_pipe = nullptr;
+    Metrics::get().encoder_queue_bytes.store(0, std::memory_order_relaxed);
+    Logger::info("Stopped ffmpeg process.");
+    if (status != 0) {
+        Logger::error("ffmpeg exited with status ", status, ".");
+        return false;
+    }
+    return true;
+}
+
+bool VideoExporter::concatenate(const std::vector<std::string>& parts, const std::string& audio_path, const std::string& output_path) {
+    const std::string list_path = output_path + ".parts.txt";
+    {
+        std::ofstream list(list_path);
+        for (const std::string& part : parts) {
+            // The concat demuxer's quoting: close the quote, escape the quote, reopen.
+            std::string quoted = fs::absolute(part).string();
+            for (size_t pos = 0; (pos = quoted.find('\'', pos)) != std::string::npos; pos += 4) {
+                quoted.replace(pos, 1, "'\\''");
+            }
+            list << "file '" << quoted << "'\n";
+        }
+        if (!list) {
+            Logger::error("Could not write segment list ", list_path);
+            return false;
+        }
+    }
+    // No shell: track names are arbitrary file names and go to ffmpeg as separate arguments.
+    const std::vector<std::string> args = {"ffmpeg", "-y", "-v", "error", "-f", "concat", "-safe", "0", "-i", list_path,
+                                           "-i", audio_path, "-map", "0:v", "-map", "1:a", "-c:v", "copy", "-c:a", "aac",
+                                           "-b:a", "192k", "-shortest", "-movflags", "+faststart", output_path};
+    Logger::info("Joining ", parts.size(), " parts into ", output_path);
+    const int status = run_program(args);
+    std::error_code error;
+    fs::remove(list_path, error);
+    if (status != 0) {
+        Logger::error("ffmpeg could not join the parts of ", output_path, " (status ", status, ").");
+        return false;
+    }
+    return true;
 }
 
 void VideoExporter::write_frame(const unsigned char* pixels) {
+    TRACE_SCOPE("encode_write");
     if (_ffmpeg_pipe) {
-        fwrite(pixels, 1, _width * _height * 3, _ffmpeg_pipe);
+        Metrics& metrics = Metrics::get();
+        const auto start = std::chrono::steady_clock::now();
+        size_t written = fwrite(pixels, 1, _width * _height * 3, _ffmpeg_pipe);
+        const auto blocked = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        metrics.encoder_blocked_us.fetch_add(blocked.count(), std::memory_order_relaxed);
+        metrics.encoder_bytes.fetch_add(written, std::memory_order_relaxed);
+        metrics.encoder_frames.fetch_add(1, std::memory_order_relaxed);
+        // Bytes sitting in the pipe that ffmpeg has not read yet: the encoder's backlog.
+        int queued = 0;
+        if (ioctl(fileno(_ffmpeg_pipe), FIONREAD, &queued) == 0) {
+            metrics.encoder_queue_bytes.store(queued, std::memory_order_relaxed);
+        }
     }
 }
\ No newline at end of file
@@ -1,8 +1,36 @@
 // src/audio_input.cpp
 #include "audio_input.h"
+#include "Metrics.h"
+#include "utils/AllocTracker.h"
 #include "utils/Logger.h"
+#include "utils/Trace.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
 #include <vector>
 
+// Opens the mixer on SDL's dummy audio driver so files can be decoded without a
+// device; `opened_here` says whether the caller must close it again.
+static bool open_mixer_for_decoding(const std::string& path, bool& opened_here) {
+    opened_here = false;
+    if (Mix_QuerySpec(nullptr, nullptr, nullptr)) {
+        return true;
+    }
+    if (!SDL_WasInit(SDL_INIT_AUDIO)) {
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    }
+    if (Mix_OpenAudio(AudioInput::SAMPLE_RATE, AUDIO_S16SYS, 2, 4096) < 0) {
+        Logger::error("Could not open the mixer to decode ", path, ": ", Mix_GetError());
+        return false;
+    }
+    opened_here = true;
+    return true;
+}
+
 AudioInput::AudioInput(Config& config) : _config(config), _music(nullptr) {
     _audio_data.pM = nullptr;
 }
@@ -12,7 +40,7 @@ AudioInput::~AudioInput() {
 }
 
 bool AudioInput::init() {
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096) < 0) {
+    if (Mix_OpenAudio(SAMPLE_RATE, MIX_DEFAULT_FORMAT, 2, 4096) < 0) {
         std::cerr << "SDL_mixer could not initialize! SDL_mixer Error: " << Mix_GetError() << std::endl;
         return false;
     }
@@ -21,13 +49,14 @@ bool AudioInput::init() {
 }
 
 void AudioInput::load_and_play_music(const std::string& music_file) {
+    TRACE_SCOPE("audio_load");
     if (_music) {
         Mix_FreeMusic(_music);
         _music = nullptr;
     }
     _music = Mix_LoadMUS(music_file.c_str());
     if (!_music) {
-        Logger::error("Failed to load music: " + music_file + " - " + std::string(Mix_GetError()));
+        Logger::error("Failed to load music: ", music_file, " - ", Mix_GetError());
         return;
     }
     Mix_PlayMusic(_music, 1);
@@ -46,17 +75,162 @@ void AudioInput::set_projectm_handle(projectm_handle pM) {
 }
 
 void AudioInput::audio_callback(void* userdata, Uint8* stream, int len) {
+    TRACE_SCOPE("audio_callback"); // On SDL's audio thread.
+    ALLOC_PHASE(Audio);
     AudioData* audioData = static_cast<AudioData*>(userdata);
     if (!audioData || !audioData->pM) {
         return;
     }
+    AllocTracker::set_thread_name("audio");
 
     int samples = len / (2 * sizeof(int16_t));
-    std::vector<float> float_samples(len / sizeof(int16_t));
-    int16_t* pcm_stream = reinterpret_cast<int16_t*>(stream);
 
-    for (int i = 0; i < len / 2; ++i) {
-        float_samples[i] = static_cast<float>(pcm_stream[i]) / 32768.0f;
+    // The device asks for a buffer as the previous one runs out, so a gap much
+    // longer than one buffer means it ran dry in between.
+    Metrics& metrics = Metrics::get();
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> gap = now - audioData->last_callback;
+    if (metrics.audio_callbacks.fetch_add(1, std::memory_order_relaxed) > 0 && gap.count() > 1.5 * samples / SAMPLE_RATE) {
+        metrics.audio_underruns.fetch_add(1, std::memory_order_relaxed);
     }
+    audioData->last_callback = now;
+    metrics.audio_last_callback_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count(),
+                                         std::memory_order_relaxed);
+    metrics.audio_buffer_ns.store(static_cast<int64_t>(samples) * 1000000000 / SAMPLE_RATE, std::memory_order_relaxed);
+    std::vector<float>& float_samples = audioData->float_samples;
+    float_samples.resize(len / sizeof(int16_t)); // The mixer's buffer size is fixed, so this allocates once.
+    int16_t* pcm_stream = reinterpret_cast<int16_t*>(stream);
+
+    pcm_to_float(pcm_stream, float_samples.data(), float_samples.size());
+    ALLOC_PHASE(ProjectM);
     projectm_pcm_add_float(audioData->pM, float_samples.data(), samples, PROJECTM_STEREO);
 }
+
+void AudioInput::pcm_to_float(const int16_t* pcm, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<float>(pcm[i]) / 32768.0f;
+    }
+}
+
+bool AudioInput::decode_file(const std::string& path, std::vector<int16_t>& pcm) {
+    int frequency = 0;
+    Uint16 format = 0;
+    int channels = 0;
+    bool opened_here = false;
+    if (!open_mixer_for_decoding(path, opened_here)) {
+        return false;
+    }
+    Mix_QuerySpec(&frequency, &format, &channels);
+
+    bool ok = false;
+    if (frequency != SAMPLE_RATE || format != AUDIO_S16SYS || channels != 2) {
+        Logger::error("Mixer is not configured for 44.1 kHz 16-bit stereo; cannot decode ", path);
+    } else if (Mix_Chunk* chunk = Mix_LoadWAV(path.c_str())) {
+        // Mix_LoadWAV converts any supported format to the mixer's output format.
+        const int16_t* samples = reinterpret_cast<const int16_t*>(chunk->abuf);
+        pcm.assign(samples, samples + chunk->alen / sizeof(int16_t));
+        Mix_FreeChunk(chunk);
+        ok = true;
+    } else {
+        Logger::error("Failed to decode audio: ", path, " - ", Mix_GetError());
+    }
+
+    if (opened_here) {
+        Mix_CloseAudio();
+    }
+    return ok;
+}
+
+bool AudioInput::probe_length(const std::string& path, size_t& sample_frames) {
+    sample_frames = 0;
+    bool opened_here = false;
+    if (!open_mixer_for_decoding(path, opened_here)) {
+        return false;
+    }
+    double seconds = -1.0;
+    if (Mix_Music* music = Mix_LoadMUS(path.c_str())) {
+        // These formats store their exact sample count. An MP3's length is only an
+        // estimate from its bitrate, which is off for VBR files.
+        const Mix_MusicType type = Mix_GetMusicType(music);
+        if (type == MUS_WAV || type == MUS_FLAC || type == MUS_OGG || type == MUS_OPUS) {
+            seconds = Mix_MusicDuration(music);
+        }
+        Mix_FreeMusic(music);
+    }
+    if (opened_here) {
+        Mix_CloseAudio();
+    }
+    if (seconds > 0.0) {
+        sample_frames = static_cast<size_t>(std::llround(seconds * SAMPLE_RATE));
+        return true;
+    }
+    // No exact length in the header (or no music decoder for it): count the samples instead.
+    std::vector<int16_t> pcm;
+    if (!decode_file(path, pcm)) {
+        return false;
+    }
+    sample_frames = pcm.size() / 2;
+    return true;
+}
+
+bool AudioInput::decode_range(const std::string& path, size_t first_sample, size_t sample_count, std::vector<int16_t>& pcm) {
+    pcm.clear();
+    // ffmpeg seeks the input and decodes from there; Mix_LoadWAV can only decode a whole file.
+    char start[32], duration[32];
+    std::snprintf(start, sizeof(start), "%.6f", static_cast<double>(first_sample) / SAMPLE_RATE);
+    std::snprintf(duration, sizeof(duration), "%.6f", static_cast<double>(sample_count) / SAMPLE_RATE);
+    const std::string rate = std::to_string(SAMPLE_RATE);
+    const std::vector<std::string> args = {"ffmpeg", "-nostdin", "-v", "error", "-ss", start, "-i", path, "-t", duration, "-vn",
+                                           "-f", "s16le", "-acodec", "pcm_s16le", "-ac", "2", "-ar", rate, "-"};
+    std::vector<char*> argv;
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    // s16le is the mixer's AUDIO_S16SYS only on little-endian hosts.
+    bool ok = false;
+    int pipe_fds[2];
+    if (SDL_BYTEORDER == SDL_LIL_ENDIAN && pipe(pipe_fds) == 0) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            dup2(pipe_fds[1], STDOUT_FILENO);
+            close(pipe_fds[0]);
+            close(pipe_fds[1]);
+            execvp(argv[0], argv.data());
+            _exit(127);
+        }
+        close(pipe_fds[1]);
+        std::vector<char> bytes;
+        char buffer[65536];
+        while (pid > 0) {
+            const ssize_t n = read(pipe_fds[0], buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            bytes.insert(bytes.end(), buffer, buffer + n);
+        }
+        close(pipe_fds[0]);
+        int status = -1;
+        while (pid > 0 && waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+        if (pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            const size_t samples = std::min(bytes.size() / (2 * sizeof(int16_t)), sample_count);
+            pcm.resize(samples * 2);
+            std::copy(bytes.begin(), bytes.begin() + samples * 2 * sizeof(int16_t), reinterpret_cast<char*>(pcm.data()));
+            ok = true;
+        }
+    }
+    if (ok) {
+        return true;
+    }
+
+    Logger::warn("Could not decode part of ", path, " with ffmpeg; decoding all of it.");
+    if (!decode_file(path, pcm)) {
+        return false;
+    }
+    const size_t first = std::min(first_sample, pcm.size() / 2);
+    const size_t end = first + std::min(sample_count, pcm.size() / 2 - first);
+    pcm.erase(pcm.begin() + end * 2, pcm.end());
+    pcm.erase(pcm.begin(), pcm.begin() + first * 2);
+    return true;
+}
@@ -3,8 +3,13 @@
 #include "utils/common.h"
 #include "Gui.h"
 #include "VideoExporter.h"
+#include "utils/AllocTracker.h"
 #include "utils/Logger.h"
+#include "utils/Trace.h"
+#include <algorithm>
 #include <chrono>
+#include <iostream>
+#include <sstream>
 #include <SDL_mixer.h>
 #include <GL/glew.h>
 #include <unistd.h>
@@ -15,8 +20,39 @@
 // Global flag to signal termination
 extern volatile sig_atomic_t g_quit_flag;
 
+namespace {
+// Blocks of overlay text, each cached in its own texture by the OverlayCompositor.
+enum OverlayBlock : size_t { OVERLAY_TITLE, OVERLAY_ARTIST, OVERLAY_URL };
+
+// Render stages timed on the GPU, in the order they are registered with the GpuTimer.
+enum GpuStage : size_t { GPU_PROJECTM, GPU_OVERLAY_TITLE, GPU_OVERLAY_ARTIST, GPU_OVERLAY_URL, GPU_READBACK, GPU_PRESENT };
+const char* const GPU_STAGE_NAMES[] = { "projectm", "overlay_title", "overlay_artist", "overlay_url", "readback", "present" };
+
+// Frame stages whose CPU time the HUD shows. Measured only while it is visible.
+enum CpuStage : size_t { CPU_EVENTS, CPU_ANIMATION, CPU_RENDER, CPU_OVERLAY, CPU_READBACK, CPU_ENCODE, CPU_PRESENT, CPU_HUD, CPU_SWAP, CPU_STAGE_COUNT };
+const char* const CPU_STAGE_NAMES[] = { "events", "animation", "render", "overlay", "readback", "encode", "present", "hud", "swap" };
+static_assert(CPU_STAGE_COUNT <= HudFrame::MAX_STAGES, "HudFrame has too few stage slots");
+
+// Adds the milliseconds until the end of the block to `*slot`; does nothing when `slot` is null.
+class StageClock {
+public:
+    explicit StageClock(float* slot) : _slot(slot) {
+        if (_slot) _start = std::chrono::steady_clock::now();
+    }
+    ~StageClock() {
+        if (_slot) *_slot += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _start).count();
+    }
+    StageClock(const StageClock&) = delete;
+    StageClock& operator=(const StageClock&) = delete;
+
+private:
+    float* _slot;
+    std::chrono::steady_clock::time_point _start;
+};
+}
+
 void signal_handler(int signal) {
-    g_quit_flag = 1;
+    g_quit_flag = signal; // Logged from the render loop; nothing else here is async-signal-safe.
 }
 
 Core::Core(Config& config)
@@ -25,14 +61,15 @@ Core::Core(Config& config)
       _context(nullptr),
       _pM(nullptr),
       _renderer(),
-      _event_handler(_config, _preset_manager, _animation_manager, _text_renderer, _text_manager),
+      _event_handler(_config, _renderer, _preset_manager, _animation_manager, _text_renderer, _text_manager, _overlay_compositor),
       _audio_input(_config),
       _preset_manager(_config),
       _text_renderer(),
       _text_manager(_text_renderer),
+      _overlay_compositor(_text_renderer),
       _animation_manager(_config, _text_renderer),
       _video_exporter(_config),
-      //_gui(std::make_unique<Gui>(_config, *this)),
+      _gui(std::make_unique<Gui>(_config, *this)),
       g_quit(false) {}
 
 Core::~Core() {
@@ -69,6 +106,14 @@ bool Core::init() {
         return false;
     }
 
+    // A recording keeps one resolution from start to end; only a live preview
+    // with no explicit render size follows the window.
+    _config.render_follows_window = (_config.render_width <= 0 || _config.render_height <= 0) && !_config.enable_recording;
+    if (_config.render_width <= 0 || _config.render_height <= 0) {
+        _config.render_width = _config.width;
+        _config.render_height = _config.height;
+    }
+
     if (!_renderer.init(_window, &_context, _config)) {
         std::cerr << "Failed to initialize renderer" << std::endl;
         return false;
@@ -77,11 +122,30 @@ bool Core::init() {
     if (!_text_renderer.init(_config.font_path, _config.songInfoFontSize)) {
         std::cerr << "Failed to load font: " << _config.font_path << std::endl;
     }
-    _text_renderer.setProjection(_config.width, _config.height);
+    _text_renderer.setProjection(_config.render_width, _config.render_height);
+    if (_text_renderer.is_initialized() && !_overlay_compositor.init()) {
+        Logger::warn("Overlay compositor unavailable; drawing overlay text directly.");
+    }
+    _overlay_compositor.setProjection(_config.render_width, _config.render_height);
+
+    for (const char* name : GPU_STAGE_NAMES) {
+        _gpu_timer.add_stage(name);
+    }
+    _gpu_timer.init();
+
+    _quality_governor.configure(_config.adaptive_quality && !_config.enable_recording, _config.fps);
+    if (_config.adaptive_quality && _config.enable_recording) {
+        Logger::info("Adaptive quality is off while recording.");
+    }
+    if (_config.enable_recording && _config.audio_file_paths.size() > 1) {
+        Logger::warn("Recording ", _config.audio_file_paths.size(), " tracks into one video with the first track's audio; "
+                     "use --batch-export to give each track its own video.");
+    }
 
     _pM = projectm_create();
-    projectm_set_window_size(_pM, _config.width, _config.height);
-    projectm_set_mesh_size(_pM, 64, 48);
+    projectm_set_window_size(_pM, _config.render_width, _config.render_height);
+    const QualityLevel& quality = _quality_governor.level();
+    projectm_set_mesh_size(_pM, quality.mesh_width, quality.mesh_height);
     projectm_set_soft_cut_duration(_pM, _config.presetBlendTime);
 
     if (!_config.use_default_projectm_visualizer) {
@@ -95,10 +159,14 @@ bool Core::init() {
         return false;
     }
 
-    /*if (!_gui->init(_window, _context)) {
+    if (!_config.metrics_listen.empty()) {
+        _metrics_server.start(_config.metrics_listen);
+    }
+
+    if (!_gui->init(_window, _context)) {
         std::cerr << "Failed to initialize GUI" << std::endl;
         return false;
-    }*/
+    }
 
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
@@ -108,27 +176,32 @@ bool Core::init() {
 
 void Core::run() {
     int current_audio_index = 0;
+    int frames_rendered = 0;
     double time_since_last_shuffle = 0.0;
     std::string currentPreset;
     if (!_config.use_default_projectm_visualizer) {
         currentPreset = _preset_manager.get_next_preset();
-        if (!currentPreset.empty()) {
-            projectm_load_preset_file(_pM, currentPreset.c_str(), true);
-        }
+        _preset_manager.load_preset(_pM, currentPreset, true);
     }
 
     if (_config.enable_recording) {
-        _video_exporter.start_export(_config.width, _config.height);
+        _video_exporter.start_export(_config.render_width, _config.render_height);
     }
 
     const Uint32 frame_duration_ms = 1000 / _config.fps;
+    Metrics& metrics = Metrics::get();
+    update_gl_memory_metrics(true);
+    HudFrame hud_frame;
+    hud_frame.stage_names = CPU_STAGE_NAMES;
+    hud_frame.stage_count = CPU_STAGE_COUNT;
+    float stage_ms[CPU_STAGE_COUNT] = {};
 
     while (!g_quit && static_cast<size_t>(current_audio_index) < _config.audio_file_paths.size()) {
         const std::string& current_audio_file = _config.audio_file_paths[current_audio_index];
         _audio_input.load_and_play_music(current_audio_file);
 
         _config.songTitle = sanitize_filename(current_audio_file);
-        std::vector<std::string> titleLines = _text_manager.split_text(_config.songTitle, _config.width, 1.0f);
+        std::vector<std::string> titleLines = _text_manager.split_text(_config.songTitle, _config.render_width, 1.0f);
 
         _animation_manager.reset(titleLines);
 
@@ -138,6 +211,8 @@ void Core::run() {
         int extra_frames_after_music_ends = 0;
 
         while (!g_quit && !g_quit_flag && (music_playing || extra_frames_after_music_ends > 0)) {
+            TRACE_SCOPE("frame");
+            _text_renderer.beginFrame();
             if (!Mix_PlayingMusic()) {
                 if (music_playing) {
                     music_playing = false;
@@ -149,25 +224,47 @@ void Core::run() {
 
             Uint32 frame_start_ticks = SDL_GetTicks();
 
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             auto current_frame_time = std::chrono::high_resolution_clock::now();
             std::chrono::duration<double> delta_time = current_frame_time - last_frame_time;
             last_frame_time = current_frame_time;
+            const bool hud_visible = _gui->visible();
+            auto hud_stage = [&](CpuStage stage) { return hud_visible ? &stage_ms[stage] : nullptr; };
+
+            {
+                TRACE_SCOPE("events");
+                ALLOC_PHASE(Events);
+                StageClock clock(hud_stage(CPU_EVENTS));
+                SDL_Event event;
+                while (SDL_PollEvent(&event)) {
+                    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == _config.hud_key) {
+                        _gui->toggle();
+                        continue;
+                    }
+                    if (_gui->handle_event(event)) {
+                        continue;
+                    }
 
-            SDL_Event event;
-            while (SDL_PollEvent(&event)) {
-                //_gui->handle_event(event);
+                    _event_handler.handle_event(event, g_quit, current_audio_index, time_since_last_shuffle, currentPreset, _pM, titleLines);
+                }
+            }
 
-                _event_handler.handle_event(event, g_quit, current_audio_index, time_since_last_shuffle, currentPreset, _pM, titleLines);
+            if (!_requested_preset.empty()) {
+                std::string preset = _preset_manager.jump_to_preset(_requested_preset);
+                if (!preset.empty()) {
+                    currentPreset = preset;
+                    _preset_manager.load_preset(_pM, currentPreset, true);
+                    time_since_last_shuffle = 0.0;
+                }
+                _requested_preset.clear();
             }
 
+            apply_render_scale();
+
             if (_config.shuffleEnabled && !_config.use_default_projectm_visualizer) {
                 time_since_last_shuffle += delta_time.count();
                 if (time_since_last_shuffle >= _config.presetDuration) {
                     currentPreset = _preset_manager.get_next_preset();
-                    if (!currentPreset.empty()) {
-                        projectm_load_preset_file(_pM, currentPreset.c_str(), true);
-                    }
+                    _preset_manager.load_preset(_pM, currentPreset, true);
                     time_since_last_shuffle = 0.0;
                 }
             }
@@ -176,63 +273,147 @@ void Core::run() {
             double current_time = Mix_GetMusicPosition(_audio_input.get_music());
 
             if (_config.text_animation_enabled) {
-                _animation_manager.update(music_len, current_time, titleLines);
+                TRACE_SCOPE("animation_update");
+                ALLOC_PHASE(Animation);
+                StageClock clock(hud_stage(CPU_ANIMATION));
+                _animation_manager.update(music_len, current_time);
             }
 
-            _renderer.render(_pM);
+            {
+                TRACE_SCOPE("render");
+                ALLOC_PHASE(Render);
+                StageClock clock(hud_stage(CPU_RENDER));
+                _gpu_timer.begin(GPU_PROJECTM);
+                _renderer.render(_pM);
+                _gpu_timer.end();
+            }
 
             if (_text_renderer.is_initialized()) {
+                TRACE_SCOPE("overlay");
+                ALLOC_PHASE(Overlay);
+                StageClock clock(hud_stage(CPU_OVERLAY));
                 float alpha = _config.text_animation_enabled ? _animation_manager.getAlpha() : 1.0f;
                 float scale = _config.text_animation_enabled ? _animation_manager.getBreathingScale() : 1.0f;
 
+                // Setting a block is a no-op unless its text or style changed; only then is it re-rasterized.
+                OverlayTextStyle songInfoStyle;
+                songInfoStyle.color = _config.songInfoFontColor;
+                songInfoStyle.show_border = _config.show_text_border;
+                songInfoStyle.border_color = _config.songInfoBorderColor;
+                songInfoStyle.border_thickness = _config.songInfoBorderThickness;
+
                 if (_config.show_song_title) {
-                    const auto titlePositions = _animation_manager.getTitlePositions(titleLines);
-                    for (size_t i = 0; i < titleLines.size(); ++i) {
-                        _text_renderer.renderText(
-                            titleLines[i], titlePositions[i].x, titlePositions[i].y,
-                            scale, _config.songInfoFontColor, alpha, _config.show_text_border, _config.songInfoBorderColor,
-                            _config.songInfoBorderThickness);
-                    }
+                    _overlay_compositor.setBlock(OVERLAY_TITLE, titleLines, _animation_manager.getTitleLineOffsets(), songInfoStyle);
+                    glm::vec2 titlePos = _animation_manager.getTitleBlockPosition();
+                    _gpu_timer.begin(GPU_OVERLAY_TITLE);
+                    _overlay_compositor.drawBlock(OVERLAY_TITLE, titlePos.x, titlePos.y, scale, alpha);
+                    _gpu_timer.end();
                 }
 
                 if (_config.show_artist_name) {
+                    _overlay_compositor.setBlock(OVERLAY_ARTIST, _config.artistName, songInfoStyle);
                     glm::vec2 artistPos = _animation_manager.getArtistPosition();
-                    _text_renderer.renderText(
-                        _config.artistName, artistPos.x, artistPos.y,
-                        scale, _config.songInfoFontColor, alpha, _config.show_text_border, _config.songInfoBorderColor,
-                        _config.songInfoBorderThickness);
+                    _gpu_timer.begin(GPU_OVERLAY_ARTIST);
+                    _overlay_compositor.drawBlock(OVERLAY_ARTIST, artistPos.x, artistPos.y, scale, alpha);
+                    _gpu_timer.end();
                 }
 
                 if (_config.show_url) {
-                    float url_scale = static_cast<float>(_config.urlFontSize) / static_cast<float>(_config.songInfoFontSize);
-                    _text_renderer.renderText(_config.urlText, 10, 10, url_scale * scale, _config.urlFontColor,
-                                            1.0f, _config.show_text_border, _config.urlBorderColor,
-                                            _config.urlBorderThickness);
+                    OverlayTextStyle urlStyle;
+                    urlStyle.scale = static_cast<float>(_config.urlFontSize) / static_cast<float>(_config.songInfoFontSize);
+                    urlStyle.color = _config.urlFontColor;
+                    urlStyle.show_border = _config.show_text_border;
+                    urlStyle.border_color = _config.urlBorderColor;
+                    urlStyle.border_thickness = _config.urlBorderThickness;
+                    _overlay_compositor.setBlock(OVERLAY_URL, _config.urlText, urlStyle);
+                    _gpu_timer.begin(GPU_OVERLAY_URL);
+                    _overlay_compositor.drawBlock(OVERLAY_URL, 10, 10, scale, 1.0f);
+                    _gpu_timer.end();
                 }
             }
 
-            //_gui->render();
-
             if (_config.enable_recording) {
-                std::vector<unsigned char> frame_buffer(_config.width * _config.height * 3);
-                glReadPixels(0, 0, _config.width, _config.height, GL_RGB, GL_UNSIGNED_BYTE, frame_buffer.data());
-
-                // Flip the image vertically
-                std::vector<unsigned char> flipped_buffer(_config.width * _config.height * 3);
-                for (int y = 0; y < _config.height; ++y) {
-                    memcpy(flipped_buffer.data() + y * _config.width * 3, frame_buffer.data() + (_config.height - 1 - y) * _config.width * 3, _config.width * 3);
+                {
+                    TRACE_SCOPE("readback");
+                    ALLOC_PHASE(Readback);
+                    StageClock clock(hud_stage(CPU_READBACK));
+                    _gpu_timer.begin(GPU_READBACK);
+                    _renderer.read_pixels(_frame_buffer);
+                    _gpu_timer.end();
+                    const int render_width = _renderer.get_width();
+                    const int render_height = _renderer.get_height();
+
+                    // Flip the image vertically
+                    _flipped_buffer.resize(_frame_buffer.size());
+                    flip_rows(_frame_buffer.data(), _flipped_buffer.data(), static_cast<size_t>(render_width) * 3, render_height);
                 }
 
-                _video_exporter.write_frame(flipped_buffer.data());
+                ALLOC_PHASE(Encode);
+                StageClock clock(hud_stage(CPU_ENCODE));
+                _video_exporter.write_frame(_flipped_buffer.data());
+            }
+
+            {
+                TRACE_SCOPE("present");
+                ALLOC_PHASE(Present);
+                StageClock clock(hud_stage(CPU_PRESENT));
+                _gpu_timer.begin(GPU_PRESENT);
+                _renderer.present(_config.width, _config.height);
+                _gpu_timer.end();
+            }
+
+            // Drawn over the presented window, after the frame was read back for recording,
+            // so the HUD never reaches an export.
+            if (hud_visible) {
+                TRACE_SCOPE("hud");
+                ALLOC_PHASE(Other); // ImGui allocates as its windows change; the HUD is a diagnostic, so it is not checked.
+                StageClock clock(hud_stage(CPU_HUD));
+                _gui->render(hud_frame);
             }
 
-            SDL_GL_SwapWindow(_window);
+            {
+                TRACE_SCOPE("swap");
+                ALLOC_PHASE(Present);
+                StageClock clock(hud_stage(CPU_SWAP));
+                SDL_GL_SwapWindow(_window);
+            }
+            _gpu_timer.collect();
+
+            std::chrono::duration<double, std::milli> frame_work = std::chrono::high_resolution_clock::now() - current_frame_time;
+            metrics.frame_seconds.observe(frame_work.count() / 1000.0);
+            metrics.frames.fetch_add(1, std::memory_order_relaxed);
+            if (frame_work.count() > frame_duration_ms) {
+                metrics.late_frames.fetch_add(1, std::memory_order_relaxed);
+                metrics.dropped_frames.fetch_add(static_cast<uint64_t>(frame_work.count() / frame_duration_ms),
+                                                 std::memory_order_relaxed);
+            }
+            update_gl_memory_metrics(frames_rendered % _config.fps == 0);
+            if (hud_visible) {
+                // Shown next frame: this frame's swap was not done when the HUD was drawn.
+                hud_frame.frame_ms = static_cast<float>(frame_work.count());
+                std::copy(std::begin(stage_ms), std::end(stage_ms), hud_frame.stage_ms);
+                std::fill(std::begin(stage_ms), std::end(stage_ms), 0.0f);
+            }
+            if (_quality_governor.add_frame(frame_work.count())) {
+                const QualityLevel& level = _quality_governor.level();
+                projectm_set_mesh_size(_pM, level.mesh_width, level.mesh_height);
+            }
 
             // Frame pacing
             Uint32 frame_time = SDL_GetTicks() - frame_start_ticks;
             if (frame_time < frame_duration_ms) {
+                TRACE_SCOPE("sleep");
                 SDL_Delay(frame_duration_ms - frame_time);
             }
+
+            AllocTracker::end_frame();
+            if (++frames_rendered == _config.alloc_check_warmup_frames) {
+                AllocTracker::arm_check();
+            }
+        }
+        if (g_quit_flag) {
+            Logger::info("Caught signal ", static_cast<int>(g_quit_flag), ", shutting down...");
+            break;
         }
 
         current_audio_index++;
@@ -243,12 +424,61 @@ void Core::run() {
     }
 }
 
+void Core::apply_render_scale() {
+    // Overlays keep drawing in render_width x render_height coordinates; only
+    // the pixels behind them shrink.
+    const float scale = _quality_governor.level().render_scale;
+    const int width = std::max(1, static_cast<int>(_config.render_width * scale + 0.5f));
+    const int height = std::max(1, static_cast<int>(_config.render_height * scale + 0.5f));
+    if (width == _renderer.get_width() && height == _renderer.get_height()) {
+        return;
+    }
+    if (_renderer.resize(width, height)) {
+        projectm_set_window_size(_pM, width, height);
+    }
+}
+
+void Core::update_gl_memory_metrics(bool query_driver) {
+    Metrics& metrics = Metrics::get();
+    metrics.gl_memory_estimate_bytes.store(
+        _renderer.get_gpu_bytes() + _text_renderer.getTextureBytes() + _overlay_compositor.getTextureBytes(),
+        std::memory_order_relaxed);
+    if (!query_driver) {
+        return;
+    }
+    GLint available_kb[4] = { -1, -1, -1, -1 };
+    if (GLEW_NVX_gpu_memory_info) {
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, available_kb);
+    } else if (GLEW_ATI_meminfo) {
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, available_kb);
+    }
+    metrics.gl_memory_available_kb.store(available_kb[0], std::memory_order_relaxed);
+}
+
 void Core::cleanup() {
-    //_gui->cleanup();
+    _gui->cleanup();
+
+    _metrics_server.stop();
 
     if (_pM) {
         projectm_destroy(_pM);
     }
+    _overlay_compositor.cleanup();
+    if (_gpu_timer.enabled()) {
+        _gpu_timer.collect();
+        std::istringstream report(_gpu_timer.report());
+        for (std::string line; std::getline(report, line);) {
+            Logger::info(line);
+        }
+    }
+    _gpu_timer.cleanup();
+    if (AllocTracker::enabled()) {
+        std::istringstream report(AllocTracker::report());
+        for (std::string line; std::getline(report, line);) {
+            if (AllocTracker::violations() > 0 && line.rfind("alloc check", 0) == 0) Logger::error(line);
+            else Logger::info(line);
+        }
+    }
     if (_context) {
         SDL_GL_DeleteContext(_context);
     }
@@ -2,8 +2,9 @@
 #include "event_handler.h"
 #include <iostream>
 
-EventHandler::EventHandler(Config& config, PresetManager& presetManager, AnimationManager& animationManager, TextRenderer& textRenderer, TextManager& textManager)
-    : _config(config), _presetManager(presetManager), _animationManager(animationManager), _textRenderer(textRenderer), _textManager(textManager) {}
+EventHandler::EventHandler(Config& config, Renderer& renderer, PresetManager& presetManager, AnimationManager& animationManager, TextRenderer& textRenderer, TextManager& textManager, OverlayCompositor& overlayCompositor)
+    : _config(config), _renderer(renderer), _presetManager(presetManager), _animationManager(animationManager), _textRenderer(textRenderer), _textManager(textManager),
+      _overlayCompositor(overlayCompositor) {}
 
 EventHandler::~EventHandler() {}
 
@@ -35,22 +36,16 @@ void EventHandler::handle_event(const SDL_Event& event, bool& g_quit, int& curre
             default:
                 if (event.key.keysym.sym == _config.next_preset_key) {
                     currentPreset = _presetManager.get_next_preset();
-                    if (!currentPreset.empty()) {
-                        projectm_load_preset_file(pM, currentPreset.c_str(), true);
-                    }
+                    _presetManager.load_preset(pM, currentPreset, true);
                     time_since_last_shuffle = 0.0;
                 } else if (event.key.keysym.sym == _config.prev_preset_key) {
                     currentPreset = _presetManager.get_prev_preset();
-                    if (!currentPreset.empty()) {
-                        projectm_load_preset_file(pM, currentPreset.c_str(), true);
-                    }
+                    _presetManager.load_preset(pM, currentPreset, true);
                     time_since_last_shuffle = 0.0;
                 } else if (event.key.keysym.sym == _config.mark_broken_preset_key) {
                     _presetManager.mark_current_preset_as_broken();
                     currentPreset = _presetManager.get_next_preset();
-                    if (!currentPreset.empty()) {
-                        projectm_load_preset_file(pM, currentPreset.c_str(), true);
-                    }
+                    _presetManager.load_preset(pM, currentPreset, true);
                     time_since_last_shuffle = 0.0;
                 } else if (event.key.keysym.sym == _config.favorite_preset_key) {
                     _presetManager.toggle_favorite_current_preset();
@@ -61,10 +56,15 @@ void EventHandler::handle_event(const SDL_Event& event, bool& g_quit, int& curre
     if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED) {
         _config.width = event.window.data1;
         _config.height = event.window.data2;
-        glViewport(0, 0, _config.width, _config.height);
-        projectm_set_window_size(pM, _config.width, _config.height);
-        _textRenderer.setProjection(_config.width, _config.height);
-        titleLines = _textManager.split_text(_config.songTitle, _config.width, 1.0f);
-        _animationManager.reset(titleLines);
+        // Otherwise the window just shows the fixed-size render scaled; nothing is reallocated.
+        if (_config.render_follows_window && _renderer.resize(_config.width, _config.height)) {
+            _config.render_width = _config.width;
+            _config.render_height = _config.height;
+            projectm_set_window_size(pM, _config.render_width, _config.render_height);
+            _textRenderer.setProjection(_config.render_width, _config.render_height);
+            _overlayCompositor.setProjection(_config.render_width, _config.render_height);
+            titleLines = _textManager.split_text(_config.songTitle, _config.render_width, 1.0f);
+            _animationManager.reset(titleLines);
+        }
     }
 }
\ No newline at end of file
@@ -1,18 +1,32 @@
 // src/main.cpp
 #include "core.h"
+#include "BatchExport.h"
+#include "RenderFarm.h"
 #include "Config.h"
 #include "ConfigLoader.h"
 #include "CliParser.h"
+#include "utils/AllocTracker.h"
 #include "utils/Logger.h"
+#include "utils/Trace.h"
 #include <csignal>
 #include <iostream>
 
-// Global quit flag for signal handler
+// Global quit flag for signal handler: the number of the signal that asked us to quit.
 volatile sig_atomic_t g_quit_flag = 0;
 
+// Only sets the flag; logging is not async-signal-safe, so the loops that see it report the shutdown.
 void signalHandler(int signum) {
-    Logger::info("Caught signal " + std::to_string(signum) + ", shutting down...");
-    g_quit_flag = true;
+    g_quit_flag = signum;
+}
+
+// The export modes notice the flag deep inside their own loops; report it once they have stopped.
+// Their workers have written their own traces by now; this writes the parent's.
+int exitAfterExport(int code) {
+    if (g_quit_flag) {
+        Logger::info("Caught signal ", static_cast<int>(g_quit_flag), ", export stopped.");
+    }
+    Trace::finish();
+    return code;
 }
 
 int main(int argc, char* argv[]) {
@@ -35,10 +49,30 @@ int main(int argc, char* argv[]) {
     }
 
     if (config.show_version) {
-        Logger::info("Aurora Visualizer version " + std::string(APP_VERSION));
+        Logger::info("Aurora Visualizer version ", APP_VERSION);
         return 0;
     }
 
+    if (!config.trace_out_path.empty()) {
+        Trace::start(config.trace_out_path);
+        Trace::set_thread_name("main");
+    }
+    AllocTracker::set_thread_name("main");
+    if (config.alloc_check_warmup_frames > 0 && !AllocTracker::enabled()) {
+        Logger::warn("--alloc-check needs a build with -DAURORA_ALLOC_TRACKING=ON; ignoring it.");
+        config.alloc_check_warmup_frames = 0;
+    }
+
+    if (!config.farm_manifest.empty()) {
+        return exitAfterExport(RenderCoordinator::run(config));
+    }
+    if (!config.farm_connect.empty()) {
+        return exitAfterExport(RenderWorker::run(config));
+    }
+    if (config.batch_export) {
+        return exitAfterExport(BatchExport::run(config));
+    }
+
     Core visualizerCore(config);
     if (!visualizerCore.init()) {
         Logger::error("Failed to initialize visualizer core.");
@@ -47,5 +81,10 @@ int main(int argc, char* argv[]) {
 
     visualizerCore.run();
 
+    Trace::finish();
+
+    if (AllocTracker::check_armed() && AllocTracker::violations() > 0) {
+        return 1; // Details are in the allocation report logged on shutdown.
+    }
     return 0;
 }
\ No newline at end of file
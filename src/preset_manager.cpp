@@ -1,11 +1,16 @@
 // src/preset_manager.cpp
 #include "preset_manager.h"
+#include "Metrics.h"
 #include "utils/Logger.h"
+#include "utils/Trace.h"
+#include "utils/common.h"
 #include <fstream>
 #include <random>
 #include <filesystem>
 #include <cstdlib> // For getenv
 #include <algorithm>
+#include <chrono>
+#include <iterator>
 
 namespace fs = std::filesystem;
 
@@ -14,36 +19,62 @@ const int MAX_HISTORY_SIZE = 50; // Maximum number of presets to keep in history
 PresetManager::PresetManager(const Config& config) : _config(config) {}
 
 void PresetManager::load_presets() {
+    TRACE_SCOPE("preset_scan");
     _all_presets.clear();
+    _preset_info.clear();
+    _playable_presets.clear();
+    _quarantined_presets.clear();
+    _measured_frame_ms.clear();
     _favorite_presets.clear();
     _history.clear();
     _current_preset_index = -1;
     _history_index = -1;
-
-    // Load all presets from the directory
-    try {
-        for (const auto & entry : fs::recursive_directory_iterator(_config.presetsDirectory)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".milk") {
-                _all_presets.push_back(entry.path().string());
+    _search_index.clear();
+    _search_index_dirty = true;
+
+    _pack.close();
+    if (!_config.preset_pack_file.empty()) {
+        // Load all preset names from the pack; the index is already sorted.
+        if (_pack.open(_config.preset_pack_file)) {
+            _all_presets.reserve(_pack.size());
+            for (size_t i = 0; i < _pack.size(); ++i) {
+                _all_presets.emplace_back(_pack.name_at(i));
             }
         }
-    } catch (const fs::filesystem_error& e) {
-        std::cerr << "Error reading presets directory: " << e.what() << std::endl;
+    } else {
+        // Load all presets from the directory
+        try {
+            for (const auto & entry : fs::recursive_directory_iterator(_config.presetsDirectory)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".milk") {
+                    _all_presets.push_back(entry.path().string());
+                }
+            }
+        } catch (const fs::filesystem_error& e) {
+            Logger::error("Error reading presets directory: ", e.what());
+        }
+        std::sort(_all_presets.begin(), _all_presets.end());
     }
 
+    if (_config.max_preset_complexity > 0.0f) {
+        scan_preset_metadata();
+    }
+    load_quarantine();
+    load_cost_report();
+    rebuild_playable_presets();
+
     // Load favorites
     load_favorites();
 
     // Select an initial random preset if available
-    if (!_all_presets.empty()) {
-        std::string initial_preset = get_random_preset(_all_presets);
+    if (!_playable_presets.empty()) {
+        std::string initial_preset = get_random_preset(_playable_presets);
         _history.push_back(initial_preset);
         _history_index = 0;
     }
 }
 
 std::string PresetManager::get_next_preset() {
-    if (_all_presets.empty()) {
+    if (_playable_presets.empty()) {
         return "";
     }
 
@@ -52,7 +83,42 @@ std::string PresetManager::get_next_preset() {
         _history.erase(_history.begin() + _history_index + 1, _history.end());
     }
 
-    std::string preset = get_random_preset(_all_presets);
+    std::string preset = get_random_preset(_playable_presets);
+    push_history(preset);
+    return preset;
+}
+
+std::string PresetManager::get_scheduled_preset(uint64_t seed, uint64_t slot) const {
+    if (_playable_presets.empty()) {
+        return "";
+    }
+    const size_t count = _playable_presets.size();
+    auto pick = [&](uint64_t s, size_t range) {
+        const uint64_t key[2] = {seed, s};
+        return static_cast<size_t>(fnv1a_64(key, sizeof(key)) % range);
+    };
+    if (count == 1) {
+        return _playable_presets[0];
+    }
+    if (count == 2) {
+        return _playable_presets[(slot + pick(0, 2)) % 2];
+    }
+    // Even slots draw freely. Odd slots draw from the rest, leaving out both even
+    // neighbours, so adjacent slots always differ without replaying earlier slots.
+    if (slot % 2 == 0) {
+        return _playable_presets[pick(slot, count)];
+    }
+    const size_t before = pick(slot - 1, count);
+    const size_t after = pick(slot + 1, count);
+    const size_t low = std::min(before, after);
+    const size_t high = std::max(before, after);
+    size_t index = pick(slot, count - (low == high ? 1 : 2));
+    if (index >= low) index++;
+    if (low != high && index >= high) index++;
+    return _playable_presets[index];
+}
+
+void PresetManager::push_history(const std::string& preset) {
     _history.push_back(preset);
     _history_index++;
 
@@ -61,7 +127,6 @@ std::string PresetManager::get_next_preset() {
         _history.erase(_history.begin());
         _history_index--; // Adjust index as the first element was removed
     }
-    return preset;
 }
 
 std::string PresetManager::get_prev_preset() {
@@ -79,6 +144,84 @@ std::string PresetManager::get_current_preset() const {
     return "";
 }
 
+std::vector<std::string> PresetManager::search_presets(const std::string& query, size_t max_results) {
+    TRACE_SCOPE("preset_search");
+    if (_search_index_dirty) {
+        auto start = std::chrono::steady_clock::now();
+        _search_index.build(_all_presets);
+        _search_index_dirty = false;
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        Logger::info("Built preset search index for ", _all_presets.size(), " presets in ",
+                     elapsed.count(), "s");
+    }
+
+    std::vector<std::string> matches;
+    // Ask for a few extra so quarantined presets do not leave the list short.
+    for (const auto& result : _search_index.search(query, max_results + std::min<size_t>(_quarantined_presets.size(), 32))) {
+        const std::string& preset = _all_presets[result.index];
+        if (_quarantined_presets.count(preset) == 0) {
+            matches.push_back(preset);
+            if (matches.size() == max_results) {
+                break;
+            }
+        }
+    }
+    return matches;
+}
+
+std::string PresetManager::jump_to_preset(const std::string& preset) {
+    if (!std::binary_search(_all_presets.begin(), _all_presets.end(), preset)) {
+        return "";
+    }
+    // Like get_next_preset: jumping from an earlier point in history drops the "future".
+    if (_history_index != -1 && _history_index < (int)_history.size() - 1) {
+        _history.erase(_history.begin() + _history_index + 1, _history.end());
+    }
+    push_history(preset);
+    return preset;
+}
+
+
+bool PresetManager::load_preset(projectm_handle pM, const std::string& preset, bool smooth_transition) {
+    TRACE_SCOPE("preset_load");
+    if (preset.empty()) {
+        return false;
+    }
+    Metrics& metrics = Metrics::get();
+    const auto start = std::chrono::steady_clock::now();
+    if (!_pack.is_open()) {
+        projectm_load_preset_file(pM, preset.c_str(), smooth_transition);
+    } else {
+        long index = _pack.find(preset);
+        if (index < 0 || !_pack.read(index, _preset_data)) {
+            Logger::error("Could not read preset from pack: ", preset);
+            metrics.preset_load_failures.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        projectm_load_preset_data(pM, _preset_data.c_str(), smooth_transition);
+    }
+    const auto load_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    metrics.preset_load_seconds.observe(load_time.count() / 1e6);
+    metrics.preset_last_load_us.store(load_time.count(), std::memory_order_relaxed);
+    metrics.preset_loads.fetch_add(1, std::memory_order_relaxed);
+    auto position = std::lower_bound(_all_presets.begin(), _all_presets.end(), preset);
+    metrics.preset_index.store(position != _all_presets.end() && *position == preset ? position - _all_presets.begin() : -1,
+                               std::memory_order_relaxed);
+    return true;
+}
+
+bool PresetManager::read_preset_data(const std::string& preset, std::string& data) const {
+    if (_pack.is_open()) {
+        long index = _pack.find(preset);
+        return index >= 0 && _pack.read(index, data);
+    }
+    std::ifstream file(preset, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
 
 void PresetManager::mark_current_preset_as_broken() {
     std::string current_preset = get_current_preset();
@@ -86,6 +229,13 @@ void PresetManager::mark_current_preset_as_broken() {
         return;
     }
 
+    if (_pack.is_open()) {
+        // Pack entries cannot be moved; drop the preset for this session and let the user rebuild the pack.
+        Logger::warn("Ignoring broken preset for this session (rebuild the pack to remove it): ", current_preset);
+        forget_preset(current_preset);
+        return;
+    }
+
     try {
         fs::path source_path(current_preset);
         
@@ -100,7 +250,7 @@ void PresetManager::mark_current_preset_as_broken() {
                 }
                 broken_dir_path = fs::path(home_dir) / path_without_tilde;
             } else {
-                Logger::warn("HOME environment variable not set. Cannot resolve broken preset directory: " + raw_broken_dir);
+                Logger::warn("HOME environment variable not set. Cannot resolve broken preset directory: ", raw_broken_dir);
                 broken_dir_path = raw_broken_dir;
             }
         } else {
@@ -112,17 +262,155 @@ void PresetManager::mark_current_preset_as_broken() {
 
         fs::rename(source_path, dest_path);
 
-        std::cout << "Moved broken preset to: " << dest_path << std::endl;
+        Logger::info("Moved broken preset to: ", dest_path);
 
         // Remove from all lists
-        _all_presets.erase(std::remove(_all_presets.begin(), _all_presets.end(), current_preset), _all_presets.end());
-        _favorite_presets.erase(std::remove(_favorite_presets.begin(), _favorite_presets.end(), current_preset), _favorite_presets.end());
-        _history.erase(std::remove(_history.begin(), _history.end(), current_preset), _history.end());
-        _history_index--;
+        forget_preset(current_preset);
 
 
     } catch (const fs::filesystem_error& e) {
-        std::cerr << "Error moving preset file: " << e.what() << std::endl;
+        Logger::error("Error moving preset file: ", e.what());
+    }
+}
+
+const PresetInfo* PresetManager::get_preset_info(const std::string& preset) const {
+    if (_preset_info.empty()) {
+        return nullptr;
+    }
+    auto it = std::lower_bound(_all_presets.begin(), _all_presets.end(), preset);
+    if (it == _all_presets.end() || *it != preset) {
+        return nullptr;
+    }
+    return &_preset_info[it - _all_presets.begin()];
+}
+
+void PresetManager::scan_preset_metadata() {
+    auto start = std::chrono::steady_clock::now();
+    if (_pack.is_open()) {
+        _preset_info = PresetMetadata::parse_all(_all_presets.size(), [this](size_t i) {
+            std::string data;
+            return _pack.read(i, data) ? PresetMetadata::parse_data(data.data(), data.size()) : PresetInfo{};
+        });
+    } else {
+        _preset_info = PresetMetadata::parse_all(_all_presets);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    Logger::info("Scanned metadata for ", _preset_info.size(), " presets in ",
+                 elapsed.count(), "s");
+}
+
+void PresetManager::load_quarantine() {
+    if (_config.preset_quarantine_file.empty()) {
+        return;
+    }
+    std::ifstream file(_config.preset_quarantine_file);
+    if (!file.is_open()) {
+        Logger::warn("Could not open preset quarantine file: ", _config.preset_quarantine_file);
+        return;
+    }
+    // One preset per line, optionally followed by a tab and the reason.
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        _quarantined_presets.insert(line.substr(0, line.find('\t')));
+    }
+}
+
+void PresetManager::load_cost_report() {
+    if (_config.preset_cost_report.empty()) {
+        return;
+    }
+    std::ifstream file(_config.preset_cost_report);
+    if (!file.is_open()) {
+        Logger::warn("Could not open preset cost report: ", _config.preset_cost_report);
+        return;
+    }
+    // Columns: preset, status, mean_ms, p95_ms, max_ms, gl_errors
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t first_tab = line.find('\t');
+        size_t second_tab = first_tab == std::string::npos ? std::string::npos : line.find('\t', first_tab + 1);
+        if (second_tab == std::string::npos) {
+            continue;
+        }
+        try {
+            _measured_frame_ms[line.substr(0, first_tab)] = std::stof(line.substr(second_tab + 1));
+        } catch (const std::exception&) {
+            // Presets that never rendered have no timing; the quarantine list covers them.
+        }
+    }
+}
+
+void PresetManager::rebuild_playable_presets() {
+    _playable_presets.clear();
+    size_t quarantined = 0, too_expensive = 0;
+    for (size_t i = 0; i < _all_presets.size(); ++i) {
+        const std::string& preset = _all_presets[i];
+        if (_quarantined_presets.count(preset)) {
+            quarantined++;
+            continue;
+        }
+        // A measured frame time beats the static estimate when we have one.
+        auto measured = _measured_frame_ms.find(preset);
+        if (measured != _measured_frame_ms.end()) {
+            if (_config.max_preset_frame_ms > 0.0f && measured->second > _config.max_preset_frame_ms) {
+                too_expensive++;
+                continue;
+            }
+        } else if (!_preset_info.empty() && _config.max_preset_complexity > 0.0f &&
+                   _preset_info[i].parsed && _preset_info[i].complexity > _config.max_preset_complexity) {
+            too_expensive++;
+            continue;
+        }
+        _playable_presets.push_back(preset);
+    }
+
+    if (quarantined > 0) {
+        Logger::info("Skipping ", quarantined, " quarantined presets");
+    }
+    if (too_expensive > 0) {
+        Logger::info("Skipping ", too_expensive, " presets over the cost limit");
+    }
+    if (_playable_presets.empty() && !_all_presets.empty()) {
+        Logger::warn("No presets pass the quarantine and cost filters. Falling back to the full preset list.");
+        _playable_presets = _all_presets;
+    }
+}
+
+void PresetManager::remove_preset(const std::string& preset) {
+    auto it = std::lower_bound(_all_presets.begin(), _all_presets.end(), preset);
+    if (it != _all_presets.end() && *it == preset) {
+        if (!_preset_info.empty()) {
+            _preset_info.erase(_preset_info.begin() + (it - _all_presets.begin()));
+        }
+        _all_presets.erase(it);
+        _search_index_dirty = true;
+    }
+    _playable_presets.erase(std::remove(_playable_presets.begin(), _playable_presets.end(), preset), _playable_presets.end());
+}
+
+void PresetManager::forget_preset(const std::string& preset) {
+    remove_preset(preset);
+    _favorite_presets.erase(std::remove(_favorite_presets.begin(), _favorite_presets.end(), preset), _favorite_presets.end());
+
+    // The preset may appear several times in history, before or after the current entry.
+    // Step back to the entry that preceded the current one among those that remain.
+    int removed_before = 0;
+    for (int i = 0; i < _history_index && i < (int)_history.size(); ++i) {
+        removed_before += _history[i] == preset;
+    }
+    const bool removed_current = _history_index >= 0 && _history_index < (int)_history.size() && _history[_history_index] == preset;
+    _history.erase(std::remove(_history.begin(), _history.end(), preset), _history.end());
+    _history_index -= removed_before + (removed_current ? 1 : 0);
+    if (_history.empty()) {
+        _history_index = -1;
+    } else {
+        _history_index = std::clamp(_history_index, 0, (int)_history.size() - 1);
     }
 }
 
@@ -136,11 +424,11 @@ void PresetManager::toggle_favorite_current_preset() {
     if (it == _favorite_presets.end()) {
         // Add to favorites
         _favorite_presets.push_back(current_preset);
-        std::cout << "Added to favorites: " << current_preset << std::endl;
+        Logger::info("Added to favorites: ", current_preset);
     } else {
         // Remove from favorites
         _favorite_presets.erase(it);
-        std::cout << "Removed from favorites: " << current_preset << std::endl;
+        Logger::info("Removed from favorites: ", current_preset);
     }
     save_favorites();
 }
@@ -160,7 +448,7 @@ void PresetManager::load_favorites() {
             }
             resolved_path = fs::path(home_dir) / path_without_tilde;
         } else {
-            Logger::warn("HOME environment variable not set. Cannot resolve path: " + raw_path);
+            Logger::warn("HOME environment variable not set. Cannot resolve path: ", raw_path);
             resolved_path = raw_path;
         }
     } else {
@@ -173,7 +461,7 @@ void PresetManager::load_favorites() {
 
     std::ifstream favorites_file(resolved_path.string());
     if (!favorites_file.is_open()) {
-        Logger::error("Could not open favorites file: " + resolved_path.string());
+        Logger::error("Could not open favorites file: ", resolved_path.string());
         return;
     }
 
@@ -198,7 +486,7 @@ void PresetManager::save_favorites() {
             }
             resolved_path = fs::path(home_dir) / path_without_tilde;
         } else {
-            Logger::warn("HOME environment variable not set. Cannot resolve path: " + raw_path);
+            Logger::warn("HOME environment variable not set. Cannot resolve path: ", raw_path);
             resolved_path = raw_path;
         }
     } else {
@@ -207,7 +495,7 @@ void PresetManager::save_favorites() {
 
     std::ofstream favorites_file(resolved_path.string());
     if (!favorites_file.is_open()) {
-        Logger::error("Could not open favorites file for writing: " + resolved_path.string());
+        Logger::error("Could not open favorites file for writing: ", resolved_path.string());
         return;
     }
 
@@ -1,7 +1,8 @@
 #include "renderer.h"
+#include "utils/AllocTracker.h"
 #include <iostream>
 
-Renderer::Renderer() : _window(nullptr), _context(nullptr), _fbo(0), _fbo_texture(0), _rbo(0) {}
+Renderer::Renderer() : _window(nullptr), _context(nullptr), _fbo(0), _fbo_texture(0), _rbo(0), _width(0), _height(0) {}
 
 Renderer::~Renderer() {
     cleanup();
@@ -11,7 +12,9 @@ bool Renderer::init(SDL_Window* window, SDL_GLContext* context, Config& config)
     _window = window;
     _context = context;
 
-    glViewport(0, 0, config.width, config.height);
+    const int width = config.render_width > 0 ? config.render_width : config.width;
+    const int height = config.render_height > 0 ? config.render_height : config.height;
+    glViewport(0, 0, width, height);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
@@ -19,13 +22,48 @@ bool Renderer::init(SDL_Window* window, SDL_GLContext* context, Config& config)
         return false;
     }
 
-    return create_fbo(config.width, config.height);
+    return create_fbo(width, height);
 }
 
 void Renderer::render(projectm_handle pM) {
     render_to_fbo(pM);
 }
 
+void Renderer::present(int window_width, int window_height) {
+    // Fit the render inside the window without distorting it.
+    int dst_width = window_width;
+    int dst_height = static_cast<int>(static_cast<long long>(window_width) * _height / _width);
+    if (dst_height > window_height) {
+        dst_height = window_height;
+        dst_width = static_cast<int>(static_cast<long long>(window_height) * _width / _height);
+    }
+    const int dst_x = (window_width - dst_width) / 2;
+    const int dst_y = (window_height - dst_height) / 2;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glViewport(0, 0, window_width, window_height);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBlitFramebuffer(0, 0, _width, _height, dst_x, dst_y, dst_x + dst_width, dst_y + dst_height,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Renderer::read_pixels(std::vector<unsigned char>& rgb) {
+    rgb.resize(static_cast<size_t>(_width) * _height * 3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, _width, _height, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+}
+
+bool Renderer::resize(int width, int height) {
+    if (width == _width && height == _height) {
+        return true;
+    }
+    cleanup();
+    return create_fbo(width, height);
+}
+
 void Renderer::cleanup() {
     if (_fbo) {
         glDeleteFramebuffers(1, &_fbo);
@@ -36,9 +74,13 @@ void Renderer::cleanup() {
     if (_rbo) {
         glDeleteRenderbuffers(1, &_rbo);
     }
+    _fbo = _fbo_texture = _rbo = 0;
+    _width = _height = 0;
 }
 
 bool Renderer::create_fbo(int width, int height) {
+    _width = width;
+    _height = height;
     glGenFramebuffers(1, &_fbo);
     glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
 
@@ -65,9 +107,14 @@ bool Renderer::create_fbo(int width, int height) {
 
 void Renderer::render_to_fbo(projectm_handle pM) {
     glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+    glViewport(0, 0, _width, _height);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    projectm_opengl_render_frame(pM);
+    {
+        ALLOC_PHASE(ProjectM);
+        projectm_opengl_render_frame(pM);
+    }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // projectM may bind its own framebuffers while rendering.
+    glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
 }
@@ -0,0 +1,195 @@
+// src/utils/AllocTracker.cpp
+#include "utils/AllocTracker.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+const size_t PHASE_COUNT = static_cast<size_t>(AllocPhase::Count);
+const char* const PHASE_NAMES[PHASE_COUNT] = {
+    "other", "events", "animation", "render", "projectm", "overlay", "readback", "encode", "present", "audio"};
+
+// Counters live in a fixed table: registering a thread must not allocate, since
+// it happens inside operator new.
+struct ThreadSlot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> allocations[PHASE_COUNT];
+    std::atomic<uint64_t> bytes[PHASE_COUNT];
+    std::atomic<uint64_t> violations[PHASE_COUNT];
+};
+
+// Threads past the last slot share it.
+const int MAX_THREADS = 64;
+ThreadSlot g_slots[MAX_THREADS];
+std::atomic<int> g_slot_count{0};
+std::atomic<uint64_t> g_frames{0};
+std::atomic<uint64_t> g_frames_at_arm{0};
+std::atomic<bool> g_armed{false};
+std::atomic<uint64_t> g_violations{0};
+
+thread_local ThreadSlot* t_slot = nullptr;
+thread_local AllocPhase t_phase = AllocPhase::Other;
+
+ThreadSlot& thread_slot() {
+    if (!t_slot) {
+        int index = g_slot_count.fetch_add(1, std::memory_order_relaxed);
+        t_slot = &g_slots[index < MAX_THREADS ? index : MAX_THREADS - 1];
+    }
+    return *t_slot;
+}
+
+bool is_checked(AllocPhase phase) {
+    return phase != AllocPhase::Other && phase != AllocPhase::ProjectM;
+}
+
+} // namespace
+
+bool AllocTracker::enabled() {
+#ifdef AURORA_ALLOC_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocPhase AllocTracker::phase() {
+    return t_phase;
+}
+
+void AllocTracker::set_phase(AllocPhase phase) {
+    t_phase = phase;
+}
+
+void AllocTracker::set_thread_name(const char* name) {
+    thread_slot().name.store(name, std::memory_order_relaxed);
+}
+
+void AllocTracker::record(size_t bytes) {
+    ThreadSlot& slot = thread_slot();
+    const size_t phase = static_cast<size_t>(t_phase);
+    slot.allocations[phase].fetch_add(1, std::memory_order_relaxed);
+    slot.bytes[phase].fetch_add(bytes, std::memory_order_relaxed);
+    if (g_armed.load(std::memory_order_relaxed) && is_checked(t_phase)) {
+        slot.violations[phase].fetch_add(1, std::memory_order_relaxed);
+        g_violations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AllocTracker::end_frame() {
+    g_frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocTracker::arm_check() {
+    g_frames_at_arm.store(g_frames.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    g_armed.store(true, std::memory_order_relaxed);
+}
+
+bool AllocTracker::check_armed() {
+    return g_armed.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocTracker::violations() {
+    return g_violations.load(std::memory_order_relaxed);
+}
+
+std::string AllocTracker::report() {
+    const uint64_t frames = g_frames.load(std::memory_order_relaxed);
+    const int slot_count = std::min(g_slot_count.load(std::memory_order_relaxed), MAX_THREADS);
+    std::string report;
+    char line[256];
+    for (int i = 0; i < slot_count; ++i) {
+        const ThreadSlot& slot = g_slots[i];
+        const char* name = slot.name.load(std::memory_order_relaxed);
+        std::string thread = name ? name : "thread " + std::to_string(i + 1);
+        for (size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+            const uint64_t allocations = slot.allocations[phase].load(std::memory_order_relaxed);
+            if (!allocations) continue;
+            const uint64_t bytes = slot.bytes[phase].load(std::memory_order_relaxed);
+            const uint64_t violations = slot.violations[phase].load(std::memory_order_relaxed);
+            int length = std::snprintf(line, sizeof(line), "alloc %s %s: %llu allocations, %llu bytes",
+                                       thread.c_str(), PHASE_NAMES[phase], static_cast<unsigned long long>(allocations),
+                                       static_cast<unsigned long long>(bytes));
+            if (frames && phase != static_cast<size_t>(AllocPhase::Other)) {
+                length += std::snprintf(line + length, sizeof(line) - length, " (%.2f per frame)",
+                                        static_cast<double>(allocations) / frames);
+            }
+            if (violations) {
+                std::snprintf(line + length, sizeof(line) - length, ", %llu in steady state",
+                              static_cast<unsigned long long>(violations));
+            }
+            report += line;
+            report += "\n";
+        }
+    }
+    if (g_slot_count.load(std::memory_order_relaxed) > MAX_THREADS) {
+        report += "alloc: more than " + std::to_string(MAX_THREADS) + " threads; the last row covers the rest\n";
+    }
+    if (g_armed.load(std::memory_order_relaxed)) {
+        const uint64_t checked_frames = frames - g_frames_at_arm.load(std::memory_order_relaxed);
+        const uint64_t violations = g_violations.load(std::memory_order_relaxed);
+        report += "alloc check: " + std::to_string(violations) + " allocations in " + std::to_string(checked_frames) +
+                  " steady-state frames, " + (violations ? "FAILED" : "passed") + "\n";
+    }
+    return report;
+}
+
+#ifdef AURORA_ALLOC_TRACKING
+
+namespace {
+
+void* tracked_alloc(size_t size) {
+    AllocTracker::record(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* tracked_aligned_alloc(size_t size, std::align_val_t alignment) {
+    AllocTracker::record(size);
+    void* pointer = nullptr;
+    const size_t align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    return posix_memalign(&pointer, align, size ? size : 1) == 0 ? pointer : nullptr;
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    if (void* pointer = tracked_alloc(size)) return pointer;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+    if (void* pointer = tracked_alloc(size)) return pointer;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size); }
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (void* pointer = tracked_aligned_alloc(size, alignment)) return pointer;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+    if (void* pointer = tracked_aligned_alloc(size, alignment)) return pointer;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return tracked_aligned_alloc(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return tracked_aligned_alloc(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { std::free(pointer); }
+
+#endif // AURORA_ALLOC_TRACKING
@@ -0,0 +1,83 @@
+// src/utils/Histogram.cpp
+#include "utils/Histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+const double SMALLEST_MS = 0.001; // Upper edge of bucket 0.
+
+int bucket_for(double value_ms) {
+    if (!(value_ms > SMALLEST_MS)) {
+        return 0;
+    }
+    int bucket = 1 + static_cast<int>(std::log2(value_ms / SMALLEST_MS) * Histogram::BUCKETS_PER_DOUBLING);
+    return std::min(bucket, Histogram::BUCKET_COUNT - 1);
+}
+
+// Geometric middle of a bucket, which is where a sample in it is most likely to be.
+double bucket_value(int bucket) {
+    if (bucket == 0) {
+        return SMALLEST_MS;
+    }
+    return SMALLEST_MS * std::exp2((bucket - 0.5) / Histogram::BUCKETS_PER_DOUBLING);
+}
+
+} // namespace
+
+Histogram::Histogram() {
+    reset();
+}
+
+void Histogram::add(double value_ms) {
+    _buckets[bucket_for(value_ms)]++;
+    _min = _count ? std::min(_min, value_ms) : value_ms;
+    _max = _count ? std::max(_max, value_ms) : value_ms;
+    _sum += value_ms;
+    _count++;
+}
+
+void Histogram::merge(const Histogram& other) {
+    if (!other._count) {
+        return;
+    }
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        _buckets[i] += other._buckets[i];
+    }
+    _min = _count ? std::min(_min, other._min) : other._min;
+    _max = _count ? std::max(_max, other._max) : other._max;
+    _sum += other._sum;
+    _count += other._count;
+}
+
+void Histogram::reset() {
+    _buckets.fill(0);
+    _count = 0;
+    _sum = 0.0;
+    _min = 0.0;
+    _max = 0.0;
+}
+
+double Histogram::percentile(double p) const {
+    if (!_count) {
+        return 0.0;
+    }
+    const uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 1.0) * _count));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += _buckets[i];
+        if (seen >= std::max<uint64_t>(rank, 1)) {
+            return std::clamp(bucket_value(i), _min, _max);
+        }
+    }
+    return _max;
+}
+
+std::string Histogram::summary() const {
+    char buffer[160];
+    std::snprintf(buffer, sizeof(buffer), "n=%llu mean=%.3f p50=%.3f p95=%.3f p99=%.3f max=%.3f",
+                  static_cast<unsigned long long>(_count), mean(), percentile(0.5), percentile(0.95),
+                  percentile(0.99), max());
+    return buffer;
+}
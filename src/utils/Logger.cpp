@@ -1,5 +1,225 @@
+// src/utils/Logger.cpp
 #include "utils/Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <pthread.h>
 
-LogLevel Logger::_log_level = LogLevel::INFO;
-bool Logger::_verbose_logging = false;
-std::mutex Logger::_mutex;
+std::atomic<LogLevel> Logger::_log_level{LogLevel::INFO};
+std::atomic<bool> Logger::_verbose_logging{false};
+
+void LogMessage::append(std::string_view value) {
+    size_t count = std::min(value.size(), CAPACITY - length);
+    memcpy(text + length, value.data(), count);
+    length += static_cast<uint16_t>(count);
+    if (count < value.size() && CAPACITY >= 3) {
+        memcpy(text + CAPACITY - 3, "...", 3); // Truncated.
+    }
+}
+
+void LogMessage::append_signed(long long value) {
+    char digits[24];
+    int count = std::snprintf(digits, sizeof(digits), "%lld", value);
+    append(std::string_view(digits, count));
+}
+
+void LogMessage::append_unsigned(unsigned long long value) {
+    char digits[24];
+    int count = std::snprintf(digits, sizeof(digits), "%llu", value);
+    append(std::string_view(digits, count));
+}
+
+void LogMessage::append_double(double value) {
+    char digits[32];
+    int count = std::snprintf(digits, sizeof(digits), "%g", value);
+    append(std::string_view(digits, count));
+}
+
+namespace {
+
+const char* prefix(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "[DEBUG] ";
+        case LogLevel::INFO: return "[INFO] ";
+        case LogLevel::WARN: return "[WARNING] ";
+        case LogLevel::ERROR: return "[ERROR] ";
+    }
+    return "";
+}
+
+void write_line(FILE* out, const LogMessage& message) {
+    std::fputs(prefix(message.level), out);
+    std::fwrite(message.text, 1, message.length, out);
+    std::fputc('\n', out);
+}
+
+// Bounded multi-producer ring (Vyukov): each slot's sequence number says
+// whether it is free for the producer at that position or holds a message for
+// the consumer. Producers claim positions with a CAS and never wait.
+class LogRing {
+public:
+    static constexpr size_t SLOTS = 1024; // About 1 MB; bursts beyond that are dropped.
+
+    LogRing() {
+        for (size_t i = 0; i < SLOTS; ++i) _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(const LogMessage& message) {
+        size_t position = _tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &_slots[position % SLOTS];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (difference < 0) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = _tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->level = message.level;
+        slot->length = message.length;
+        memcpy(slot->text, message.text, message.length);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Single consumer only.
+    bool pop(LogMessage& message) {
+        Slot& slot = _slots[_head % SLOTS];
+        if (slot.sequence.load(std::memory_order_acquire) != _head + 1) {
+            return false;
+        }
+        message.level = slot.level;
+        message.length = slot.length;
+        memcpy(message.text, slot.text, slot.length);
+        slot.sequence.store(_head + SLOTS, std::memory_order_release);
+        _head++;
+        return true;
+    }
+
+    size_t tail() const { return _tail.load(std::memory_order_acquire); }
+    size_t head() const { return _head; }
+    size_t take_dropped() { return _dropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        uint16_t length;
+        char text[LogMessage::CAPACITY];
+    };
+
+    Slot _slots[SLOTS];
+    alignas(64) std::atomic<size_t> _tail{0};
+    alignas(64) size_t _head = 0;
+    std::atomic<size_t> _dropped{0};
+};
+
+// Owns the ring and the thread that drains it. Created on first use and never
+// destroyed, so messages logged from static destructors still go out.
+class LogWriter {
+public:
+    LogWriter() : _running(true), _drained(0) {
+        _thread = std::thread([this] { run(); });
+        // The writer thread does not survive fork(); a child writes directly instead.
+        pthread_atfork(nullptr, nullptr, [] { _direct.store(true, std::memory_order_relaxed); });
+        std::atexit([] { writer().shutdown(); });
+    }
+
+    void submit(const LogMessage& message) {
+        if (_direct.load(std::memory_order_relaxed)) {
+            write_line(stderr, message);
+            return;
+        }
+        _ring.push(message);
+    }
+
+    void flush() {
+        if (_direct.load(std::memory_order_relaxed)) {
+            std::fflush(stderr);
+            return;
+        }
+        const size_t target = _ring.tail();
+        std::unique_lock<std::mutex> lock(_mutex);
+        _flush_requested = true;
+        _wake.notify_all();
+        _flushed.wait_for(lock, std::chrono::seconds(2), [&] { return _drained >= target || !_running; });
+    }
+
+    // Writes what is queued and switches to direct writes for the rest of the process.
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        _wake.notify_all();
+        if (_thread.joinable()) _thread.join();
+        _direct.store(true, std::memory_order_relaxed);
+        drain();
+    }
+
+    static LogWriter& writer() {
+        static LogWriter* instance = new LogWriter();
+        return *instance;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_running) {
+            // Producers never signal, so logging stays free for them; poll instead.
+            _wake.wait_for(lock, std::chrono::milliseconds(20), [&] { return _flush_requested || !_running; });
+            _flush_requested = false;
+            lock.unlock();
+            drain();
+            lock.lock();
+            _drained = _ring.head();
+            _flushed.notify_all();
+        }
+    }
+
+    void drain() {
+        LogMessage message(LogLevel::INFO);
+        bool wrote = false;
+        while (_ring.pop(message)) {
+            write_line(stderr, message);
+            wrote = true;
+        }
+        if (size_t dropped = _ring.take_dropped()) {
+            std::fprintf(stderr, "[WARNING] Logger dropped %zu messages; the log ring was full.\n", dropped);
+            wrote = true;
+        }
+        if (wrote) std::fflush(stderr);
+    }
+
+    static std::atomic<bool> _direct;
+
+    LogRing _ring;
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _flushed;
+    bool _running;
+    bool _flush_requested = false;
+    size_t _drained;
+};
+
+std::atomic<bool> LogWriter::_direct{false};
+
+} // namespace
+
+void Logger::submit(const LogMessage& message) {
+    LogWriter::writer().submit(message);
+}
+
+void Logger::flush() {
+    LogWriter::writer().flush();
+}
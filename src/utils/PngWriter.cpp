@@ -0,0 +1,67 @@
+// src/utils/PngWriter.cpp
+#include "utils/PngWriter.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+
+void put_u32(std::vector<unsigned char>& out, uint32_t value) {
+    out.push_back(static_cast<unsigned char>(value >> 24));
+    out.push_back(static_cast<unsigned char>(value >> 16));
+    out.push_back(static_cast<unsigned char>(value >> 8));
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+void write_chunk(std::ofstream& file, const char type[4], const std::vector<unsigned char>& data) {
+    std::vector<unsigned char> chunk;
+    put_u32(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    // The CRC covers the type and the data, not the length.
+    uLong crc = crc32(0L, chunk.data() + 4, static_cast<uInt>(chunk.size() - 4));
+    put_u32(chunk, static_cast<uint32_t>(crc));
+    file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+} // namespace
+
+bool write_png(const std::string& path, const unsigned char* rgb, int width, int height, bool flip_vertically) {
+    const size_t row_bytes = static_cast<size_t>(width) * 3;
+    // Each scanline is prefixed with filter type 0 (none).
+    std::vector<unsigned char> raw((row_bytes + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        int source_row = flip_vertically ? height - 1 - y : y;
+        raw[y * (row_bytes + 1)] = 0;
+        memcpy(&raw[y * (row_bytes + 1) + 1], rgb + source_row * row_bytes, row_bytes);
+    }
+
+    uLongf compressed_size = compressBound(raw.size());
+    std::vector<unsigned char> compressed(compressed_size);
+    if (compress2(compressed.data(), &compressed_size, raw.data(), raw.size(), Z_BEST_COMPRESSION) != Z_OK) {
+        return false;
+    }
+    compressed.resize(compressed_size);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<unsigned char> header;
+    put_u32(header, static_cast<uint32_t>(width));
+    put_u32(header, static_cast<uint32_t>(height));
+    header.push_back(8); // bit depth
+    header.push_back(2); // colour type: truecolour
+    header.push_back(0); // compression
+    header.push_back(0); // filter
+    header.push_back(0); // interlace
+    write_chunk(file, "IHDR", header);
+    write_chunk(file, "IDAT", compressed);
+    write_chunk(file, "IEND", {});
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,168 @@
+// src/utils/Trace.cpp
+#include "utils/Trace.h"
+#include "utils/Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    int64_t start_us;
+    int64_t duration_us;
+};
+
+// Owned by the registry rather than the thread, so spans survive threads that exit early.
+struct ThreadBuffer {
+    int tid;
+    const char* thread_name = nullptr;
+    std::mutex mutex; // Only contended while the trace is written out.
+    std::vector<TraceEvent> events;
+    size_t dropped = 0;
+};
+
+// Bounds memory for a long show: about 24 MB per thread.
+const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+std::mutex g_registry_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+const auto g_epoch = std::chrono::steady_clock::now();
+std::string g_path; // From Trace::start().
+bool g_forked = false;
+
+ThreadBuffer& thread_buffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        g_buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = g_buffers.back().get();
+        buffer->tid = static_cast<int>(g_buffers.size());
+    }
+    return *buffer;
+}
+
+void write_json_string(FILE* file, const char* text) {
+    std::fputc('"', file);
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            std::fputc('\\', file);
+            std::fputc(*c, file);
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            std::fprintf(file, "\\u%04x", static_cast<unsigned char>(*c));
+        } else {
+            std::fputc(*c, file);
+        }
+    }
+    std::fputc('"', file);
+}
+
+} // namespace
+
+std::atomic<bool> Trace::_enabled{false};
+
+void Trace::start(const std::string& path) {
+    g_path = path;
+    _enabled.store(true, std::memory_order_relaxed);
+}
+
+bool Trace::finish() {
+    if (g_path.empty() || !enabled()) {
+        return true;
+    }
+    if (!g_forked) {
+        return write(g_path);
+    }
+    const std::filesystem::path path(g_path);
+    const std::string extension = path.extension().string();
+    return write(g_path.substr(0, g_path.size() - extension.size()) + "." + std::to_string(getpid()) + extension);
+}
+
+void Trace::forked() {
+    if (!enabled()) {
+        return;
+    }
+    g_forked = true;
+    // Only the forking thread lives on in the child. The other threads' buffers are
+    // abandoned rather than freed, since their mutexes may have been held at the fork.
+    ThreadBuffer& own = thread_buffer();
+    std::vector<std::unique_ptr<ThreadBuffer>> kept;
+    for (std::unique_ptr<ThreadBuffer>& buffer : g_buffers) {
+        if (buffer.get() == &own) {
+            kept.push_back(std::move(buffer));
+        } else {
+            buffer.release();
+        }
+    }
+    g_buffers.swap(kept);
+    own.events.clear();
+    own.dropped = 0;
+}
+
+int64_t Trace::now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+void Trace::record(const char* name, int64_t start_us, int64_t end_us) {
+    ThreadBuffer& buffer = thread_buffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= MAX_EVENTS_PER_THREAD) {
+        buffer.dropped++;
+        return;
+    }
+    buffer.events.push_back({name, start_us, end_us - start_us});
+}
+
+void Trace::set_thread_name(const char* name) {
+    ThreadBuffer& buffer = thread_buffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.thread_name = name;
+}
+
+bool Trace::write(const std::string& path) {
+    _enabled.store(false, std::memory_order_relaxed);
+
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        Logger::error("Could not open trace output ", path);
+        return false;
+    }
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool first = true;
+    size_t event_count = 0, dropped = 0;
+    // Keeps the workers of an export apart when their traces are opened together.
+    const int pid = static_cast<int>(getpid());
+    std::lock_guard<std::mutex> registry_lock(g_registry_mutex);
+    for (const auto& buffer : g_buffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        if (buffer->thread_name) {
+            std::fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                         first ? "" : ",\n", pid, buffer->tid);
+            write_json_string(file, buffer->thread_name);
+            std::fputs("}}", file);
+            first = false;
+        }
+        for (const TraceEvent& event : buffer->events) {
+            std::fputs(first ? "{\"ph\":\"X\",\"name\":" : ",\n{\"ph\":\"X\",\"name\":", file);
+            write_json_string(file, event.name);
+            std::fprintf(file, ",\"pid\":%d,\"tid\":%d,\"ts\":%lld,\"dur\":%lld}", pid, buffer->tid,
+                         static_cast<long long>(event.start_us), static_cast<long long>(event.duration_us));
+            first = false;
+        }
+        event_count += buffer->events.size();
+        dropped += buffer->dropped;
+    }
+    std::fputs("\n]}\n", file);
+    const bool ok = std::fclose(file) == 0;
+    if (!ok) {
+        Logger::error("Failed to write trace output ", path);
+        return false;
+    }
+    Logger::info("Wrote ", event_count, " trace spans to ", path,
+                 (dropped ? " (" + std::to_string(dropped) + " dropped, per-thread buffer full)" : ""));
+    return true;
+}
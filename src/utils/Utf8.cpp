@@ -0,0 +1,42 @@
+// src/utils/Utf8.cpp
+#include "utils/Utf8.h"
+
+uint32_t utf8_decode_next(const std::string& text, size_t& pos) {
+    const unsigned char lead = static_cast<unsigned char>(text[pos]);
+    if (lead < 0x80) {
+        ++pos;
+        return lead;
+    }
+
+    int length;
+    uint32_t codepoint;
+    uint32_t minimum;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2; codepoint = lead & 0x1F; minimum = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3; codepoint = lead & 0x0F; minimum = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4; codepoint = lead & 0x07; minimum = 0x10000;
+    } else {
+        ++pos;
+        return UTF8_REPLACEMENT_CHARACTER;
+    }
+    if (pos + length > text.size()) {
+        ++pos;
+        return UTF8_REPLACEMENT_CHARACTER;
+    }
+    for (int i = 1; i < length; ++i) {
+        const unsigned char next = static_cast<unsigned char>(text[pos + i]);
+        if ((next & 0xC0) != 0x80) {
+            ++pos;
+            return UTF8_REPLACEMENT_CHARACTER;
+        }
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+    if (codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        ++pos;
+        return UTF8_REPLACEMENT_CHARACTER;
+    }
+    pos += length;
+    return codepoint;
+}
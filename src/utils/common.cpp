@@ -1,6 +1,7 @@
 // src/utils/common.cpp
 #include "utils/common.h"
 #include <algorithm>
+#include <cstring>
 #include <sstream>
 
 std::string sanitize_filename(const std::string &filepath) {
@@ -40,4 +41,20 @@ std::vector<std::string> wrapText(const std::string &text,
   }
 
   return lines;
-}
\ No newline at end of file
+}
+
+uint64_t fnv1a_64(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void flip_rows(const unsigned char* src, unsigned char* dst, size_t row_bytes, int rows) {
+    for (int y = 0; y < rows; ++y) {
+        memcpy(dst + y * row_bytes, src + (rows - 1 - y) * row_bytes, row_bytes);
+    }
+}
@@ -0,0 +1,425 @@
+// tools/aurora_bench.cpp
+// Renders a fixed preset list headlessly across a matrix of resolutions, mesh sizes,
+// text overlays and recording, fed with deterministic synthetic audio, and reports
+// throughput, frame-time percentiles and peak memory per configuration as JSON.
+#include "AnimationManager.h"
+#include "AudioFeed.h"
+#include "Config.h"
+#include "HeadlessContext.h"
+#include "OverlayCompositor.h"
+#include "SyntheticAudio.h"
+#include "TextManager.h"
+#include "TextRenderer.h"
+#include "preset_manager.h"
+#include "renderer.h"
+#include "utils/Logger.h"
+#include "utils/common.h"
+#include <GL/glew.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchOptions {
+    std::vector<std::pair<int, int>> resolutions = {{640, 360}, {1280, 720}, {1920, 1080}};
+    std::vector<std::pair<int, int>> meshes = {{32, 24}, {64, 48}};
+    std::vector<bool> overlays = {false, true};
+    std::vector<bool> recording = {false, true};
+    std::string preset_list;   // One preset path per line; empty means the first `preset_count` found.
+    size_t preset_count = 8;
+    int fps = 30;
+    int frames = 240;          // Measured frames per preset.
+    int warmup_frames = 30;    // Rendered after each preset load and not measured.
+    std::string audio = "mix"; // Synthetic signal: sweep, pink, kick or mix (all three).
+    std::string out;           // JSON report path; stdout if empty.
+};
+
+enum OverlayBlock : size_t { OVERLAY_TITLE, OVERLAY_ARTIST, OVERLAY_URL };
+
+struct BenchConfig {
+    int width, height;
+    int mesh_width, mesh_height;
+    bool overlays;
+    bool recording;
+};
+
+struct BenchResult {
+    BenchConfig config;
+    size_t frames = 0;
+    double fps = 0.0;
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+    long peak_rss_kb = 0;
+};
+
+void print_usage(const char* program) {
+    // No config file is read, so the defaults shown are Config's built-in ones.
+    const Config defaults;
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --presets-directory <dir>  Presets to choose from (default: " << defaults.presetsDirectory << ")\n"
+              << "  --preset-pack <file>       Choose from the presets in an aurora-pack file instead\n"
+              << "  --preset-list <file>       Presets to render, one path per line\n"
+              << "  --preset-count <n>         Without a list, the first N presets by name (default: 8)\n"
+              << "  --resolutions <WxH,...>    Render sizes (default: 640x360,1280x720,1920x1080)\n"
+              << "  --meshes <WxH,...>         projectM mesh sizes (default: 32x24,64x48)\n"
+              << "  --overlays <off,on>        Text overlay settings to run (default: off,on)\n"
+              << "  --recording <off,on>       Recording settings to run (default: off,on)\n"
+              << "  --font-path <file>         Overlay font (default: " << defaults.font_path << ")\n"
+              << "  --fps <value>              Audio samples are fed at this frame rate (default: 30)\n"
+              << "  --frames <n>               Measured frames per preset (default: 240)\n"
+              << "  --warmup <n>               Unmeasured frames after each preset load (default: 30)\n"
+              << "  --audio <sweep|pink|kick|mix>  Synthetic audio feed (default: mix)\n"
+              << "  --out <path>               JSON report (default: stdout)\n";
+}
+
+bool parse_sizes(const std::string& text, std::vector<std::pair<int, int>>& sizes) {
+    sizes.clear();
+    std::istringstream items(text);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        int width = 0, height = 0;
+        char x = 0;
+        std::istringstream fields(item);
+        if (!(fields >> width >> x >> height) || x != 'x' || width <= 0 || height <= 0) {
+            Logger::error("Invalid size: ", item, " (expected WxH)");
+            return false;
+        }
+        sizes.emplace_back(width, height);
+    }
+    return !sizes.empty();
+}
+
+bool parse_switches(const std::string& text, std::vector<bool>& switches) {
+    switches.clear();
+    std::istringstream items(text);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        if (item == "on") switches.push_back(true);
+        else if (item == "off") switches.push_back(false);
+        else {
+            Logger::error("Invalid setting: ", item, " (expected on or off)");
+            return false;
+        }
+    }
+    return !switches.empty();
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// Resets the kernel's peak RSS so the next reading covers one configuration only.
+// Without /proc/self/clear_refs (non-Linux, old kernels) the peak is since startup.
+void reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    if (clear_refs.is_open()) clear_refs << "5";
+}
+
+long peak_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stol(line.substr(6));
+        }
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+std::string json_string(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// Everything a configuration needs that outlives it: the GL context and the text pipeline.
+struct BenchContext {
+    Config& config;
+    Renderer& renderer;
+    TextRenderer& text_renderer;
+    TextManager& text_manager;
+    OverlayCompositor& overlay;
+    AnimationManager& animation;
+    PresetManager& presets;
+};
+
+BenchResult run_config(const BenchOptions& options, BenchContext& bench, const BenchConfig& bench_config,
+                       const std::vector<std::string>& preset_list) {
+    BenchResult result;
+    result.config = bench_config;
+    Config& config = bench.config;
+    config.render_width = bench_config.width;
+    config.render_height = bench_config.height;
+    bench.renderer.resize(bench_config.width, bench_config.height);
+    bench.overlay.setProjection(bench_config.width, bench_config.height);
+
+    // A fresh projectM instance and audio feed per configuration, so every one sees the same input.
+    projectm_handle pM = projectm_create();
+    if (!pM) {
+        Logger::error("Failed to create projectM instance.");
+        return result;
+    }
+    projectm_set_window_size(pM, bench_config.width, bench_config.height);
+    projectm_set_mesh_size(pM, bench_config.mesh_width, bench_config.mesh_height);
+    projectm_set_preset_locked(pM, true);
+    const std::vector<int16_t> no_pcm;
+    AudioFeed audio(options.audio, no_pcm, options.fps);
+
+    std::vector<std::string> title_lines;
+    if (bench_config.overlays) {
+        title_lines = bench.text_manager.split_text(config.songTitle, bench_config.width, 1.0f);
+        bench.animation.reset(title_lines);
+    }
+    OverlayTextStyle song_info_style;
+    song_info_style.color = config.songInfoFontColor;
+    song_info_style.show_border = config.show_text_border;
+    song_info_style.border_color = config.songInfoBorderColor;
+    song_info_style.border_thickness = config.songInfoBorderThickness;
+    OverlayTextStyle url_style = song_info_style;
+    url_style.scale = static_cast<float>(config.urlFontSize) / static_cast<float>(config.songInfoFontSize);
+    url_style.color = config.urlFontColor;
+    url_style.border_color = config.urlBorderColor;
+    url_style.border_thickness = config.urlBorderThickness;
+
+    // Recording is measured up to the encoder: readback, flip, and a write to a null sink.
+    // The encoder itself is a separate ffmpeg process and only costs this one pipe bandwidth.
+    std::vector<unsigned char> frame_buffer, flipped_buffer;
+    FILE* sink = bench_config.recording ? std::fopen("/dev/null", "wb") : nullptr;
+
+    const double music_len = static_cast<double>(options.warmup_frames + options.frames) / options.fps;
+    std::vector<double> frame_ms;
+    frame_ms.reserve(preset_list.size() * options.frames);
+    reset_peak_rss();
+
+    for (const std::string& preset : preset_list) {
+        if (!bench.presets.load_preset(pM, preset, false)) {
+            Logger::warn("Skipping preset that failed to load: ", preset);
+            continue;
+        }
+        for (int frame = 0; frame < options.warmup_frames + options.frames; ++frame) {
+            audio.feed(pM);
+            auto start = std::chrono::steady_clock::now();
+
+            bench.renderer.render(pM);
+            if (bench_config.overlays) {
+                bench.text_renderer.beginFrame();
+                bench.animation.update(music_len, static_cast<double>(frame) / options.fps);
+                const float alpha = bench.animation.getAlpha();
+                const float scale = bench.animation.getBreathingScale();
+                bench.overlay.setBlock(OVERLAY_TITLE, title_lines, bench.animation.getTitleLineOffsets(), song_info_style);
+                glm::vec2 title_pos = bench.animation.getTitleBlockPosition();
+                bench.overlay.drawBlock(OVERLAY_TITLE, title_pos.x, title_pos.y, scale, alpha);
+                bench.overlay.setBlock(OVERLAY_ARTIST, config.artistName, song_info_style);
+                glm::vec2 artist_pos = bench.animation.getArtistPosition();
+                bench.overlay.drawBlock(OVERLAY_ARTIST, artist_pos.x, artist_pos.y, scale, alpha);
+                bench.overlay.setBlock(OVERLAY_URL, config.urlText, url_style);
+                bench.overlay.drawBlock(OVERLAY_URL, 10, 10, scale, 1.0f);
+            }
+            if (sink) {
+                bench.renderer.read_pixels(frame_buffer);
+                flipped_buffer.resize(frame_buffer.size());
+                flip_rows(frame_buffer.data(), flipped_buffer.data(), static_cast<size_t>(bench_config.width) * 3, bench_config.height);
+                std::fwrite(flipped_buffer.data(), 1, flipped_buffer.size(), sink);
+            }
+            glFinish();
+
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (frame >= options.warmup_frames) {
+                frame_ms.push_back(elapsed.count());
+            }
+        }
+    }
+
+    result.peak_rss_kb = peak_rss_kb();
+    if (sink) std::fclose(sink);
+    projectm_destroy(pM);
+
+    if (!frame_ms.empty()) {
+        double total = 0.0;
+        for (double ms : frame_ms) total += ms;
+        result.frames = frame_ms.size();
+        result.fps = total > 0.0 ? 1000.0 * frame_ms.size() / total : 0.0;
+        result.mean_ms = total / frame_ms.size();
+        result.p50_ms = percentile(frame_ms, 0.50);
+        result.p95_ms = percentile(frame_ms, 0.95);
+        result.p99_ms = percentile(frame_ms, 0.99);
+        result.max_ms = *std::max_element(frame_ms.begin(), frame_ms.end());
+    }
+    return result;
+}
+
+void write_report(std::ostream& out, const BenchOptions& options, const std::vector<std::string>& preset_list,
+                  const std::vector<BenchResult>& results) {
+    const char* gl_renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"gl_renderer\": " << json_string(gl_renderer ? gl_renderer : "unknown") << ",\n"
+        << "  \"audio\": " << json_string(options.audio) << ",\n"
+        << "  \"fps\": " << options.fps << ",\n"
+        << "  \"frames_per_preset\": " << options.frames << ",\n"
+        << "  \"warmup_frames\": " << options.warmup_frames << ",\n"
+        << "  \"presets\": [";
+    for (size_t i = 0; i < preset_list.size(); ++i) {
+        out << (i ? ", " : "") << json_string(preset_list[i]);
+    }
+    out << "],\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"width\": " << r.config.width << ", \"height\": " << r.config.height
+            << ", \"mesh\": \"" << r.config.mesh_width << "x" << r.config.mesh_height << "\""
+            << ", \"overlays\": " << (r.config.overlays ? "true" : "false")
+            << ", \"recording\": " << (r.config.recording ? "true" : "false")
+            << ", \"frames\": " << r.frames << ", \"fps\": " << r.fps << ", \"mean_ms\": " << r.mean_ms
+            << ", \"p50_ms\": " << r.p50_ms << ", \"p95_ms\": " << r.p95_ms << ", \"p99_ms\": " << r.p99_ms
+            << ", \"max_ms\": " << r.max_ms << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    out << "  ],\n  \"process_peak_rss_kb\": " << usage.ru_maxrss << "\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Config config;
+    BenchOptions options;
+    std::vector<std::string> args(argv + 1, argv + argc);
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool has_value = i + 1 < args.size();
+        if (arg == "-h" || arg == "--help") { print_usage(argv[0]); return 0; }
+        else if (arg == "--verbose") { Logger::set_verbose_logging(true); }
+        else if (!has_value) { Logger::error("Missing value or unknown option: ", arg); print_usage(argv[0]); return 1; }
+        else if (arg == "--presets-directory") config.presetsDirectory = args[++i];
+        else if (arg == "--preset-pack") config.preset_pack_file = args[++i];
+        else if (arg == "--preset-list") options.preset_list = args[++i];
+        else if (arg == "--preset-count") options.preset_count = std::max(1ul, std::stoul(args[++i]));
+        else if (arg == "--resolutions") { if (!parse_sizes(args[++i], options.resolutions)) return 1; }
+        else if (arg == "--meshes") { if (!parse_sizes(args[++i], options.meshes)) return 1; }
+        else if (arg == "--overlays") { if (!parse_switches(args[++i], options.overlays)) return 1; }
+        else if (arg == "--recording") { if (!parse_switches(args[++i], options.recording)) return 1; }
+        else if (arg == "--font-path") config.font_path = args[++i];
+        else if (arg == "--fps") options.fps = std::max(1, std::stoi(args[++i]));
+        else if (arg == "--frames") options.frames = std::max(1, std::stoi(args[++i]));
+        else if (arg == "--warmup") options.warmup_frames = std::max(0, std::stoi(args[++i]));
+        else if (arg == "--audio") options.audio = args[++i];
+        else if (arg == "--out") options.out = args[++i];
+        else { Logger::error("Unknown option: ", arg); print_usage(argv[0]); return 1; }
+    }
+
+    SyntheticSignal signal;
+    if (!SyntheticAudio::parse_signal(options.audio, signal)) {
+        Logger::error("Unknown audio signal: ", options.audio, " (expected sweep, pink, kick or mix)");
+        return 1;
+    }
+
+    PresetManager presets(config);
+    presets.load_presets();
+    std::vector<std::string> preset_list;
+    if (!options.preset_list.empty()) {
+        std::ifstream list(options.preset_list);
+        if (!list.is_open()) {
+            Logger::error("Could not open preset list ", options.preset_list);
+            return 1;
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line[0] != '#') preset_list.push_back(line);
+        }
+    } else {
+        preset_list = presets.get_all_presets();
+        std::sort(preset_list.begin(), preset_list.end());
+        if (preset_list.size() > options.preset_count) preset_list.resize(options.preset_count);
+    }
+    if (preset_list.empty()) {
+        Logger::error("No presets found.");
+        return 1;
+    }
+
+    int max_width = 0, max_height = 0;
+    for (const auto& size : options.resolutions) {
+        max_width = std::max(max_width, size.first);
+        max_height = std::max(max_height, size.second);
+    }
+    HeadlessContext context;
+    if (!context.init(max_width, max_height)) {
+        return 1;
+    }
+    config.width = max_width;
+    config.height = max_height;
+    Renderer renderer;
+    if (!renderer.init(context.window(), context.context(), config)) {
+        return 1;
+    }
+
+    TextRenderer text_renderer;
+    TextManager text_manager(text_renderer);
+    OverlayCompositor overlay(text_renderer);
+    AnimationManager animation(config, text_renderer);
+    const bool wants_overlays = std::find(options.overlays.begin(), options.overlays.end(), true) != options.overlays.end();
+    if (wants_overlays && !(text_renderer.init(config.font_path, config.songInfoFontSize) && overlay.init())) {
+        Logger::warn("Text overlays unavailable (font: ", config.font_path, "); skipping overlay configurations.");
+        options.overlays.erase(std::remove(options.overlays.begin(), options.overlays.end(), true), options.overlays.end());
+    }
+
+    BenchContext bench{config, renderer, text_renderer, text_manager, overlay, animation, presets};
+    std::vector<BenchResult> results;
+    for (const auto& resolution : options.resolutions) {
+        for (const auto& mesh : options.meshes) {
+            for (bool overlays : options.overlays) {
+                for (bool recording : options.recording) {
+                    BenchConfig bench_config{resolution.first, resolution.second, mesh.first, mesh.second, overlays, recording};
+                    std::cerr << resolution.first << "x" << resolution.second << " mesh " << mesh.first << "x"
+                              << mesh.second << (overlays ? " overlays" : "") << (recording ? " recording" : "")
+                              << "..." << std::flush;
+                    results.push_back(run_config(options, bench, bench_config, preset_list));
+                    std::cerr << " " << std::fixed << std::setprecision(1) << results.back().fps << " fps" << std::endl;
+                }
+            }
+        }
+    }
+
+    if (options.out.empty()) {
+        write_report(std::cout, options, preset_list, results);
+    } else {
+        std::ofstream out(options.out);
+        if (!out.is_open()) {
+            Logger::error("Could not open ", options.out);
+            return 1;
+        }
+        write_report(out, options, preset_list, results);
+        std::cerr << "Report: " << options.out << std::endl;
+    }
+
+    overlay.cleanup();
+    text_renderer.cleanup();
+    renderer.cleanup();
+    return 0;
+}
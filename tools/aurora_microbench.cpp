@@ -0,0 +1,333 @@
+// tools/aurora_microbench.cpp
+// Times the CPU-side hot paths in isolation (audio conversion, readback flip, line
+// breaking, text measurement, animation, preset selection, config parsing) and writes
+// a JSON baseline. A previous baseline can be compared against to catch regressions.
+#include "AnimationManager.h"
+#include "Config.h"
+#include "ConfigLoader.h"
+#include "HeadlessContext.h"
+#include "PresetPack.h"
+#include "TextManager.h"
+#include "TextRenderer.h"
+#include "audio_input.h"
+#include "preset_manager.h"
+#include "utils/Logger.h"
+#include "utils/common.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+#ifndef AURORA_DEFAULT_CONFIG
+#define AURORA_DEFAULT_CONFIG "config/default.toml"
+#endif
+
+namespace {
+
+struct MicrobenchOptions {
+    std::string filter;             // Only benchmarks whose name contains this.
+    int samples = 25;               // Timed batches per benchmark.
+    double min_sample_ms = 10.0;    // Each batch runs enough iterations to last this long.
+    std::string config_path = AURORA_DEFAULT_CONFIG;
+    std::string font_path;          // Empty means the config's font_path.
+    std::string out;                // JSON baseline path; stdout if empty.
+    std::string compare;            // Previous baseline to compare against.
+    double threshold = 0.10;        // Median slowdown that counts as a regression.
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void()> body;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    size_t iterations = 0; // Per sample.
+    double median_ns = 0.0;
+    double mad_ns = 0.0;   // Median absolute deviation: robust against the odd preempted sample.
+    double min_ns = 0.0;
+    double mean_ns = 0.0;
+};
+
+// Keeps the compiler from discarding work whose result is otherwise unused.
+template <typename T>
+void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --filter <text>         Only run benchmarks whose name contains <text>\n"
+              << "  --samples <n>           Timed samples per benchmark (default: 25)\n"
+              << "  --min-sample-ms <ms>    Minimum duration of one sample (default: 10)\n"
+              << "  --config <file>         Config parsed by the config benchmark (default: config/default.toml)\n"
+              << "  --font-path <file>      Font for the text benchmarks (default: font_path in the --config file,\n"
+              << "                          else " << Config().font_path << ")\n"
+              << "  --out <path>            JSON baseline (default: stdout)\n"
+              << "  --compare <path>        Compare medians with a previous baseline; exit 1 on a regression\n"
+              << "  --threshold <fraction>  Slowdown that counts as a regression (default: 0.10)\n";
+}
+
+double median(std::vector<double> values) {
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+BenchmarkResult measure(const MicrobenchOptions& options, const Benchmark& benchmark) {
+    using clock = std::chrono::steady_clock;
+    BenchmarkResult result;
+    result.name = benchmark.name;
+
+    // Double the batch until it lasts long enough for the clock; this also warms caches.
+    size_t iterations = 1;
+    for (;;) {
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; ++i) benchmark.body();
+        std::chrono::duration<double, std::milli> elapsed = clock::now() - start;
+        if (elapsed.count() >= options.min_sample_ms || iterations >= (size_t(1) << 30)) break;
+        iterations *= 2;
+    }
+
+    std::vector<double> per_iteration_ns;
+    per_iteration_ns.reserve(options.samples);
+    for (int sample = 0; sample < options.samples; ++sample) {
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; ++i) benchmark.body();
+        std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+        per_iteration_ns.push_back(elapsed.count() / iterations);
+    }
+
+    result.iterations = iterations;
+    result.median_ns = median(per_iteration_ns);
+    std::vector<double> deviations;
+    double total = 0.0;
+    for (double ns : per_iteration_ns) {
+        deviations.push_back(std::abs(ns - result.median_ns));
+        total += ns;
+    }
+    result.mad_ns = median(deviations);
+    result.min_ns = *std::min_element(per_iteration_ns.begin(), per_iteration_ns.end());
+    result.mean_ns = total / per_iteration_ns.size();
+    return result;
+}
+
+void write_baseline(std::ostream& out, const std::vector<BenchmarkResult>& results) {
+    // One benchmark per line, so baselines diff cleanly and read_baseline stays trivial.
+    out << std::fixed << std::setprecision(1) << "{\"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& r = results[i];
+        out << "  {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+            << ", \"median_ns\": " << r.median_ns << ", \"mad_ns\": " << r.mad_ns << ", \"min_ns\": " << r.min_ns
+            << ", \"mean_ns\": " << r.mean_ns << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+}
+
+// Reads name -> median_ns back from a file written by write_baseline.
+bool read_baseline(const std::string& path, std::map<std::string, double>& medians) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        Logger::error("Could not open baseline ", path);
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t name = line.find("\"name\": \"");
+        size_t median_field = line.find("\"median_ns\": ");
+        if (name == std::string::npos || median_field == std::string::npos) continue;
+        name += 9;
+        medians[line.substr(name, line.find('"', name) - name)] = std::stod(line.substr(median_field + 13));
+    }
+    return true;
+}
+
+std::vector<std::string> sample_titles() {
+    const char* artists[] = {"Boards of Canada", "Aphex Twin", "Sigur Rós", "Daft Punk", "坂本龍一", "Bonobo", "Röyksopp", "Burial"};
+    const char* songs[] = {"Roygbiv", "Windowlicker", "Hoppípolla", "Veridis Quo", "Merry Christmas Mr. Lawrence",
+                           "Kong", "Eple", "Archangel", "Music Has the Right to Children (Live at the Warp Records 20th Anniversary)",
+                           "Untitled_Track_07_final_master"};
+    std::vector<std::string> titles;
+    for (const char* artist : artists) {
+        for (const char* song : songs) {
+            titles.push_back(std::string(artist) + " - " + song + ".mp3");
+        }
+    }
+    return titles;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    MicrobenchOptions options;
+    std::vector<std::string> args(argv + 1, argv + argc);
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool has_value = i + 1 < args.size();
+        if (arg == "-h" || arg == "--help") { print_usage(argv[0]); return 0; }
+        else if (arg == "--verbose") { Logger::set_verbose_logging(true); }
+        else if (!has_value) { Logger::error("Missing value or unknown option: ", arg); print_usage(argv[0]); return 1; }
+        else if (arg == "--filter") options.filter = args[++i];
+        else if (arg == "--samples") options.samples = std::max(3, std::stoi(args[++i]));
+        else if (arg == "--min-sample-ms") options.min_sample_ms = std::max(0.1, std::stod(args[++i]));
+        else if (arg == "--config") options.config_path = args[++i];
+        else if (arg == "--font-path") options.font_path = args[++i];
+        else if (arg == "--out") options.out = args[++i];
+        else if (arg == "--compare") options.compare = args[++i];
+        else if (arg == "--threshold") options.threshold = std::stod(args[++i]);
+        else { Logger::error("Unknown option: ", arg); print_usage(argv[0]); return 1; }
+    }
+
+    Config config;
+    ConfigLoader::load_from_file(config, options.config_path);
+    if (!options.font_path.empty()) config.font_path = options.font_path;
+    config.render_width = 1920;
+    config.render_height = 1080;
+
+    fs::path scratch = fs::temp_directory_path() / ("aurora_microbench_" + std::to_string(getpid()));
+    fs::create_directories(scratch);
+
+    std::vector<Benchmark> benchmarks;
+
+    // AudioInput::audio_callback: one 4096-frame stereo mixer buffer.
+    std::vector<int16_t> pcm(4096 * 2);
+    for (size_t i = 0; i < pcm.size(); ++i) pcm[i] = static_cast<int16_t>((i * 7919) % 65536 - 32768);
+    std::vector<float> pcm_float(pcm.size());
+    benchmarks.push_back({"audio_pcm_to_float_4096", [&] {
+        AudioInput::pcm_to_float(pcm.data(), pcm_float.data(), pcm.size());
+        keep(pcm_float);
+    }});
+
+    // Core::run recording path: flipping one 1080p RGB readback.
+    std::vector<unsigned char> frame(1920 * 1080 * 3, 0x5a), flipped(frame.size());
+    benchmarks.push_back({"readback_flip_1080p", [&] {
+        flip_rows(frame.data(), flipped.data(), 1920 * 3, 1080);
+        keep(flipped);
+    }});
+
+    // PresetManager::get_next_preset over a 100k-entry library, served from a generated pack.
+    std::vector<PackSource> sources(100000);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "library/author_%03zu/preset_%06zu.milk", i % 500, i);
+        sources[i].name = name;
+        sources[i].data = "[preset00]\nzoom=1.0\n"; // Stored once; the pack deduplicates contents.
+    }
+    const std::string pack_path = (scratch / "library.aurorapack").string();
+    Config preset_config = config;
+    preset_config.preset_pack_file = pack_path;
+    preset_config.max_preset_complexity = 0.0f;
+    preset_config.favoritesFile = (scratch / "favorites.txt").string();
+    PresetManager presets(preset_config);
+    if (PresetPack::write(pack_path, std::move(sources), false)) {
+        presets.load_presets();
+        benchmarks.push_back({"preset_get_next_100k", [&] { keep(presets.get_next_preset()); }});
+    } else {
+        Logger::warn("Could not write the preset library; skipping preset benchmarks.");
+    }
+
+    // ConfigLoader::load_from_file on the shipped config.
+    if (fs::exists(options.config_path)) {
+        benchmarks.push_back({"config_load_from_file", [&] {
+            Config parsed;
+            ConfigLoader::load_from_file(parsed, options.config_path);
+            keep(parsed);
+        }});
+    } else {
+        Logger::warn("Config ", options.config_path, " not found; skipping the config benchmark.");
+    }
+
+    // The text paths need glyphs, and glyphs need a GL context for their atlas.
+    HeadlessContext context;
+    TextRenderer text_renderer;
+    TextManager text_manager(text_renderer);
+    AnimationManager animation(config, text_renderer);
+    const std::vector<std::string> titles = sample_titles();
+    const std::string title = titles[8]; // Long enough to wrap at 1080p.
+    std::vector<std::string> title_lines;
+    double animation_time = 0.0;
+    if (context.init(64, 64) && text_renderer.init(config.font_path, config.songInfoFontSize)) {
+        text_renderer.setProjection(config.render_width, config.render_height);
+        title_lines = text_manager.split_text(title, config.render_width, 1.0f);
+        animation.reset(title_lines);
+
+        benchmarks.push_back({"text_split_cached", [&] { keep(text_manager.split_text(title, config.render_width, 1.0f)); }});
+        // More titles than the line-break cache holds, so every call breaks lines.
+        size_t next_title = 0;
+        benchmarks.push_back({"text_split_uncached", [&] {
+            keep(text_manager.split_text(titles[next_title++ % titles.size()], config.render_width, 1.0f));
+        }});
+        benchmarks.push_back({"text_get_width", [&] { keep(text_renderer.getTextWidth(title, 1.0f)); }});
+        benchmarks.push_back({"text_get_bounds", [&] { keep(text_renderer.getTextBounds(title, 100.0f, 200.0f, 1.0f)); }});
+        // A three-minute song at 60 fps, looped: covers bouncing, fading and returning.
+        benchmarks.push_back({"animation_update", [&] {
+            animation_time += 1.0 / 60.0;
+            if (animation_time > 180.0) {
+                animation_time = 0.0;
+                animation.reset(title_lines);
+            }
+            animation.update(180.0, animation_time);
+            keep(animation.getTitleBlockPosition());
+        }});
+    } else {
+        Logger::warn("No GL context or font (", config.font_path, "); skipping text and animation benchmarks.");
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (const Benchmark& benchmark : benchmarks) {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos) continue;
+        std::cerr << std::left << std::setw(28) << benchmark.name << std::flush;
+        results.push_back(measure(options, benchmark));
+        const BenchmarkResult& r = results.back();
+        std::cerr << std::right << std::fixed << std::setprecision(1) << std::setw(12) << r.median_ns << " ns  ±"
+                  << std::setw(8) << r.mad_ns << "  (min " << r.min_ns << ")" << std::endl;
+    }
+
+    text_renderer.cleanup();
+    std::error_code ignored;
+    fs::remove_all(scratch, ignored);
+
+    if (options.out.empty()) {
+        write_baseline(std::cout, results);
+    } else {
+        std::ofstream out(options.out);
+        if (!out.is_open()) {
+            Logger::error("Could not open ", options.out);
+            return 1;
+        }
+        write_baseline(out, results);
+    }
+
+    if (options.compare.empty()) {
+        return 0;
+    }
+    std::map<std::string, double> baseline;
+    if (!read_baseline(options.compare, baseline)) {
+        return 1;
+    }
+    int regressions = 0;
+    for (const BenchmarkResult& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0.0) continue;
+        // Noise within two MADs of the new median is not counted against the threshold.
+        const double change = (r.median_ns - 2.0 * r.mad_ns - it->second) / it->second;
+        const bool regressed = change > options.threshold;
+        regressions += regressed;
+        std::cerr << std::left << std::setw(28) << r.name << std::right << std::setprecision(1) << std::setw(12)
+                  << it->second << " -> " << std::setw(12) << r.median_ns << " ns  "
+                  << std::showpos << 100.0 * (r.median_ns - it->second) / it->second << std::noshowpos << "%"
+                  << (regressed ? "  REGRESSION" : "") << std::endl;
+    }
+    return regressions ? 1 : 0;
+}
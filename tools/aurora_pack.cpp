@@ -0,0 +1,152 @@
+// tools/aurora_pack.cpp
+// Builds, updates and lists aurora-pack files (see include/PresetPack.h).
+#include "PresetPack.h"
+#include "utils/common.h"
+#include "utils/Logger.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static void print_usage(const char* program) {
+    std::cout << "Usage:\n"
+              << "  " << program << " build <preset_dir> <pack_file> [--no-compress]\n"
+              << "  " << program << " update <pack_file> <preset_dir> [--prune] [--no-compress]\n"
+              << "  " << program << " list <pack_file>\n";
+}
+
+// Reads every .milk file under `directory`, keyed by its path relative to the directory.
+static bool read_directory(const std::string& directory, std::map<std::string, std::string>& presets) {
+    try {
+        for (const auto& entry : fs::recursive_directory_iterator(directory)) {
+            if (!entry.is_regular_file() || entry.path().extension() != ".milk") {
+                continue;
+            }
+            std::ifstream file(entry.path(), std::ios::binary);
+            if (!file.is_open()) {
+                Logger::warn("Skipping unreadable preset: ", entry.path().string());
+                continue;
+            }
+            std::string name = fs::relative(entry.path(), directory).generic_string();
+            presets[name].assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+    } catch (const fs::filesystem_error& e) {
+        Logger::error("Error reading presets directory: ", e.what());
+        return false;
+    }
+    return true;
+}
+
+static std::vector<PackSource> to_sources(std::map<std::string, std::string>& presets) {
+    std::vector<PackSource> sources;
+    sources.reserve(presets.size());
+    for (auto& [name, data] : presets) {
+        sources.push_back({name, std::move(data)});
+    }
+    return sources;
+}
+
+static int build(const std::string& directory, const std::string& pack_path, bool compress) {
+    std::map<std::string, std::string> presets;
+    if (!read_directory(directory, presets)) {
+        return 1;
+    }
+    size_t count = presets.size();
+    if (!PresetPack::write(pack_path, to_sources(presets), compress)) {
+        return 1;
+    }
+    std::cout << "Packed " << count << " presets into " << pack_path << std::endl;
+    return 0;
+}
+
+static int update(const std::string& pack_path, const std::string& directory, bool prune, bool compress) {
+    std::map<std::string, std::string> presets;
+    PresetPack pack;
+    if (fs::exists(pack_path)) {
+        if (!pack.open(pack_path)) {
+            return 1;
+        }
+        if (!prune) {
+            for (size_t i = 0; i < pack.size(); ++i) {
+                std::string data;
+                if (!pack.read(i, data)) {
+                    Logger::warn("Dropping corrupt pack entry: ", pack.name_at(i));
+                    continue;
+                }
+                presets[std::string(pack.name_at(i))] = std::move(data);
+            }
+        }
+    }
+
+    std::map<std::string, std::string> on_disk;
+    if (!read_directory(directory, on_disk)) {
+        return 1;
+    }
+    size_t added = 0, changed = 0;
+    for (auto& [name, data] : on_disk) {
+        long existing = pack.is_open() ? pack.find(name) : -1;
+        if (existing < 0) {
+            added++;
+        } else if (pack.hash_at(existing) != fnv1a_64(data.data(), data.size())) {
+            changed++;
+        }
+        presets[name] = std::move(data);
+    }
+    size_t previous = pack.size();
+    pack.close();
+
+    size_t count = presets.size();
+    if (!PresetPack::write(pack_path, to_sources(presets), compress)) {
+        return 1;
+    }
+    std::cout << "Updated " << pack_path << ": " << added << " added, " << changed << " changed, "
+              << count << " total (was " << previous << ")" << std::endl;
+    return 0;
+}
+
+static int list(const std::string& pack_path) {
+    PresetPack pack;
+    if (!pack.open(pack_path)) {
+        return 1;
+    }
+    for (size_t i = 0; i < pack.size(); ++i) {
+        std::cout << std::hex << pack.hash_at(i) << std::dec << "  " << pack.name_at(i) << "\n";
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    bool compress = true;
+    bool prune = false;
+    std::vector<std::string> positional;
+    for (const auto& arg : args) {
+        if (arg == "--no-compress") {
+            compress = false;
+        } else if (arg == "--prune") {
+            prune = true;
+        } else if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() == 3 && positional[0] == "build") {
+        return build(positional[1], positional[2], compress);
+    }
+    if (positional.size() == 3 && positional[0] == "update") {
+        return update(positional[1], positional[2], prune, compress);
+    }
+    if (positional.size() == 2 && positional[0] == "list") {
+        return list(positional[1]);
+    }
+    print_usage(argv[0]);
+    return 1;
+}
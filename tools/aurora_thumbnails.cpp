@@ -0,0 +1,299 @@
+// tools/aurora_thumbnails.cpp
+// Renders a small still preview of every preset through the Renderer FBO path and
+// caches it as <cache-dir>/<content hash>.png. Presets whose contents have not
+// changed since the last run are skipped.
+#include "AudioFeed.h"
+#include "Config.h"
+#include "HeadlessContext.h"
+#include "ProcessPool.h"
+#include "SyntheticAudio.h"
+#include "audio_input.h"
+#include "preset_manager.h"
+#include "renderer.h"
+#include "utils/Logger.h"
+#include "utils/PngWriter.h"
+#include "utils/common.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct ThumbnailOptions {
+    int width = 160;
+    int height = 90;
+    int supersample = 2; // Render at N times the size and box-filter down.
+    int fps = 30;
+    double seconds = 3.0;
+    size_t chunk_size = 32;
+    unsigned int jobs = 0;
+    double idle_timeout = 20.0;
+    std::string audio = "mix";
+    std::string cache_dir = "thumbnails";
+};
+
+enum class ThumbnailState { PENDING, DONE, FAILED, CRASHED };
+
+void print_usage(const char* program) {
+    // No config file is read, so the defaults shown are Config's built-in ones.
+    const Config defaults;
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --presets-directory <dir>  Presets to render (default: " << defaults.presetsDirectory << ")\n"
+              << "  --preset-pack <file>       Render the presets in an aurora-pack file instead\n"
+              << "  --width <px> --height <px> Thumbnail size (default: 160x90)\n"
+              << "  --supersample <n>          Render at n times the size and downscale (default: 2)\n"
+              << "  --seconds <sec>            How long each preset runs before capture (default: 3)\n"
+              << "  --fps <value>              Frame rate the preset is run at (default: 30)\n"
+              << "  --audio <sweep|pink|kick|mix|file>  Audio feed (default: mix)\n"
+              << "  --jobs <n>                 Worker processes (default: one per core)\n"
+              << "  --chunk-size <n>           Presets per worker process (default: 32)\n"
+              << "  --cache-dir <dir>          Output directory (default: thumbnails)\n";
+}
+
+std::string hash_name(uint64_t hash) {
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return buffer;
+}
+
+// Averages each factor x factor block of `source` into one pixel of `dest`.
+void downsample(const std::vector<unsigned char>& source, int factor, int width, int height, std::vector<unsigned char>& dest) {
+    const int source_width = width * factor;
+    const int samples = factor * factor;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                int sum = 0;
+                for (int sy = 0; sy < factor; ++sy) {
+                    for (int sx = 0; sx < factor; ++sx) {
+                        sum += source[((y * factor + sy) * source_width + (x * factor + sx)) * 3 + c];
+                    }
+                }
+                dest[(y * width + x) * 3 + c] = static_cast<unsigned char>(sum / samples);
+            }
+        }
+    }
+}
+
+int render_chunk(const ThumbnailOptions& options, PresetManager& presets, const std::vector<size_t>& chunk,
+                 const std::vector<std::string>& output_paths, const std::vector<int16_t>& pcm, int output_fd) {
+    const int render_width = options.width * options.supersample;
+    const int render_height = options.height * options.supersample;
+
+    HeadlessContext context;
+    if (!context.init(render_width, render_height)) {
+        return 2;
+    }
+    Config config;
+    config.width = render_width;
+    config.height = render_height;
+    Renderer renderer;
+    if (!renderer.init(context.window(), context.context(), config)) {
+        return 2;
+    }
+    projectm_handle pM = projectm_create();
+    if (!pM) {
+        return 2;
+    }
+    projectm_set_window_size(pM, render_width, render_height);
+    projectm_set_mesh_size(pM, 48, 32);
+    projectm_set_preset_locked(pM, true);
+
+    const int frames = std::max(1, static_cast<int>(options.seconds * options.fps));
+    std::vector<unsigned char> pixels(static_cast<size_t>(render_width) * render_height * 3);
+    std::vector<unsigned char> thumbnail(static_cast<size_t>(options.width) * options.height * 3);
+    const auto& all_presets = presets.get_all_presets();
+
+    for (size_t index : chunk) {
+        // Announce the preset first so the parent can blame it if this process crashes or hangs.
+        ProcessPool::write_all(output_fd, "BEGIN\t" + std::to_string(index) + "\n");
+        // Each preset hears the same audio from the start, so thumbnails are reproducible.
+        AudioFeed audio(options.audio, pcm, options.fps);
+        if (!presets.load_preset(pM, all_presets[index], false)) {
+            ProcessPool::write_all(output_fd, "FAILED\t" + std::to_string(index) + "\n");
+            continue;
+        }
+        for (int frame = 0; frame < frames; ++frame) {
+            audio.feed(pM);
+            renderer.render(pM);
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, renderer.get_fbo());
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, render_width, render_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+        const std::vector<unsigned char>* image = &pixels;
+        if (options.supersample > 1) {
+            downsample(pixels, options.supersample, options.width, options.height, thumbnail);
+            image = &thumbnail;
+        }
+        // Write then rename, so an interrupted run never leaves a truncated file in the cache.
+        const std::string& path = output_paths[index];
+        std::string temp_path = path + ".tmp";
+        const bool written = write_png(temp_path, image->data(), options.width, options.height, true) &&
+                             std::rename(temp_path.c_str(), path.c_str()) == 0;
+        ProcessPool::write_all(output_fd, (written ? "DONE\t" : "FAILED\t") + std::to_string(index) + "\n");
+    }
+
+    projectm_destroy(pM);
+    renderer.cleanup();
+    return 0;
+}
+
+// Applies a worker's output to `states`. Returns the index of the preset it was on when it died, if any.
+long collect(const ProcessJobResult& job, std::vector<ThumbnailState>& states) {
+    long in_flight = -1;
+    std::istringstream lines(job.output);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::istringstream fields(line);
+        std::string kind;
+        size_t index;
+        fields >> kind >> index;
+        if (!fields || index >= states.size()) continue;
+        if (kind == "BEGIN") {
+            in_flight = static_cast<long>(index);
+        } else if (kind == "DONE" || kind == "FAILED") {
+            states[index] = kind == "DONE" ? ThumbnailState::DONE : ThumbnailState::FAILED;
+            in_flight = -1;
+        }
+    }
+    return in_flight;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Config config;
+    ThumbnailOptions options;
+    std::vector<std::string> args(argv + 1, argv + argc);
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool has_value = i + 1 < args.size();
+        if (arg == "-h" || arg == "--help") { print_usage(argv[0]); return 0; }
+        else if (arg == "--verbose") { Logger::set_verbose_logging(true); }
+        else if (!has_value) { Logger::error("Missing value or unknown option: ", arg); print_usage(argv[0]); return 1; }
+        else if (arg == "--presets-directory") config.presetsDirectory = args[++i];
+        else if (arg == "--preset-pack") config.preset_pack_file = args[++i];
+        else if (arg == "--width") options.width = std::max(1, std::stoi(args[++i]));
+        else if (arg == "--height") options.height = std::max(1, std::stoi(args[++i]));
+        else if (arg == "--supersample") options.supersample = std::max(1, std::stoi(args[++i]));
+        else if (arg == "--seconds") options.seconds = std::stod(args[++i]);
+        else if (arg == "--fps") options.fps = std::max(1, std::stoi(args[++i]));
+        else if (arg == "--audio") options.audio = args[++i];
+        else if (arg == "--jobs") options.jobs = std::stoul(args[++i]);
+        else if (arg == "--chunk-size") options.chunk_size = std::max(1ul, std::stoul(args[++i]));
+        else if (arg == "--cache-dir") options.cache_dir = args[++i];
+        else { Logger::error("Unknown option: ", arg); print_usage(argv[0]); return 1; }
+    }
+
+    // Nothing here may initialize SDL video or OpenGL: workers are forked from this process.
+    PresetManager presets(config);
+    presets.load_presets();
+    const auto& all_presets = presets.get_all_presets();
+    if (all_presets.empty()) {
+        Logger::error("No presets found.");
+        return 1;
+    }
+    fs::create_directories(options.cache_dir);
+
+    std::vector<int16_t> pcm;
+    SyntheticSignal signal;
+    if (!SyntheticAudio::parse_signal(options.audio, signal)) {
+        if (!AudioInput::decode_file(options.audio, pcm)) {
+            return 1;
+        }
+        SDL_Quit();
+    }
+
+    // The cache key covers the preset contents and everything that changes the picture.
+    std::ostringstream settings;
+    settings << options.width << "x" << options.height << "/" << options.supersample << "/" << options.seconds
+             << "/" << options.fps << "/" << options.audio;
+    const std::string settings_key = settings.str();
+
+    std::vector<std::string> output_paths(all_presets.size());
+    std::vector<size_t> missing;
+    std::string data;
+    for (size_t i = 0; i < all_presets.size(); ++i) {
+        if (!presets.read_preset_data(all_presets[i], data)) {
+            continue;
+        }
+        data += settings_key;
+        output_paths[i] = (fs::path(options.cache_dir) / (hash_name(fnv1a_64(data.data(), data.size())) + ".png")).string();
+        if (!fs::exists(output_paths[i])) {
+            missing.push_back(i);
+        }
+    }
+    std::cout << missing.size() << " of " << all_presets.size() << " thumbnails need rendering." << std::endl;
+
+    std::vector<ThumbnailState> states(all_presets.size(), ThumbnailState::PENDING);
+    std::vector<size_t> pending = missing;
+    auto start = std::chrono::steady_clock::now();
+    size_t rendered = 0;
+    // As in aurora_triage, a preset that crashes or hangs its worker is skipped and the
+    // rest of its chunk is retried in the next round.
+    while (!pending.empty()) {
+        std::vector<std::vector<size_t>> chunks;
+        for (size_t i = 0; i < pending.size(); i += options.chunk_size) {
+            chunks.emplace_back(pending.begin() + i, pending.begin() + std::min(pending.size(), i + options.chunk_size));
+        }
+        ProcessPool::run(
+            chunks.size(), options.jobs,
+            [&](size_t job, int fd) { return render_chunk(options, presets, chunks[job], output_paths, pcm, fd); },
+            [&](const ProcessJobResult& job) {
+                long in_flight = collect(job, states);
+                if (in_flight >= 0) {
+                    states[in_flight] = ThumbnailState::CRASHED;
+                    Logger::warn(job.timed_out ? "Preset hung its worker: " : "Preset crashed its worker: ",
+                                 all_presets[in_flight]);
+                } else if (job.exit_code != 0) {
+                    // The worker failed before reaching any preset (e.g. no GL context); give up on the chunk.
+                    for (size_t index : chunks[job.job]) {
+                        if (states[index] == ThumbnailState::PENDING) states[index] = ThumbnailState::FAILED;
+                    }
+                }
+                rendered = std::count(states.begin(), states.end(), ThumbnailState::DONE);
+                std::cout << "\r" << rendered << " rendered" << std::flush;
+            },
+            options.idle_timeout);
+
+        std::vector<size_t> still_pending;
+        for (size_t index : pending) {
+            if (states[index] == ThumbnailState::PENDING) still_pending.push_back(index);
+        }
+        if (still_pending.size() == pending.size()) {
+            break; // No progress; avoid retrying forever.
+        }
+        pending.swap(still_pending);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << std::endl;
+
+    // index.tsv maps preset names to their current thumbnail for preset browsers.
+    std::ofstream index((fs::path(options.cache_dir) / "index.tsv").string());
+    index << "# preset\tthumbnail\n";
+    for (size_t i = 0; i < all_presets.size(); ++i) {
+        if (!output_paths[i].empty() && fs::exists(output_paths[i])) {
+            index << all_presets[i] << "\t" << fs::path(output_paths[i]).filename().string() << "\n";
+        }
+    }
+
+    const size_t crashed = std::count(states.begin(), states.end(), ThumbnailState::CRASHED);
+    std::cout << "Rendered " << rendered << " thumbnails in " << elapsed.count() << "s";
+    if (rendered < missing.size()) {
+        std::cout << " (" << missing.size() - rendered << " failed, " << crashed
+                  << " of them by crashing or hanging; all are tried again on the next run)";
+    }
+    std::cout << "." << std::endl;
+    return 0;
+}
@@ -0,0 +1,339 @@
+// tools/aurora_triage.cpp
+// Loads every preset headlessly, renders a fixed number of frames with synthetic or
+// real audio, and writes a quarantine list and a cost report for PresetManager.
+#include "AudioFeed.h"
+#include "Config.h"
+#include "HeadlessContext.h"
+#include "ProcessPool.h"
+#include "SyntheticAudio.h"
+#include "audio_input.h"
+#include "preset_manager.h"
+#include "renderer.h"
+#include "utils/Logger.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TriageOptions {
+    int width = 640;
+    int height = 360;
+    int fps = 30;
+    int frames = 150;
+    int warmup_frames = 10;
+    int sample_interval = 15; // Read back every Nth frame for black/frozen checks.
+    size_t chunk_size = 32;
+    unsigned int jobs = 0;
+    double idle_timeout = 20.0;
+    std::string audio = "mix"; // Synthetic signal name or an audio file path.
+    std::string quarantine_out = "preset_quarantine.txt";
+    std::string report_out = "preset_costs.tsv";
+};
+
+struct PresetResult {
+    std::string status = "pending";
+    double mean_ms = 0.0;
+    double p95_ms = 0.0;
+    double max_ms = 0.0;
+    int gl_errors = 0;
+};
+
+// Set from projectM's preset-switch-failed callback while a preset loads.
+bool g_load_failed = false;
+
+void on_preset_switch_failed(const char*, const char* message, void*) {
+    g_load_failed = true;
+    Logger::debug("Preset failed to load: ", (message ? message : ""));
+}
+
+void print_usage(const char* program) {
+    // No config file is read, so the defaults shown are Config's built-in ones.
+    const Config defaults;
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --presets-directory <dir>  Presets to check (default: " << defaults.presetsDirectory << ")\n"
+              << "  --preset-pack <file>       Check the presets in an aurora-pack file instead\n"
+              << "  --width <px> --height <px> Render resolution (default: 640x360)\n"
+              << "  --fps <value>              Audio samples are fed at this frame rate (default: 30)\n"
+              << "  --frames <n>               Frames rendered per preset (default: 150)\n"
+              << "  --audio <sweep|pink|kick|mix|file>  Audio feed (default: mix)\n"
+              << "  --jobs <n>                 Worker processes (default: one per core)\n"
+              << "  --chunk-size <n>           Presets per worker process (default: 32)\n"
+              << "  --idle-timeout <sec>       Kill a worker stuck on one preset (default: 20)\n"
+              << "  --quarantine-out <path>    Quarantine list (default: preset_quarantine.txt)\n"
+              << "  --report-out <path>        Cost report (default: preset_costs.tsv)\n";
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+PresetResult triage_preset(const TriageOptions& options, PresetManager& presets, const std::string& preset,
+                           projectm_handle pM, Renderer& renderer, AudioFeed& audio) {
+    PresetResult result;
+    while (glGetError() != GL_NO_ERROR) {
+    }
+
+    g_load_failed = false;
+    if (!presets.load_preset(pM, preset, false) || g_load_failed) {
+        result.status = "load_failed";
+        return result;
+    }
+
+    const size_t frame_bytes = static_cast<size_t>(options.width) * options.height * 3;
+    std::vector<unsigned char> pixels(frame_bytes), previous(frame_bytes);
+    bool have_previous = false;
+    bool all_black = true;
+    bool all_frozen = true;
+    std::vector<double> frame_ms;
+    frame_ms.reserve(options.frames);
+
+    for (int frame = 0; frame < options.frames; ++frame) {
+        audio.feed(pM);
+        auto start = std::chrono::steady_clock::now();
+        renderer.render(pM);
+        glFinish();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (frame >= options.warmup_frames) {
+            frame_ms.push_back(elapsed.count());
+        }
+        while (glGetError() != GL_NO_ERROR) {
+            result.gl_errors++;
+        }
+        if (g_load_failed) {
+            result.status = "load_failed";
+            return result;
+        }
+
+        if (frame < options.warmup_frames || (frame - options.warmup_frames) % options.sample_interval != 0) {
+            continue;
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, renderer.get_fbo());
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, options.width, options.height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+        unsigned char brightest = *std::max_element(pixels.begin(), pixels.end());
+        if (brightest > 8) {
+            all_black = false;
+        }
+        if (have_previous) {
+            uint64_t difference = 0;
+            for (size_t i = 0; i < frame_bytes; ++i) {
+                difference += std::abs(static_cast<int>(pixels[i]) - static_cast<int>(previous[i]));
+            }
+            // Mean per-channel change below 1/4 of a level counts as no motion.
+            if (difference * 4 >= frame_bytes) {
+                all_frozen = false;
+            }
+        }
+        previous.swap(pixels);
+        have_previous = true;
+    }
+
+    if (!frame_ms.empty()) {
+        double total = 0.0;
+        for (double ms : frame_ms) total += ms;
+        result.mean_ms = total / frame_ms.size();
+        result.p95_ms = percentile(frame_ms, 0.95);
+        result.max_ms = *std::max_element(frame_ms.begin(), frame_ms.end());
+    }
+
+    if (result.gl_errors > 0) result.status = "gl_error";
+    else if (all_black) result.status = "black";
+    else if (all_frozen && have_previous) result.status = "frozen";
+    else result.status = "ok";
+    return result;
+}
+
+// Worker process body: renders a chunk of presets and streams one line per preset.
+int run_chunk(const TriageOptions& options, PresetManager& presets, const std::vector<size_t>& chunk,
+              const std::vector<int16_t>& pcm, int output_fd) {
+    HeadlessContext context;
+    if (!context.init(options.width, options.height)) {
+        return 2;
+    }
+    Config config;
+    config.width = options.width;
+    config.height = options.height;
+    Renderer renderer;
+    if (!renderer.init(context.window(), context.context(), config)) {
+        return 2;
+    }
+
+    projectm_handle pM = projectm_create();
+    if (!pM) {
+        return 2;
+    }
+    projectm_set_window_size(pM, options.width, options.height);
+    projectm_set_mesh_size(pM, 64, 48);
+    projectm_set_preset_locked(pM, true);
+    projectm_set_preset_switch_failed_event_callback(pM, on_preset_switch_failed, nullptr);
+    AudioFeed audio(options.audio, pcm, options.fps);
+
+    const auto& all_presets = presets.get_all_presets();
+    for (size_t index : chunk) {
+        // Announce the preset first so the parent can blame it if this process crashes.
+        ProcessPool::write_all(output_fd, "BEGIN\t" + std::to_string(index) + "\n");
+        PresetResult result = triage_preset(options, presets, all_presets[index], pM, renderer, audio);
+        std::ostringstream line;
+        line << "RESULT\t" << index << "\t" << result.status << "\t" << result.mean_ms << "\t" << result.p95_ms
+             << "\t" << result.max_ms << "\t" << result.gl_errors << "\n";
+        ProcessPool::write_all(output_fd, line.str());
+    }
+
+    projectm_destroy(pM);
+    renderer.cleanup();
+    return 0;
+}
+
+// Applies a worker's output to `results`. Returns the index of the preset it was on when it died, if any.
+long collect(const ProcessJobResult& job, std::vector<PresetResult>& results) {
+    long in_flight = -1;
+    std::istringstream lines(job.output);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::istringstream fields(line);
+        std::string kind;
+        size_t index;
+        fields >> kind >> index;
+        if (!fields || index >= results.size()) continue;
+        if (kind == "BEGIN") {
+            in_flight = static_cast<long>(index);
+        } else if (kind == "RESULT") {
+            PresetResult& r = results[index];
+            fields >> r.status >> r.mean_ms >> r.p95_ms >> r.max_ms >> r.gl_errors;
+            in_flight = -1;
+        }
+    }
+    return in_flight;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Config config;
+    TriageOptions options;
+    std::vector<std::string> args(argv + 1, argv + argc);
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool has_value = i + 1 < args.size();
+        if (arg == "-h" || arg == "--help") { print_usage(argv[0]); return 0; }
+        else if (arg == "--verbose") { Logger::set_verbose_logging(true); }
+        else if (!has_value) { Logger::error("Missing value or unknown option: ", arg); print_usage(argv[0]); return 1; }
+        else if (arg == "--presets-directory") config.presetsDirectory = args[++i];
+        else if (arg == "--preset-pack") config.preset_pack_file = args[++i];
+        else if (arg == "--width") options.width = std::stoi(args[++i]);
+        else if (arg == "--height") options.height = std::stoi(args[++i]);
+        else if (arg == "--fps") options.fps = std::max(1, std::stoi(args[++i]));
+        else if (arg == "--frames") options.frames = std::stoi(args[++i]);
+        else if (arg == "--audio") options.audio = args[++i];
+        else if (arg == "--jobs") options.jobs = std::stoul(args[++i]);
+        else if (arg == "--chunk-size") options.chunk_size = std::max(1ul, std::stoul(args[++i]));
+        else if (arg == "--idle-timeout") options.idle_timeout = std::stod(args[++i]);
+        else if (arg == "--quarantine-out") options.quarantine_out = args[++i];
+        else if (arg == "--report-out") options.report_out = args[++i];
+        else { Logger::error("Unknown option: ", arg); print_usage(argv[0]); return 1; }
+    }
+    options.warmup_frames = std::min(options.warmup_frames, options.frames / 2);
+
+    // Nothing here may initialize SDL video or OpenGL: workers are forked from this process.
+    PresetManager presets(config);
+    presets.load_presets();
+    const auto& all_presets = presets.get_all_presets();
+    if (all_presets.empty()) {
+        Logger::error("No presets found.");
+        return 1;
+    }
+
+    std::vector<int16_t> pcm;
+    SyntheticSignal signal;
+    if (!SyntheticAudio::parse_signal(options.audio, signal)) {
+        if (!AudioInput::decode_file(options.audio, pcm)) {
+            return 1;
+        }
+        SDL_Quit();
+    }
+
+    std::vector<PresetResult> results(all_presets.size());
+    std::vector<size_t> pending(all_presets.size());
+    for (size_t i = 0; i < pending.size(); ++i) pending[i] = i;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t completed = 0;
+    // A crash only costs the rest of its chunk, which is retried in the next round.
+    while (!pending.empty()) {
+        std::vector<std::vector<size_t>> chunks;
+        for (size_t i = 0; i < pending.size(); i += options.chunk_size) {
+            chunks.emplace_back(pending.begin() + i, pending.begin() + std::min(pending.size(), i + options.chunk_size));
+        }
+
+        ProcessPool::run(
+            chunks.size(), options.jobs,
+            [&](size_t job, int fd) { return run_chunk(options, presets, chunks[job], pcm, fd); },
+            [&](const ProcessJobResult& job) {
+                long in_flight = collect(job, results);
+                if (in_flight >= 0) {
+                    results[in_flight].status = job.timed_out ? "timeout" : "crashed";
+                } else if (job.exit_code != 0) {
+                    // The worker failed before reaching any preset (e.g. no GL context); give up on the chunk.
+                    for (size_t index : chunks[job.job]) {
+                        if (results[index].status == "pending") results[index].status = "worker_failed";
+                    }
+                }
+                completed += chunks[job.job].size();
+                std::cout << "\r" << completed << " presets checked" << std::flush;
+            },
+            options.idle_timeout);
+
+        std::vector<size_t> still_pending;
+        for (size_t index : pending) {
+            if (results[index].status == "pending") still_pending.push_back(index);
+        }
+        if (still_pending.size() == pending.size()) {
+            break; // No progress; avoid retrying forever.
+        }
+        completed -= still_pending.size();
+        pending.swap(still_pending);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << std::endl;
+
+    std::ofstream quarantine(options.quarantine_out);
+    std::ofstream report(options.report_out);
+    if (!quarantine.is_open() || !report.is_open()) {
+        Logger::error("Could not open the output files.");
+        return 1;
+    }
+    quarantine << "# aurora_triage quarantine list: preset<TAB>reason\n";
+    report << "# preset\tstatus\tmean_ms\tp95_ms\tmax_ms\tgl_errors\n";
+    size_t quarantined = 0;
+    for (size_t i = 0; i < all_presets.size(); ++i) {
+        const PresetResult& r = results[i];
+        if (r.status != "ok") {
+            quarantine << all_presets[i] << "\t" << r.status << "\n";
+            quarantined++;
+        }
+        report << all_presets[i] << "\t" << r.status << "\t";
+        if (r.status == "ok" || r.status == "black" || r.status == "frozen" || r.status == "gl_error") {
+            report << r.mean_ms << "\t" << r.p95_ms << "\t" << r.max_ms;
+        } else {
+            report << "-\t-\t-";
+        }
+        report << "\t" << r.gl_errors << "\n";
+    }
+
+    std::cout << "Checked " << all_presets.size() << " presets in " << elapsed.count() << "s, quarantined "
+              << quarantined << ".\n"
+              << "Quarantine list: " << options.quarantine_out << "\nCost report: " << options.report_out << std::endl;
+    return 0;
+}